@@ -10,7 +10,6 @@
 using namespace std;
 
 void bidirectional_stream_copy(Socket &socket) {
-    constexpr size_t max_copy_length = 65536;
     constexpr size_t buffer_size = 1048576;
 
     EventLoop _eventloop{};
@@ -30,7 +29,7 @@ void bidirectional_stream_copy(Socket &socket) {
         _input,
         Direction::In,
         [&] {
-            _outbound.write(_input.read(_outbound.remaining_capacity()));
+            _outbound.commit_write(_input.read(_outbound.writable_spans()));
             if (_input.eof()) {
                 _outbound.end_input();
             }
@@ -42,8 +41,8 @@ void bidirectional_stream_copy(Socket &socket) {
     _eventloop.add_rule(socket,
                         Direction::Out,
                         [&] {
-                            const size_t bytes_to_write = min(max_copy_length, _outbound.buffer_size());
-                            const size_t bytes_written = socket.write(_outbound.peek_output(bytes_to_write), false);
+                            const size_t bytes_written =
+                                socket.write(_outbound.peek_spans(_outbound.buffer_size()), false);
                             _outbound.pop_output(bytes_written);
                             if (_outbound.eof()) {
                                 socket.shutdown(SHUT_WR);
@@ -58,7 +57,7 @@ void bidirectional_stream_copy(Socket &socket) {
         socket,
         Direction::In,
         [&] {
-            _inbound.write(socket.read(_inbound.remaining_capacity()));
+            _inbound.commit_write(socket.read(_inbound.writable_spans()));
             if (socket.eof()) {
                 _inbound.end_input();
             }
@@ -70,8 +69,8 @@ void bidirectional_stream_copy(Socket &socket) {
     _eventloop.add_rule(_output,
                         Direction::Out,
                         [&] {
-                            const size_t bytes_to_write = min(max_copy_length, _inbound.buffer_size());
-                            const size_t bytes_written = _output.write(_inbound.peek_output(bytes_to_write), false);
+                            const size_t bytes_written =
+                                _output.write(_inbound.peek_spans(_inbound.buffer_size()), false);
                             _inbound.pop_output(bytes_written);
 
                             if (_inbound.eof()) {
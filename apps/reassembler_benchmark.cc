@@ -0,0 +1,87 @@
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t fragment_count = 100000;
+constexpr size_t fragment_len = 16;
+
+//! Push every fragment (in the given order) into a fresh reassembler, asking for
+//! unassembled_bytes() after each one as TCPReceiver's owner would, and report the time taken.
+void main_loop(const StreamReassembler::Tracker tracker,
+               const string &name,
+               const string &order,
+               const string &stream,
+               const vector<size_t> &fragments) {
+    StreamReassembler reassembler{stream.size(), ByteStream::Storage::Ring, tracker};
+
+    const auto first_time = steady_clock::now();
+    size_t unassembled = 0;
+    for (const size_t fragment : fragments) {
+        const size_t index = fragment * fragment_len;
+        reassembler.push_substring(stream.substr(index, fragment_len), index, index + fragment_len == stream.size());
+        unassembled = max(unassembled, reassembler.unassembled_bytes());
+    }
+    const auto final_time = steady_clock::now();
+
+    if (reassembler.stream_out().read(stream.size()) != stream or not reassembler.stream_out().eof()) {
+        throw runtime_error("reassembled stream does not match");
+    }
+
+    const auto duration = duration_cast<microseconds>(final_time - first_time).count();
+    cout << fixed << setprecision(1);
+    cout << name << " tracker, " << order << ": " << duration / 1000.0 << " ms ("
+         << duration * 1000.0 / fragments.size() << " ns per fragment, at most " << unassembled
+         << " bytes unassembled)\n";
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        string stream(fragment_count * fragment_len, 0);
+        generate(stream.begin(), stream.end(), [&] { return rd(); });
+
+        // every other fragment first, leaving a hole between each, then the rest
+        vector<size_t> alternating;
+        for (size_t i = 1; i < fragment_count; i += 2) {
+            alternating.push_back(i);
+        }
+        for (size_t i = 0; i < fragment_count; i += 2) {
+            alternating.push_back(i);
+        }
+
+        // back to front
+        vector<size_t> reversed(fragment_count);
+        for (size_t i = 0; i < fragment_count; i++) {
+            reversed[i] = fragment_count - 1 - i;
+        }
+
+        vector<size_t> shuffled(reversed);
+        shuffle(shuffled.begin(), shuffled.end(), rd);
+
+        cout << fragment_count << " fragments of " << fragment_len << " bytes:\n";
+        for (const auto &[tracker, name] : {make_pair(StreamReassembler::Tracker::List, "list        "),
+                                            make_pair(StreamReassembler::Tracker::IntervalMap, "interval map"),
+                                            make_pair(StreamReassembler::Tracker::Bitmap, "bitmap      ")}) {
+            main_loop(tracker, name, "alternating", stream, alternating);
+            main_loop(tracker, name, "reversed   ", stream, reversed);
+            main_loop(tracker, name, "shuffled   ", stream, shuffled);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
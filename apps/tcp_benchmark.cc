@@ -1,15 +1,24 @@
 #include "tcp_connection.hh"
 
+#include <algorithm>
 #include <chrono>
+#include <deque>
 #include <cstdlib>
 #include <iomanip>
 #include <iostream>
+#include <limits>
+#include <optional>
+#include <random>
 #include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 using namespace std;
 using namespace std::chrono;
 
 constexpr size_t len = 100 * 1024 * 1024;
+constexpr size_t lossy_len = 10 * 1024 * 1024;
 
 void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segments, const bool reorder) {
     while (not x.segments_out().empty()) {
@@ -28,8 +37,35 @@ void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segme
     segments.clear();
 }
 
-void main_loop(const bool reorder) {
+//! \brief Deliver x's segments to y in order, dropping those for which `lost` draws true
+void lossy_move_segments(TCPConnection &x, TCPConnection &y, bernoulli_distribution &lost, mt19937 &rng) {
+    while (not x.segments_out().empty()) {
+        if (not lost(rng)) {
+            y.segment_received(move(x.segments_out().front()));
+        }
+        x.segments_out().pop();
+    }
+}
+
+string storage_name(const ByteStream::Storage storage) {
+    switch (storage) {
+        case ByteStream::Storage::Chunked:
+            return " (chunked) ";
+        case ByteStream::Storage::Mirrored:
+            return " (mirrored)";
+        case ByteStream::Storage::Paged:
+            return " (paged)   ";
+        case ByteStream::Storage::Ring:
+        default:
+            return " (ring)    ";
+    }
+}
+
+void main_loop(const bool reorder, const ByteStream::Storage storage, const bool offload = false) {
     TCPConfig config;
+    config.send_storage = storage;
+    config.recv_storage = storage;
+    config.segmentation_offload = offload;
     TCPConnection x{config}, y{config};
 
     string string_to_send(len, 'x');
@@ -95,18 +131,730 @@ void main_loop(const bool reorder) {
     const auto gigabits_per_second = len * 8.0 / double(duration);
 
     cout << fixed << setprecision(2);
-    cout << "CPU-limited throughput" << (reorder ? " with reordering: " : "                : ") << gigabits_per_second
-         << " Gbit/s\n";
+    cout << "CPU-limited throughput" << storage_name(storage)
+         << (reorder ? " with reordering: " : offload ? " with offload:    " : "                : ")
+         << gigabits_per_second << " Gbit/s\n";
+
+    while (x.active() or y.active()) {
+        loop();
+    }
+}
+
+//! How the lossy transfer recovers from losses
+enum class Recovery { Timeouts, FastRetransmit, Sack };
+
+//! \brief Transfer over a link that drops segments in both directions, one millisecond of simulated time per
+//! exchange, drawing the losses from a generator with the given seed
+//! \returns the simulated time the transfer took, in milliseconds
+size_t lossy_transfer(const double loss_rate, const Recovery recovery, const unsigned int seed) {
+    TCPConfig config;
+    config.congestion_control = CongestionControl::Algorithm::NewReno;
+    config.fast_retransmit = recovery != Recovery::Timeouts;
+    config.limited_transmit = recovery != Recovery::Timeouts;
+    config.sack = recovery == Recovery::Sack;
+    TCPConnection x{config}, y{config};
+
+    string string_to_send(lossy_len, 'x');
+    for (auto &ch : string_to_send) {
+        ch = rand();
+    }
+
+    Buffer bytes_to_send{string(string_to_send)};
+    x.connect();
+    y.end_input_stream();
+
+    bool x_closed = false;
+
+    string string_received;
+    string_received.reserve(lossy_len);
+
+    size_t elapsed_ms = 0;
+
+    mt19937 rng{seed};
+    bernoulli_distribution lost{loss_rate};
+
+    auto loop = [&] {
+        while (bytes_to_send.size() and x.remaining_outbound_capacity()) {
+            const auto want = min(x.remaining_outbound_capacity(), bytes_to_send.size());
+            bytes_to_send.remove_prefix(x.write(string(bytes_to_send.str().substr(0, want))));
+        }
+
+        if (bytes_to_send.size() == 0 and not x_closed) {
+            x.end_input_stream();
+            x_closed = true;
+        }
+
+        lossy_move_segments(x, y, lost, rng);
+        lossy_move_segments(y, x, lost, rng);
+
+        const auto available_output = y.inbound_stream().buffer_size();
+        if (available_output > 0) {
+            string_received.append(y.inbound_stream().read(available_output));
+        }
+
+        x.tick(1);
+        y.tick(1);
+        elapsed_ms++;
+    };
+
+    while (not y.inbound_stream().eof()) {
+        if (not x.active()) {
+            throw runtime_error("connection reset after too many retransmissions");
+        }
+        loop();
+    }
+
+    if (string_received != string_to_send) {
+        throw runtime_error("strings sent vs. received don't match");
+    }
+
+    const size_t transfer_ms = elapsed_ms;
+    while (x.active() or y.active()) {
+        loop();
+    }
+    return transfer_ms;
+}
+
+//! \brief Report goodput in simulated time over several lossy transfers
+//! \details At these rates, whether a retransmission is itself lost (and waits out a timeout) is enough
+//! to swing a single transfer several-fold, so every recovery method is run over the same seeds.
+void lossy_loop(const double loss_rate, const Recovery recovery) {
+    constexpr unsigned int trials = 5;
+    size_t elapsed_ms = 0;
+    for (unsigned int seed = 1; seed <= trials; seed++) {
+        elapsed_ms += lossy_transfer(loss_rate, recovery, seed);
+    }
+
+    const auto megabits_per_second = trials * lossy_len * 8.0 / 1000.0 / double(elapsed_ms);
+
+    cout << fixed << setprecision(2);
+    cout << "Goodput with " << loss_rate * 100 << "% loss"
+         << (recovery == Recovery::Sack             ? " (SACK):             "
+             : recovery == Recovery::FastRetransmit ? " (fast retransmit):  "
+                                                    : " (timeouts only):    ")
+         << megabits_per_second << " Mbit/s of simulated time (" << elapsed_ms << " ms over " << trials
+         << " transfers)\n";
+}
+
+//! \brief Segments in transit along a path with a fixed one-way delay, each on its way to a connection
+class DelayLine {
+  private:
+    size_t _delay_ms;
+    deque<tuple<size_t, TCPConnection *, TCPSegment>> _in_transit{};  //!< arrival time, destination, segment
+
+  public:
+    explicit DelayLine(const size_t delay_ms) : _delay_ms(delay_ms) {}
+
+    //! \brief Put a segment on the path at time `now_ms`
+    void send(TCPSegment &&seg, TCPConnection &to, const size_t now_ms) {
+        _in_transit.emplace_back(now_ms + _delay_ms, &to, move(seg));
+    }
+
+    //! \brief Put all of `from`'s outbound segments on the path
+    void transmit(TCPConnection &from, TCPConnection &to, const size_t now_ms) {
+        while (not from.segments_out().empty()) {
+            send(move(from.segments_out().front()), to, now_ms);
+            from.segments_out().pop();
+        }
+    }
+
+    //! \brief Hand the segments that have arrived by `now_ms` to their connections
+    void deliver(const size_t now_ms) {
+        while (not _in_transit.empty() and get<0>(_in_transit.front()) <= now_ms) {
+            get<1>(_in_transit.front())->segment_received(get<2>(_in_transit.front()));
+            _in_transit.pop_front();
+        }
+    }
+};
+
+//! \brief A one-way path through a bottleneck: a drop-tail queue, drained at the link's rate onto a DelayLine
+//! \details The link's capacity accrues each millisecond, and is lost whenever the queue runs empty.
+class BottleneckLink {
+  private:
+    size_t _bytes_per_ms;
+    size_t _queue_capacity;
+    deque<pair<TCPConnection *, TCPSegment>> _queue{};
+    size_t _queued_bytes{0};
+    size_t _credit{0};
+    DelayLine _path;
+
+  public:
+    BottleneckLink(const size_t bytes_per_ms, const size_t delay_ms, const size_t queue_capacity)
+        : _bytes_per_ms(bytes_per_ms), _queue_capacity(queue_capacity), _path(delay_ms) {}
+
+    //! \brief Bytes the segment takes on the wire: its payload, and its header with options
+    static size_t wire_size(const TCPSegment &seg) {
+        return TCPHeader::LENGTH + seg.header().serialize_options().size() + seg.payload().size();
+    }
+
+    //! \brief Queue a segment for the link
+    //! \returns `false` if the queue had no room for it, and it was dropped
+    bool send(TCPSegment &&seg, TCPConnection &to) {
+        if (_queued_bytes + wire_size(seg) > _queue_capacity) {
+            return false;
+        }
+        _queued_bytes += wire_size(seg);
+        _queue.emplace_back(&to, move(seg));
+        return true;
+    }
+
+    //! \brief Queue all of `from`'s outbound segments for the link
+    //! \returns the number that were dropped
+    size_t transmit(TCPConnection &from, TCPConnection &to) {
+        size_t dropped = 0;
+        while (not from.segments_out().empty()) {
+            dropped += send(move(from.segments_out().front()), to) ? 0 : 1;
+            from.segments_out().pop();
+        }
+        return dropped;
+    }
+
+    //! \brief Let a millisecond's worth of segments across the link, and deliver those that have arrived
+    //! \returns the bytes the link carried
+    size_t tick(const size_t now_ms) {
+        _credit += _bytes_per_ms;
+        size_t carried = 0;
+        while (not _queue.empty() and wire_size(_queue.front().second) <= _credit) {
+            const size_t size = wire_size(_queue.front().second);
+            _credit -= size;
+            _queued_bytes -= size;
+            carried += size;
+            _path.send(move(_queue.front().second), *_queue.front().first, now_ms);
+            _queue.pop_front();
+        }
+        if (_queue.empty()) {
+            _credit = 0;
+        }
+        _path.deliver(now_ms);
+        return carried;
+    }
+};
+
+//! \brief Transfer over a lossless path with a long round-trip time and large buffers at both ends,
+//! one millisecond of simulated time per exchange, and report goodput in simulated time
+//! \details Without window scaling the advertised window is capped at 64 KiB, and so is the data sent
+//! per round trip.
+void delayed_loop(const size_t rtt_ms, const bool window_scaling) {
+    TCPConfig config;
+    config.recv_capacity = 4 * 1024 * 1024;
+    config.send_capacity = 4 * 1024 * 1024;
+    config.window_scaling = window_scaling;
+    TCPConnection x{config}, y{config};
+
+    string string_to_send(lossy_len, 'x');
+    for (auto &ch : string_to_send) {
+        ch = rand();
+    }
+
+    Buffer bytes_to_send{string(string_to_send)};
+    x.connect();
+    y.end_input_stream();
+
+    bool x_closed = false;
+
+    string string_received;
+    string_received.reserve(lossy_len);
+
+    size_t elapsed_ms = 0;
+
+    // segments in transit in each direction
+    DelayLine x_to_y{rtt_ms / 2}, y_to_x{rtt_ms / 2};
+
+    auto loop = [&] {
+        while (bytes_to_send.size() and x.remaining_outbound_capacity()) {
+            const auto want = min(x.remaining_outbound_capacity(), bytes_to_send.size());
+            bytes_to_send.remove_prefix(x.write(string(bytes_to_send.str().substr(0, want))));
+        }
+
+        if (bytes_to_send.size() == 0 and not x_closed) {
+            x.end_input_stream();
+            x_closed = true;
+        }
+
+        x_to_y.transmit(x, y, elapsed_ms);
+        x_to_y.deliver(elapsed_ms);
+        y_to_x.transmit(y, x, elapsed_ms);
+        y_to_x.deliver(elapsed_ms);
+
+        const auto available_output = y.inbound_stream().buffer_size();
+        if (available_output > 0) {
+            string_received.append(y.inbound_stream().read(available_output));
+        }
+
+        x.tick(1);
+        y.tick(1);
+        elapsed_ms++;
+    };
+
+    while (not y.inbound_stream().eof()) {
+        loop();
+    }
+
+    if (string_received != string_to_send) {
+        throw runtime_error("strings sent vs. received don't match");
+    }
+
+    const auto megabits_per_second = lossy_len * 8.0 / 1000.0 / double(elapsed_ms);
+
+    cout << fixed << setprecision(2);
+    cout << "Goodput over a " << rtt_ms << " ms path"
+         << (window_scaling ? " (window scaling):   " : " (64 KiB window):    ") << megabits_per_second
+         << " Mbit/s of simulated time (" << elapsed_ms << " ms)\n";
+
+    while (x.active() or y.active()) {
+        loop();
+    }
+}
+
+//! \brief Transfer bursts of data through a bottleneck link with a shallow drop-tail queue, one millisecond
+//! of simulated time per exchange, and report goodput in simulated time and the number of segments dropped
+//! \details The link carries 100 Mbit/s with a 32 KiB queue and a 40 ms round trip, and the application writes
+//! 384 KiB (a receive window's worth) every 250 ms. A sender that releases a window at a time overflows the
+//! queue with each write; a paced one spreads the window over the round trip.
+void bottleneck_loop(const bool pacing) {
+    constexpr size_t rtt_ms = 40;
+    constexpr size_t link_bytes_per_ms = 12500;
+    constexpr size_t queue_capacity = 32 * 1024;
+    constexpr size_t burst_len = 384 * 1024;
+    constexpr size_t burst_interval_ms = 250;
+
+    TCPConfig config;
+    config.recv_capacity = burst_len;
+    config.send_capacity = burst_len;
+    config.window_scaling = true;
+    config.adaptive_rto = true;
+    config.congestion_control = CongestionControl::Algorithm::NewReno;
+    config.fast_retransmit = true;
+    config.sack = true;
+    config.pacing = pacing;
+    TCPConnection x{config}, y{config};
+
+    string string_to_send(lossy_len, 'x');
+    for (auto &ch : string_to_send) {
+        ch = rand();
+    }
+
+    size_t bytes_written = 0;
+    x.connect();
+    y.end_input_stream();
+
+    bool x_closed = false;
+
+    string string_received;
+    string_received.reserve(lossy_len);
+
+    size_t elapsed_ms = 0, dropped = 0;
+
+    // the bottleneck from x to y, and the uncongested path back
+    BottleneckLink x_to_y{link_bytes_per_ms, rtt_ms / 2, queue_capacity};
+    DelayLine y_to_x{rtt_ms / 2};
+
+    auto loop = [&] {
+        const size_t bytes_released = min(lossy_len, (elapsed_ms / burst_interval_ms + 1) * burst_len);
+        while (bytes_written < bytes_released and x.remaining_outbound_capacity()) {
+            const auto want = min(x.remaining_outbound_capacity(), bytes_released - bytes_written);
+            bytes_written += x.write(string_to_send.substr(bytes_written, want));
+        }
+
+        if (bytes_written == lossy_len and not x_closed) {
+            x.end_input_stream();
+            x_closed = true;
+        }
+
+        dropped += x_to_y.transmit(x, y);
+        x_to_y.tick(elapsed_ms);
+
+        y_to_x.transmit(y, x, elapsed_ms);
+        y_to_x.deliver(elapsed_ms);
+
+        const auto available_output = y.inbound_stream().buffer_size();
+        if (available_output > 0) {
+            string_received.append(y.inbound_stream().read(available_output));
+        }
+
+        x.tick(1);
+        y.tick(1);
+        elapsed_ms++;
+    };
+
+    while (not y.inbound_stream().eof()) {
+        if (not x.active()) {
+            throw runtime_error("connection reset after too many retransmissions");
+        }
+        loop();
+    }
+
+    if (string_received != string_to_send) {
+        throw runtime_error("strings sent vs. received don't match");
+    }
+
+    const auto megabits_per_second = lossy_len * 8.0 / 1000.0 / double(elapsed_ms);
+
+    cout << fixed << setprecision(2);
+    cout << "Goodput through a shallow bottleneck" << (pacing ? " (paced):   " : " (unpaced): ") << megabits_per_second
+         << " Mbit/s of simulated time (" << elapsed_ms << " ms, " << dropped << " segments dropped)\n";
+
+    while (x.active() or y.active()) {
+        loop();
+    }
+}
+
+//! \brief Fill a 1 Gbit/s path with a 100 ms round trip, drop one segment once it is full, and report how
+//! long the sender takes, after the loss, to bring the link back to 90% utilization
+//! \details The receive window is one bandwidth-delay product (12.5 MB), so the link runs full before the
+//! loss, and the bottleneck's queue is deep enough that nothing else is dropped. Utilization is measured
+//! from the wire bytes the link carried over the trailing round trip. Once the hole is filled, both senders
+//! slow-start back to their reduced ssthresh; NewReno then adds a segment per round trip, which takes minutes
+//! at this window size, while CUBIC starts from 70% and climbs back in a few seconds.
+void recovery_loop(const CongestionControl::Algorithm algorithm, const string &name) {
+    constexpr size_t rtt_ms = 100;
+    constexpr size_t link_bytes_per_ms = 125000;
+    constexpr size_t bdp = rtt_ms * link_bytes_per_ms;
+    constexpr size_t loss_at_ms = 3000;
+    constexpr size_t horizon_ms = 20000;
+
+    TCPConfig config;
+    config.recv_capacity = bdp;
+    config.send_capacity = bdp;
+    config.window_scaling = true;
+    config.adaptive_rto = true;
+    config.congestion_control = algorithm;
+    config.fast_retransmit = true;
+    config.sack = true;
+    TCPConnection x{config}, y{config};
+
+    const string chunk(64 * 1024, 'x');
+    x.connect();
+    y.end_input_stream();
+
+    size_t elapsed_ms = 0;
+    bool x_closed = false, lost = false, dipped = false;
+    optional<size_t> recovered_ms{};
+
+    // the bottleneck from x to y (with a queue that never fills), the uncongested path back,
+    // and the bytes the link carried in each of the last `rtt_ms` milliseconds
+    BottleneckLink x_to_y{link_bytes_per_ms, rtt_ms / 2, numeric_limits<size_t>::max()};
+    DelayLine y_to_x{rtt_ms / 2};
+    deque<size_t> carried(rtt_ms, 0);
+    size_t carried_in_rtt = 0;
+
+    auto loop = [&] {
+        while (not x_closed and x.remaining_outbound_capacity()) {
+            x.write(chunk.substr(0, x.remaining_outbound_capacity()));
+        }
+
+        while (not x.segments_out().empty()) {
+            if (not lost and elapsed_ms >= loss_at_ms and x.segments_out().front().payload().size() > 0) {
+                lost = true;
+            } else {
+                x_to_y.send(move(x.segments_out().front()), y);
+            }
+            x.segments_out().pop();
+        }
+        const size_t carried_now = x_to_y.tick(elapsed_ms);
+        carried_in_rtt += carried_now - carried.front();
+        carried.pop_front();
+        carried.push_back(carried_now);
+
+        y_to_x.transmit(y, x, elapsed_ms);
+        y_to_x.deliver(elapsed_ms);
+
+        y.inbound_stream().pop_output(y.inbound_stream().buffer_size());
+
+        x.tick(1);
+        y.tick(1);
+        elapsed_ms++;
+    };
+
+    auto utilization = [&] { return double(carried_in_rtt) / double(bdp); };
+    while (not recovered_ms.has_value() and elapsed_ms < loss_at_ms + horizon_ms) {
+        if (not x.active()) {
+            throw runtime_error("connection reset after too many retransmissions");
+        }
+        loop();
+        if (lost) {
+            dipped = dipped or utilization() < 0.9;
+            if (dipped and utilization() >= 0.9) {
+                recovered_ms = elapsed_ms - loss_at_ms;
+            }
+        }
+    }
+
+    cout << fixed << setprecision(2);
+    cout << "Time to 90% utilization after a loss (" << name << "): ";
+    if (recovered_ms.has_value()) {
+        cout << double(recovered_ms.value()) / 1000.0 << " s of simulated time\n";
+    } else {
+        cout << "over " << horizon_ms / 1000 << " s of simulated time (" << setprecision(0) << 100 * utilization()
+             << "% after " << horizon_ms / 1000 << " s)\n";
+    }
+
+    x.end_input_stream();
+    x_closed = true;
+    while (x.active() or y.active()) {
+        loop();
+    }
+}
+
+//! \brief Transfer through a bottleneck link whose path drops segments at random, in both directions, one
+//! millisecond of simulated time per exchange, and report goodput in simulated time
+//! \details The link carries 100 Mbit/s with a 40 ms round trip and a queue of one bandwidth-delay product
+//! (500 kB). Loss-based controllers take each random loss as a sign of congestion and cut their windows;
+//! BBR paces at its estimate of the bottleneck bandwidth, which random losses don't change.
+void random_loss_loop(const double loss_rate, const CongestionControl::Algorithm algorithm, const string &name) {
+    constexpr size_t rtt_ms = 40;
+    constexpr size_t link_bytes_per_ms = 12500;
+    constexpr size_t queue_capacity = rtt_ms * link_bytes_per_ms;
+
+    TCPConfig config;
+    config.recv_capacity = 2 * 1024 * 1024;
+    config.send_capacity = 2 * 1024 * 1024;
+    config.window_scaling = true;
+    config.adaptive_rto = true;
+    config.congestion_control = algorithm;
+    config.fast_retransmit = true;
+    config.limited_transmit = true;
+    config.sack = true;
+    TCPConnection x{config}, y{config};
+
+    string string_to_send(lossy_len, 'x');
+    for (auto &ch : string_to_send) {
+        ch = rand();
+    }
+
+    size_t bytes_written = 0;
+    x.connect();
+    y.end_input_stream();
+
+    bool x_closed = false;
+
+    string string_received;
+    string_received.reserve(lossy_len);
+
+    size_t elapsed_ms = 0;
+
+    // every run sees the same losses
+    mt19937 rng{1};
+    bernoulli_distribution lost{loss_rate};
+
+    // the bottleneck from x to y, and the uncongested path back
+    BottleneckLink x_to_y{link_bytes_per_ms, rtt_ms / 2, queue_capacity};
+    DelayLine y_to_x{rtt_ms / 2};
+
+    auto loop = [&] {
+        while (bytes_written < lossy_len and x.remaining_outbound_capacity()) {
+            const auto want = min(x.remaining_outbound_capacity(), lossy_len - bytes_written);
+            bytes_written += x.write(string_to_send.substr(bytes_written, want));
+        }
+
+        if (bytes_written == lossy_len and not x_closed) {
+            x.end_input_stream();
+            x_closed = true;
+        }
+
+        while (not x.segments_out().empty()) {
+            if (not lost(rng)) {
+                x_to_y.send(move(x.segments_out().front()), y);
+            }
+            x.segments_out().pop();
+        }
+        x_to_y.tick(elapsed_ms);
+
+        while (not y.segments_out().empty()) {
+            if (not lost(rng)) {
+                y_to_x.send(move(y.segments_out().front()), x, elapsed_ms);
+            }
+            y.segments_out().pop();
+        }
+        y_to_x.deliver(elapsed_ms);
+
+        const auto available_output = y.inbound_stream().buffer_size();
+        if (available_output > 0) {
+            string_received.append(y.inbound_stream().read(available_output));
+        }
+
+        x.tick(1);
+        y.tick(1);
+        elapsed_ms++;
+    };
+
+    while (not y.inbound_stream().eof()) {
+        if (not x.active()) {
+            throw runtime_error("connection reset after too many retransmissions");
+        }
+        loop();
+    }
+
+    if (string_received != string_to_send) {
+        throw runtime_error("strings sent vs. received don't match");
+    }
+
+    const auto megabits_per_second = lossy_len * 8.0 / 1000.0 / double(elapsed_ms);
+
+    cout << fixed << setprecision(2);
+    cout << "Goodput with " << setprecision(0) << loss_rate * 100 << "% random loss at 100 Mbit/s (" << name
+         << "): " << setprecision(2) << megabits_per_second << " Mbit/s of simulated time (" << elapsed_ms
+         << " ms)\n";
 
     while (x.active() or y.active()) {
         loop();
     }
 }
 
+//! \brief Make small request/response exchanges across a bottleneck link, beside a bulk transfer or on an
+//! idle path, one millisecond of simulated time per exchange, and report their latency and the bulk goodput
+//! \details The link carries 20 Mbit/s with a 40 ms round trip and a 250 kB drop-tail queue (100 ms at the
+//! link's rate), shared by the bulk transfer and the requests; responses return uncongested. A request of
+//! 100 bytes is sent every 100 ms, once the last 1000-byte response is in, and latencies are taken after the
+//! first 5 s. A NewReno transfer fills the queue, and every request waits behind it; a LEDBAT one holds the
+//! queue near its 25 ms target, and yields to the requests.
+void background_loop(const optional<CongestionControl::Algorithm> algorithm, const string &name) {
+    constexpr size_t rtt_ms = 40;
+    constexpr size_t link_bytes_per_ms = 2500;
+    constexpr size_t queue_capacity = 250000;
+    constexpr size_t request_len = 100, response_len = 1000;
+    constexpr size_t request_interval_ms = 100;
+    constexpr size_t warmup_ms = 5000, horizon_ms = 30000;
+
+    TCPConfig bulk_config;
+    bulk_config.recv_capacity = 1024 * 1024;
+    bulk_config.send_capacity = 1024 * 1024;
+    bulk_config.window_scaling = true;
+    bulk_config.adaptive_rto = true;
+    bulk_config.congestion_control = algorithm.value_or(CongestionControl::Algorithm::NewReno);
+    bulk_config.fast_retransmit = true;
+    bulk_config.sack = true;
+    TCPConfig rpc_config;
+    rpc_config.adaptive_rto = true;
+    rpc_config.fast_retransmit = true;
+    rpc_config.sack = true;
+
+    // the bulk transfer runs from x to y, and requests from client to server
+    TCPConnection x{bulk_config}, y{bulk_config}, client{rpc_config}, server{rpc_config};
+    const string chunk(64 * 1024, 'x');
+    if (algorithm.has_value()) {
+        x.connect();
+    }
+    y.end_input_stream();
+    client.connect();
+
+    size_t elapsed_ms = 0, bulk_received = 0;
+    bool closing = false;
+
+    // the request in flight, if any: when it was sent, and the bytes of it and its response seen so far
+    optional<size_t> request_sent_ms{};
+    size_t next_request_ms = 0, request_received = 0, response_received = 0;
+    vector<size_t> latencies{};
+
+    // the bottleneck, shared by the bulk transfer and the requests, and the uncongested path back
+    BottleneckLink forward{link_bytes_per_ms, rtt_ms / 2, queue_capacity};
+    DelayLine back{rtt_ms / 2};
+
+    auto loop = [&] {
+        while (algorithm.has_value() and not closing and x.remaining_outbound_capacity()) {
+            x.write(chunk.substr(0, x.remaining_outbound_capacity()));
+        }
+        if (not closing and not request_sent_ms.has_value() and elapsed_ms >= next_request_ms) {
+            client.write(string(request_len, 'q'));
+            request_sent_ms = elapsed_ms;
+            next_request_ms = elapsed_ms + request_interval_ms;
+        }
+
+        forward.transmit(x, y);
+        forward.transmit(client, server);
+        forward.tick(elapsed_ms);
+
+        back.transmit(y, x, elapsed_ms);
+        back.transmit(server, client, elapsed_ms);
+        back.deliver(elapsed_ms);
+
+        bulk_received += y.inbound_stream().buffer_size();
+        y.inbound_stream().pop_output(y.inbound_stream().buffer_size());
+
+        request_received += server.inbound_stream().read(server.inbound_stream().buffer_size()).size();
+        if (request_received >= request_len) {
+            request_received -= request_len;
+            server.write(string(response_len, 'r'));
+        }
+        response_received += client.inbound_stream().read(client.inbound_stream().buffer_size()).size();
+        if (response_received >= response_len) {
+            response_received -= response_len;
+            if (request_sent_ms.value() >= warmup_ms) {
+                latencies.push_back(elapsed_ms - request_sent_ms.value());
+            }
+            request_sent_ms.reset();
+        }
+
+        x.tick(1);
+        y.tick(1);
+        client.tick(1);
+        server.tick(1);
+        elapsed_ms++;
+    };
+
+    while (elapsed_ms < horizon_ms) {
+        if (not client.active() or (algorithm.has_value() and not x.active())) {
+            throw runtime_error("connection reset after too many retransmissions");
+        }
+        loop();
+    }
+    const size_t bulk_received_at_horizon = bulk_received;
+
+    sort(latencies.begin(), latencies.end());
+    auto percentile = [&](const size_t p) { return latencies.at((latencies.size() - 1) * p / 100); };
+
+    cout << fixed << setprecision(2);
+    cout << "Request latency " << name << ": median " << percentile(50) << " ms, 99th percentile "
+         << percentile(99) << " ms of simulated time";
+    if (algorithm.has_value()) {
+        cout << " (bulk goodput " << bulk_received_at_horizon * 8.0 / 1000.0 / double(horizon_ms)
+             << " Mbit/s)";
+    }
+    cout << "\n";
+
+    closing = true;
+    while (request_sent_ms.has_value()) {
+        loop();
+    }
+    x.end_input_stream();
+    client.end_input_stream();
+    server.end_input_stream();
+    while (x.active() or y.active() or client.active() or server.active()) {
+        loop();
+    }
+}
+
 int main() {
     try {
-        main_loop(false);
-        main_loop(true);
+        main_loop(false, ByteStream::Storage::Ring);
+        main_loop(true, ByteStream::Storage::Ring);
+        main_loop(false, ByteStream::Storage::Chunked);
+        main_loop(true, ByteStream::Storage::Chunked);
+        main_loop(false, ByteStream::Storage::Mirrored);
+        main_loop(true, ByteStream::Storage::Mirrored);
+        main_loop(false, ByteStream::Storage::Paged);
+        main_loop(true, ByteStream::Storage::Paged);
+        main_loop(false, ByteStream::Storage::Ring, true);
+        main_loop(false, ByteStream::Storage::Chunked, true);
+        for (const double loss_rate : {0.01, 0.05}) {
+            lossy_loop(loss_rate, Recovery::Timeouts);
+            lossy_loop(loss_rate, Recovery::FastRetransmit);
+            lossy_loop(loss_rate, Recovery::Sack);
+        }
+        delayed_loop(100, false);
+        delayed_loop(100, true);
+        bottleneck_loop(false);
+        bottleneck_loop(true);
+        recovery_loop(CongestionControl::Algorithm::NewReno, "NewReno");
+        recovery_loop(CongestionControl::Algorithm::Cubic, "CUBIC");
+        for (const double loss_rate : {0.01, 0.05}) {
+            random_loss_loop(loss_rate, CongestionControl::Algorithm::NewReno, "NewReno");
+            random_loss_loop(loss_rate, CongestionControl::Algorithm::Cubic, "CUBIC");
+            random_loss_loop(loss_rate, CongestionControl::Algorithm::Bbr, "BBR");
+        }
+        background_loop(nullopt, "on an idle path");
+        background_loop(CongestionControl::Algorithm::NewReno, "beside a NewReno transfer");
+        background_loop(CongestionControl::Algorithm::Ledbat, "beside a LEDBAT transfer");
     } catch (const exception &e) {
         cerr << e.what() << "\n";
         return EXIT_FAILURE;
@@ -0,0 +1,148 @@
+#include "ipv4_datagram.hh"
+#include "parser.hh"
+#include "tcp_config.hh"
+#include "tcp_engine.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr uint32_t client_address = 0x0a000001;  // 10.0.0.1, and up
+constexpr uint32_t server_address = 0x0a800001;  // 10.128.0.1
+constexpr uint16_t server_port = 80;
+constexpr size_t ports_per_address = 60000;
+constexpr size_t request_len = 100;
+constexpr size_t response_len = 1000;
+constexpr size_t rounds = 10;
+constexpr size_t idle_ticks = 1000;
+
+//! Deliver `from`'s datagrams to `to`, serialized and parsed again as a device would carry them
+void move_datagrams(TCPEngine &from, TCPEngine &to) {
+    while (not from.datagrams_out().empty()) {
+        InternetDatagram dgram;
+        if (dgram.parse(from.datagrams_out().front().serialize().concatenate()) != ParseResult::NoError) {
+            throw runtime_error("datagram did not parse");
+        }
+        from.datagrams_out().pop();
+        to.datagram_received(dgram);
+    }
+}
+
+void exchange(TCPEngine &x, TCPEngine &y) {
+    while (not x.datagrams_out().empty() or not y.datagrams_out().empty()) {
+        move_datagrams(x, y);
+        move_datagrams(y, x);
+    }
+}
+
+double seconds_since(const high_resolution_clock::time_point &start) {
+    return duration_cast<duration<double>>(high_resolution_clock::now() - start).count();
+}
+
+//! Open `count` connections between two engines, on one thread, and time the handshakes, rounds of
+//! small requests and responses over every connection, idle ticks, and the closes.
+void main_loop(const size_t count) {
+    TCPConfig config;
+    config.send_storage = ByteStream::Storage::Chunked;
+    config.recv_storage = ByteStream::Storage::Chunked;
+    TCPEngine client{config}, server{config};
+    server.listen(server_port);
+
+    vector<FourTuple> client_side, server_side;
+    client_side.reserve(count);
+    server_side.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        const uint32_t address = client_address + i / ports_per_address;
+        const uint16_t port = 1024 + i % ports_per_address;
+        client_side.push_back({address, port, server_address, server_port});
+        server_side.push_back({server_address, server_port, address, port});
+    }
+
+    auto start = high_resolution_clock::now();
+    for (const auto &tuple : client_side) {
+        client.connect(tuple);
+    }
+    exchange(client, server);
+    const double open_time = seconds_since(start);
+    if (server.size() != count) {
+        throw runtime_error("only " + to_string(server.size()) + " connections were accepted");
+    }
+
+    start = high_resolution_clock::now();
+    for (size_t round = 0; round < rounds; round++) {
+        for (const auto &tuple : client_side) {
+            client.write(tuple, string(request_len, 'q'));
+        }
+        exchange(client, server);
+        for (const auto &tuple : server_side) {
+            ByteStream &inbound = server.inbound_stream(tuple);
+            if (inbound.read(inbound.buffer_size()).size() != request_len) {
+                throw runtime_error("request lost on " + tuple.to_string());
+            }
+            server.write(tuple, string(response_len, 'r'));
+        }
+        exchange(client, server);
+        for (const auto &tuple : client_side) {
+            ByteStream &inbound = client.inbound_stream(tuple);
+            if (inbound.read(inbound.buffer_size()).size() != response_len) {
+                throw runtime_error("response lost on " + tuple.to_string());
+            }
+        }
+        // the reads leave every connection waiting to see if the window update is due; a tick settles them
+        client.tick(1);
+        server.tick(1);
+    }
+    const double transaction_time = seconds_since(start);
+
+    start = high_resolution_clock::now();
+    for (size_t i = 0; i < idle_ticks; i++) {
+        client.tick(1);
+        server.tick(1);
+    }
+    const double tick_time = seconds_since(start);
+    const size_t timed = client.timed() + server.timed();
+
+    start = high_resolution_clock::now();
+    for (const auto &tuple : client_side) {
+        client.end_input_stream(tuple);
+    }
+    exchange(client, server);
+    for (const auto &tuple : server_side) {
+        server.end_input_stream(tuple);
+    }
+    exchange(client, server);
+    client.tick(10 * config.rt_timeout);
+    const double close_time = seconds_since(start);
+    if (client.size() != 0 or server.size() != 0) {
+        throw runtime_error("connections left open");
+    }
+
+    cout << fixed << setprecision(0);
+    cout << setw(6) << count << " connections: " << setw(7) << count / open_time << " opened/s, " << setw(7)
+         << count * rounds / transaction_time << " request-response pairs/s, " << setw(7) << count / close_time
+         << " closed/s; " << setprecision(1) << setw(6) << 1e6 * tick_time / (2 * idle_ticks)
+         << " us per idle tick (" << timed << " connections timed)\n";
+}
+
+int main() {
+    try {
+        cout << "Connections per core, with one thread running both ends (" << request_len << "-byte requests, "
+             << response_len << "-byte responses):\n";
+        for (const size_t count : {1000, 10000, 50000}) {
+            main_loop(count);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
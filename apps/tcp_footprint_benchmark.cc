@@ -0,0 +1,96 @@
+#include "tcp_connection.hh"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+constexpr size_t connection_pairs = 10000;
+constexpr size_t window = 4 * 1024 * 1024;
+constexpr size_t bytes_in_flight = 100;
+
+//! \returns the resident set size of this process, in bytes
+size_t resident_bytes() {
+    size_t total_pages = 0, resident_pages = 0;
+    ifstream statm{"/proc/self/statm"};
+    statm >> total_pages >> resident_pages;
+    return resident_pages * sysconf(_SC_PAGESIZE);
+}
+
+void move_segments(TCPConnection &x, TCPConnection &y) {
+    while (not x.segments_out().empty()) {
+        y.segment_received(x.segments_out().front());
+        x.segments_out().pop();
+    }
+}
+
+void exchange(TCPConnection &x, TCPConnection &y) {
+    while (not x.segments_out().empty() or not y.segments_out().empty()) {
+        move_segments(x, y);
+        move_segments(y, x);
+    }
+}
+
+//! Open `pairs` pairs of connections with multi-megabyte windows, exchange a few bytes
+//! over each (left unread by the receiver), and report the memory they hold while idle.
+void main_loop(const ByteStream::Storage storage, const string &name, const size_t pairs) {
+    TCPConfig config;
+    config.recv_capacity = window;
+    config.send_capacity = window;
+    config.recv_storage = storage;
+    config.send_storage = storage;
+
+    const size_t resident_before = resident_bytes();
+
+    vector<TCPConnection> clients, servers;
+    clients.reserve(pairs);
+    servers.reserve(pairs);
+    for (size_t i = 0; i < pairs; i++) {
+        TCPConnection &client = clients.emplace_back(config);
+        TCPConnection &server = servers.emplace_back(config);
+        client.connect();
+        exchange(client, server);
+        client.write(string(bytes_in_flight, 'x'));
+        exchange(client, server);
+    }
+
+    size_t footprint = 0;
+    for (size_t i = 0; i < pairs; i++) {
+        footprint += clients[i].footprint() + servers[i].footprint();
+    }
+    const size_t resident = resident_bytes() - resident_before;
+
+    cout << fixed << setprecision(1);
+    cout << name << ": " << pairs << " idle connection pairs hold " << footprint / 1048576.0 << " MiB in buffers ("
+         << footprint / double(2 * pairs) << " bytes per connection), " << resident / 1048576.0 << " MiB resident\n";
+
+    for (size_t i = 0; i < pairs; i++) {
+        clients[i].end_input_stream();
+        exchange(clients[i], servers[i]);
+        servers[i].end_input_stream();
+        exchange(clients[i], servers[i]);
+        clients[i].tick(10 * config.rt_timeout);
+    }
+}
+
+int main() {
+    try {
+        cout << "Idle connections with " << window / 1048576 << " MiB windows and " << bytes_in_flight
+             << " bytes buffered in each:\n";
+        // the up-front storages can't afford ten thousand multi-megabyte windows; measure fewer
+        main_loop(ByteStream::Storage::Ring, "ring    ", connection_pairs / 100);
+        main_loop(ByteStream::Storage::Mirrored, "mirrored", connection_pairs / 100);
+        main_loop(ByteStream::Storage::Chunked, "chunked ", connection_pairs);
+        main_loop(ByteStream::Storage::Paged, "paged   ", connection_pairs);
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -21,6 +21,16 @@ add_test(NAME t_send_window          COMMAND send_window)
 add_test(NAME t_send_ack             COMMAND send_ack)
 add_test(NAME t_send_close           COMMAND send_close)
 add_test(NAME t_send_extra           COMMAND send_extra)
+add_test(NAME t_send_congestion      COMMAND send_congestion)
+add_test(NAME t_send_cubic           COMMAND send_cubic)
+add_test(NAME t_send_bbr             COMMAND send_bbr)
+add_test(NAME t_send_ledbat          COMMAND send_ledbat)
+add_test(NAME t_send_ecn             COMMAND send_ecn)
+add_test(NAME t_send_rtt             COMMAND send_rtt)
+add_test(NAME t_send_pacing          COMMAND send_pacing)
+add_test(NAME t_send_persist         COMMAND send_persist)
+add_test(NAME t_send_repacketize     COMMAND send_repacketize)
+add_test(NAME t_send_offload         COMMAND send_offload)
 
 add_test(NAME t_strm_reassem_single      COMMAND fsm_stream_reassembler_single)
 add_test(NAME t_strm_reassem_seq         COMMAND fsm_stream_reassembler_seq)
@@ -36,6 +46,7 @@ add_test(NAME t_byte_stream_one_write    COMMAND byte_stream_one_write)
 add_test(NAME t_byte_stream_two_writes   COMMAND byte_stream_two_writes)
 add_test(NAME t_byte_stream_capacity     COMMAND byte_stream_capacity)
 add_test(NAME t_byte_stream_many_writes  COMMAND byte_stream_many_writes)
+add_test(NAME t_byte_stream_spans        COMMAND byte_stream_spans)
 
 add_test(NAME t_webget               COMMAND "${PROJECT_SOURCE_DIR}/tests/webget_t.sh")
 
@@ -54,6 +65,14 @@ add_test(NAME t_listen               COMMAND fsm_listen_relaxed)
 add_test(NAME t_winsize              COMMAND fsm_winsize)
 add_test(NAME t_retx                 COMMAND fsm_retx_relaxed)
 add_test(NAME t_retx_win             COMMAND fsm_retx_win)
+add_test(NAME t_fast_retx            COMMAND fsm_fast_retx)
+add_test(NAME t_sack                 COMMAND fsm_sack)
+add_test(NAME t_ecn                  COMMAND fsm_ecn)
+add_test(NAME t_winscale             COMMAND fsm_winscale)
+add_test(NAME t_timestamps           COMMAND fsm_timestamps)
+add_test(NAME t_engine               COMMAND fsm_engine)
+add_test(NAME t_nagle_delack         COMMAND fsm_nagle_delack)
+add_test(NAME t_sws                  COMMAND fsm_sws)
 add_test(NAME t_loopback             COMMAND fsm_loopback)
 add_test(NAME t_loopback_win         COMMAND fsm_loopback_win)
 add_test(NAME t_reorder              COMMAND fsm_reorder)
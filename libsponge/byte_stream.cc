@@ -1,5 +1,8 @@
 #include "byte_stream.hh"
 
+#include <algorithm>
+#include <stdexcept>
+
 // Dummy implementation of a flow-controlled in-memory byte stream.
 
 // For Lab 0, please replace with a real implementation that passes the
@@ -12,60 +15,89 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
-ByteStream::ByteStream(const size_t capacity_sd)
-    : buffer(capacity_sd + 1)
-    , capacity(capacity_sd)
-    , buf_len(capacity_sd + 1)
-    , head(0)
-    , tail(0)
-    , iseof(false)
-    , b_read(0)
-    , b_written(0) {}
+//! \param[in] capacity is the stream's capacity, which a Ring or Mirrored storage allocates up front
+//! \param[in] storage selects how the written-but-unread bytes are held
+static unique_ptr<StreamStorage> make_storage(const size_t capacity, const ByteStream::Storage storage) {
+    switch (storage) {
+        case ByteStream::Storage::Chunked:
+            return make_unique<ChunkedStorage>();
+        case ByteStream::Storage::Mirrored:
+            return make_unique<MirroredStorage>(capacity);
+        case ByteStream::Storage::Paged:
+            return make_unique<PagedStorage>();
+        case ByteStream::Storage::Ring:
+            return make_unique<RingStorage>(capacity);
+    }
+    throw invalid_argument("ByteStream: unknown storage");
+}
+
+ByteStream::ByteStream(const size_t capacity_sd, const Storage storage)
+    : buffer(make_storage(capacity_sd, storage)), capacity(capacity_sd), iseof(false), b_read(0), b_written(0) {}
 
 size_t ByteStream::write(const string &data) {
     if (iseof) {
         return 0;
     }
 
-    size_t written = 0;
-    for (const char c : data) {
-        if ((tail + 1) % buf_len != head) {
-            buffer[tail++] = c;
-            tail %= buf_len;
-            written++;
-        } else {
-            break;
-        }
+    const size_t written = min(data.size(), remaining_capacity());
+    buffer->append(string_view(data).substr(0, written));
+    b_written = b_written + written;
+    return written;
+}
+
+size_t ByteStream::write(Buffer data) {
+    if (iseof) {
+        return 0;
     }
+
+    const size_t written = min(data.size(), remaining_capacity());
+    data.remove_suffix(data.size() - written);
+    buffer->append(move(data));
     b_written = b_written + written;
     return written;
 }
 
-//! \param[in] len bytes will be copied from the output side of the buffer
-string ByteStream::peek_output(const size_t len) const {
-    string r;
-    size_t read = 0;
-    size_t p_head = head;
-
-    while (p_head != tail && read < len) {
-        r += buffer[p_head++];
-        p_head %= buf_len;
-        read++;
+vector<iovec> ByteStream::writable_spans() {
+    if (iseof) {
+        return {};
     }
+    return buffer->writable_spans(remaining_capacity());
+}
 
-    return r;
+//! \param[in] len bytes of writable_spans() that have been filled in
+void ByteStream::commit_write(const size_t len) {
+    if ((iseof and len > 0) or len > remaining_capacity()) {
+        throw runtime_error("ByteStream::commit_write: more bytes than writable_spans() offered");
+    }
+    buffer->commit(len);
+    b_written += len;
+}
+
+//! \param[in] offset is the number of bytes between the last byte written and the first byte of `data`
+void ByteStream::stage_write(const size_t offset, string_view data) {
+    if (iseof or not can_stage() or offset + data.size() > remaining_capacity()) {
+        throw runtime_error("ByteStream::stage_write: bytes can't be staged there");
+    }
+    buffer->stage(offset, data);
 }
 
+//! \param[in] len bytes will be copied from the output side of the buffer
+string ByteStream::peek_output(const size_t len) const { return buffer->peek(min(len, buffer_size())); }
+
+//! \param[in] len bytes will be sliced from the output side of the buffer
+BufferList ByteStream::peek_buffers(const size_t len) const { return buffer->peek_buffers(min(len, buffer_size())); }
+
+//! \param[in] len bytes will be viewed in place on the output side of the buffer
+BufferViewList ByteStream::peek_spans(const size_t len) const { return buffer->peek_spans(min(len, buffer_size())); }
+
+//! \param[in] len bytes will be viewed in place on the output side of the buffer
+string_view ByteStream::peek_view(const size_t len) const { return buffer->peek_view(min(len, buffer_size())); }
+
 //! \param[in] len bytes will be removed from the output side of the buffer
 void ByteStream::pop_output(const size_t len) {
-    size_t size = buffer_size();
-    if (len >= size) {
-        b_read += size;
-        head = tail;
-    } else {
-        b_read += len;
-        head = (head + len) % buf_len;
-    }
+    const size_t popped = min(len, buffer_size());
+    buffer->pop(popped);
+    b_read += popped;
 }
 
 //! Read (i.e., copy and then pop) the next "len" bytes of the stream
@@ -83,9 +115,9 @@ void ByteStream::end_input() { iseof = true; }
 //! 'true' if the stream input has ended
 bool ByteStream::input_ended() const { return iseof; }
 
-size_t ByteStream::buffer_size() const { return head <= tail ? tail - head : tail + buf_len - head; }
+size_t ByteStream::buffer_size() const { return buffer->size(); }
 
-bool ByteStream::buffer_empty() const { return tail == head; }
+bool ByteStream::buffer_empty() const { return buffer_size() == 0; }
 
 bool ByteStream::eof() const { return buffer_empty() && input_ended(); }
 
@@ -1,7 +1,14 @@
 #ifndef SPONGE_LIBSPONGE_BYTE_STREAM_HH
 #define SPONGE_LIBSPONGE_BYTE_STREAM_HH
 
+#include "buffer.hh"
+#include "stream_storage.hh"
+
+#include <memory>
 #include <string>
+#include <string_view>
+#include <sys/uio.h>
+#include <utility>
 #include <vector>
 
 //! \brief An in-order byte stream.
@@ -10,12 +17,19 @@
 //! side.  The byte stream is finite: the writer can end the input,
 //! and then no more bytes can be written.
 class ByteStream {
+  public:
+    //! \brief How the stream holds the bytes that have been written but not yet read
+    enum class Storage {
+        Ring,      //!< a ring of `capacity` bytes, allocated up front (see RingStorage)
+        Chunked,   //!< a queue of reference-counted Buffers, adopted from the writer (see ChunkedStorage)
+        Mirrored,  //!< a ring mapped twice, so its contents are always contiguous (see MirroredStorage)
+        Paged      //!< pages taken from a pool as bytes arrive and returned as they are read (see PagedStorage)
+    };
+
   private:
     // Your code here -- add private members as necessary.
-    std::vector<unsigned char> buffer;
+    std::unique_ptr<StreamStorage> buffer;
     const size_t capacity;
-    const size_t buf_len;
-    size_t head, tail;
     bool iseof;
     size_t b_read, b_written;
 
@@ -28,7 +42,7 @@ class ByteStream {
 
   public:
     //! Construct a stream with room for `capacity` bytes.
-    ByteStream(const size_t capacity);
+    ByteStream(const size_t capacity, const Storage storage = Storage::Ring);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -38,9 +52,38 @@ class ByteStream {
     //! \returns the number of bytes accepted into the stream
     size_t write(const std::string &data);
 
+    //! Write a string of bytes into the stream, taking ownership of its storage
+    //! instead of copying it if the stream is Storage::Chunked.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(std::string &&data) { return write(Buffer{std::move(data)}); }
+
+    //! Write a Buffer into the stream, adopting it (or a prefix of it) without
+    //! copying if the stream is Storage::Chunked.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(Buffer data);
+
     //! \returns the number of additional bytes that the stream has space for
     size_t remaining_capacity() const;
 
+    //! The stream's free space, as spans that can be filled in place (e.g. by [readv(2)](\ref man2::readv))
+    //! and then made readable with commit_write(). A Storage::Ring stream returns at most two spans,
+    //! split where the ring wraps; a Storage::Paged stream offers at most PagedStorage::MAX_WRITABLE_PAGES
+    //! pages of its free space at a time, one span per page.
+    //! \note The spans are only valid until the stream is next modified.
+    std::vector<iovec> writable_spans();
+
+    //! Make the first "len" bytes of writable_spans() readable, as if they had been written
+    void commit_write(const size_t len);
+
+    //! \returns `true` if bytes can be staged ahead of the end of the stream with stage_write()
+    //! (true unless the stream is Storage::Chunked)
+    bool can_stage() const { return buffer->can_stage(); }
+
+    //! Copy bytes into the stream's free space, "offset" bytes past the last byte written. They stay
+    //! there, unreadable, until commit_write() reaches past them (e.g. once the bytes before them
+    //! have been written).
+    void stage_write(const size_t offset, std::string_view data);
+
     //! Signal that the byte stream has reached its ending
     void end_input();
 
@@ -55,6 +98,22 @@ class ByteStream {
     //! \returns a string
     std::string peek_output(const size_t len) const;
 
+    //! Peek at next "len" bytes of the stream without copying them
+    //! \returns a BufferList that shares storage with the stream if it is Storage::Chunked
+    //! (otherwise, a BufferList holding one copy of the bytes)
+    BufferList peek_buffers(const size_t len) const;
+
+    //! Peek at next "len" bytes of the stream in place, as views suitable for
+    //! [writev(2)](\ref man2::writev). A Storage::Ring stream returns at most two spans,
+    //! split where the ring wraps.
+    //! \note The views are only valid until the stream is next modified.
+    BufferViewList peek_spans(const size_t len) const;
+
+    //! Peek in place at the longest prefix of the next "len" bytes that is contiguous in memory.
+    //! For a Storage::Mirrored stream, this is always all of the next "len" bytes (or all of the buffer).
+    //! \note The view is only valid until the stream is next modified.
+    std::string_view peek_view(const size_t len) const;
+
     //! Remove bytes from the buffer
     void pop_output(const size_t len);
 
@@ -86,6 +145,9 @@ class ByteStream {
 
     //! Total number of bytes popped
     size_t bytes_read() const;
+
+    //! Number of bytes of memory held by the stream's storage (see StreamStorage::footprint)
+    size_t footprint() const { return buffer->footprint(); }
     //!@}
 };
 
@@ -0,0 +1,429 @@
+#include "congestion_control.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+unique_ptr<CongestionControl> CongestionControl::make(const Algorithm algorithm,
+                                                      const size_t mss,
+                                                      const size_t initial_window) {
+    switch (algorithm) {
+        case Algorithm::NewReno:
+            return make_unique<NewReno>(mss, initial_window);
+        case Algorithm::Cubic:
+            return make_unique<Cubic>(mss, initial_window);
+        case Algorithm::Bbr:
+            return make_unique<Bbr>(mss, initial_window);
+        case Algorithm::Ledbat:
+            return make_unique<Ledbat>(mss, initial_window);
+        case Algorithm::None:
+        default:
+            return make_unique<NoCongestionControl>();
+    }
+}
+
+size_t NoCongestionControl::cwnd() const { return numeric_limits<size_t>::max(); }
+
+NewReno::NewReno(const size_t mss, const size_t initial_window)
+    : _mss(mss), _cwnd(max(initial_window, mss)), _ssthresh(numeric_limits<size_t>::max()) {}
+
+void NewReno::reduce_ssthresh(const size_t bytes_in_flight) { _ssthresh = max(bytes_in_flight / 2, 2 * _mss); }
+
+void NewReno::grow_in_avoidance(const AckSample &ack) {
+    _bytes_acked_in_avoidance += ack.bytes_acked;
+    if (_bytes_acked_in_avoidance >= _cwnd) {
+        _bytes_acked_in_avoidance -= _cwnd;
+        _cwnd += _mss;
+    }
+}
+
+void NewReno::on_ack(const AckSample &ack) {
+    if (_recovery_point) {
+        if (ack.ackno >= _recovery_point.value()) {
+            // full ack: leave fast recovery with the reduced window (RFC 6582 3.2, step 3)
+            _cwnd = min(_ssthresh, max(ack.bytes_in_flight, _mss) + _mss);
+            _recovery_point.reset();
+        } else {
+            // partial ack: deflate by the bytes acknowledged, then add back one MSS (RFC 6582 3.2, step 4)
+            _cwnd -= min(_cwnd - _mss, ack.bytes_acked);
+            if (ack.bytes_acked >= _mss) {
+                _cwnd += _mss;
+            }
+        }
+        return;
+    }
+
+    if (_cwnd < _ssthresh) {
+        // slow start
+        _cwnd += min(ack.bytes_acked, _mss);
+    } else {
+        grow_in_avoidance(ack);
+    }
+}
+
+void NewReno::on_duplicate_ack(const AckSample &) {
+    if (_recovery_point) {
+        _cwnd += _mss;
+    }
+}
+
+void NewReno::on_loss(const uint64_t recovery_point, const size_t bytes_in_flight) {
+    if (_recovery_point) {
+        return;
+    }
+    reduce_ssthresh(bytes_in_flight);
+    _cwnd = _ssthresh + 3 * _mss;
+    _bytes_acked_in_avoidance = 0;
+    _recovery_point = recovery_point;
+}
+
+void NewReno::on_rto(const size_t bytes_in_flight) {
+    reduce_ssthresh(bytes_in_flight);
+    _cwnd = _mss;
+    _bytes_acked_in_avoidance = 0;
+    _recovery_point.reset();
+}
+
+void NewReno::on_ecn(const size_t bytes_in_flight) {
+    reduce_ssthresh(bytes_in_flight);
+    _cwnd = _ssthresh;
+    _bytes_acked_in_avoidance = 0;
+}
+
+void Cubic::on_ack(const AckSample &ack) {
+    if (ack.rtt_ms.has_value()) {
+        _min_rtt = min(_min_rtt.value_or(numeric_limits<uint64_t>::max()), ack.rtt_ms.value());
+    }
+    NewReno::on_ack(ack);
+}
+
+//! \details The window at the loss is taken to be the flight size, as in NewReno, since the sender's
+//! window may have been limited by the receiver rather than by cwnd.
+void Cubic::reduce_ssthresh(const size_t bytes_in_flight) {
+    const double window = static_cast<double>(max(bytes_in_flight, _mss)) / static_cast<double>(_mss);
+    // fast convergence: a flow whose window is shrinking makes room for newer ones
+    _w_max = window < _w_max ? window * (1 + BETA) / 2 : window;
+    _ssthresh = max(static_cast<size_t>(lround(window * BETA * static_cast<double>(_mss))), 2 * _mss);
+    _epoch_start.reset();
+}
+
+//! \details Each ack moves the window towards W(t + RTT), the cubic function one round trip ahead,
+//! by (W(t + RTT) - cwnd) / cwnd segments per segment acknowledged; the target is clamped to
+//! [cwnd, 1.5 cwnd]. The Reno-friendly estimate grows by ALPHA segments per window acknowledged,
+//! and is the target instead whenever it is the larger. The growth is added a whole segment at a
+//! time, as NewReno's is: a window that opened by a few bytes per ack would release a few-byte
+//! segment per ack, and each of their acks would do the same.
+void Cubic::grow_in_avoidance(const AckSample &ack) {
+    const double mss = static_cast<double>(_mss);
+    const double cwnd = static_cast<double>(_cwnd) / mss;
+    if (not _epoch_start.has_value()) {
+        _epoch_start = ack.now_ms;
+        _origin = max(_w_max, cwnd);
+        _k = cbrt((_origin - cwnd) / C);
+        _w_est = cwnd;
+    }
+
+    const double t = static_cast<double>(ack.now_ms - _epoch_start.value() + _min_rtt.value_or(0)) / 1000.0;
+    const double w_cubic = C * pow(t - _k, 3) + _origin;
+    _w_est += ALPHA * static_cast<double>(ack.bytes_acked) / static_cast<double>(_cwnd);
+
+    const double target = w_cubic < _w_est ? _w_est : min(max(w_cubic, cwnd), 1.5 * cwnd);
+    _growth += (target - cwnd) / cwnd * static_cast<double>(ack.bytes_acked);
+    if (_growth >= mss) {
+        const double segments = floor(_growth / mss);
+        _cwnd += static_cast<size_t>(segments) * _mss;
+        _growth -= segments * mss;
+    }
+}
+
+void Ledbat::sample_delay(const uint64_t rtt_ms, const uint64_t now_ms) {
+    _current_delays.push_back(rtt_ms);
+    if (_current_delays.size() > CURRENT_FILTER) {
+        _current_delays.pop_front();
+    }
+
+    const uint64_t minute = now_ms / 60000;
+    if (not _base_delays.empty() and _base_delays.back().first == minute) {
+        _base_delays.back().second = min(_base_delays.back().second, rtt_ms);
+    } else {
+        _base_delays.emplace_back(minute, rtt_ms);
+    }
+    while (_base_delays.front().first + BASE_HISTORY <= minute) {
+        _base_delays.pop_front();
+    }
+}
+
+optional<uint64_t> Ledbat::queueing_delay() const {
+    if (_current_delays.empty()) {
+        return nullopt;
+    }
+    const uint64_t current = *min_element(_current_delays.begin(), _current_delays.end());
+    const auto base = min_element(_base_delays.begin(), _base_delays.end(), [](const auto &a, const auto &b) {
+        return a.second < b.second;
+    });
+    return current - base->second;
+}
+
+void Ledbat::on_ack(const AckSample &ack) {
+    if (ack.rtt_ms.has_value()) {
+        sample_delay(ack.rtt_ms.value(), ack.now_ms);
+    }
+    const optional<uint64_t> delay = queueing_delay();
+    if (_cwnd < _ssthresh and delay.has_value() and 4 * delay.value() >= 3 * TARGET_MS) {
+        _ssthresh = _cwnd;
+    }
+    NewReno::on_ack(ack);
+}
+
+//! \details As with CUBIC, the window changes a whole segment at a time. It is kept within
+//! ALLOWED_INCREASE_SEGMENTS of the flight size, so that it can't grow while the application
+//! leaves it unused, and at least MIN_CWND_SEGMENTS.
+void Ledbat::grow_in_avoidance(const AckSample &ack) {
+    const optional<uint64_t> delay = queueing_delay();
+    if (not delay.has_value()) {
+        NewReno::grow_in_avoidance(ack);
+        return;
+    }
+    const double mss = static_cast<double>(_mss);
+    const double window = static_cast<double>(_cwnd) / mss;
+    const double off_target = (static_cast<double>(TARGET_MS) - static_cast<double>(delay.value())) / TARGET_MS;
+    const double per_rtt = off_target >= 0 ? GAIN * off_target : max(window * off_target, -window / 2);
+    _growth += per_rtt * mss * static_cast<double>(ack.bytes_acked) / static_cast<double>(_cwnd);
+
+    const double segments = trunc(_growth / mss);
+    _growth -= segments * mss;
+    const double cwnd = static_cast<double>(_cwnd) + segments * mss;
+    const size_t max_cwnd = ack.bytes_in_flight + ack.bytes_acked + ALLOWED_INCREASE_SEGMENTS * _mss;
+    _cwnd = max(min(static_cast<size_t>(max(cwnd, 0.0)), max_cwnd), MIN_CWND_SEGMENTS * _mss);
+}
+
+Bbr::Bbr(const size_t mss, const size_t initial_window)
+    : _mss(mss), _cwnd(max(initial_window, mss)), _initial_cwnd(_cwnd) {}
+
+size_t Bbr::ssthresh() const { return numeric_limits<size_t>::max(); }
+
+optional<double> Bbr::pacing_rate() const { return _pacing_rate; }
+
+double Bbr::pacing_gain() const {
+    switch (_mode) {
+        case Mode::Startup:
+            return HIGH_GAIN;
+        case Mode::Drain:
+            return 1 / HIGH_GAIN;
+        case Mode::ProbeBW:
+            return PROBE_BW_GAINS[_cycle_index];
+        case Mode::ProbeRTT:
+        default:
+            return 1;
+    }
+}
+
+//! \details Until there is a model, this is the initial window.
+size_t Bbr::inflight_target(const double gain) const {
+    if (not _rt_prop.has_value() or btl_bw() == 0) {
+        return _initial_cwnd;
+    }
+    const double bdp = btl_bw() * static_cast<double>(max(_rt_prop.value(), uint64_t{1}));
+    return static_cast<size_t>(gain * bdp) + 3 * _mss;
+}
+
+void Bbr::restore_cwnd() {
+    _cwnd = max(_cwnd, _prior_cwnd);
+    _prior_cwnd = 0;
+}
+
+//! \details A round ends when a segment sent after the previous round ended is delivered. Packet
+//! conservation ends with the round a loss was found in, and the window cut by a timeout is restored
+//! with the round it happened in.
+void Bbr::update_round(const AckSample &ack) {
+    _round_start = false;
+    if (ack.delivered == 0 or ack.prior_delivered < _next_round_delivered) {
+        return;
+    }
+    _next_round_delivered = ack.delivered;
+    _round_count++;
+    _round_start = true;
+    while (_bw_samples.size() > 1 and _bw_samples.front().first + BW_FILTER_ROUNDS <= _round_count) {
+        _bw_samples.pop_front();
+    }
+    if (_conservation_round.has_value() and _round_count > _conservation_round.value()) {
+        _conservation_round.reset();
+    }
+    if (_rto_round.has_value() and _round_count > _rto_round.value()) {
+        _rto_round.reset();
+        restore_cwnd();
+    }
+}
+
+//! \details A sample taken while the application limited sending only says the bandwidth is at least
+//! that much, so it is used only if it raises the estimate.
+void Bbr::update_btl_bw(const AckSample &ack) {
+    if (not ack.delivery_rate.has_value()) {
+        return;
+    }
+    const double rate = ack.delivery_rate.value();
+    if (ack.app_limited and rate < btl_bw()) {
+        return;
+    }
+    while (not _bw_samples.empty() and _bw_samples.back().second <= rate) {
+        _bw_samples.pop_back();
+    }
+    _bw_samples.emplace_back(_round_count, rate);
+}
+
+bool Bbr::update_rt_prop(const AckSample &ack) {
+    const bool expired = _rt_prop.has_value() and ack.now_ms > _rt_prop_stamp + RTPROP_FILTER_MS;
+    if (ack.rtt_ms.has_value() and (not _rt_prop.has_value() or ack.rtt_ms.value() <= _rt_prop.value() or expired)) {
+        _rt_prop = ack.rtt_ms;
+        _rt_prop_stamp = ack.now_ms;
+    }
+    return expired;
+}
+
+void Bbr::check_full_pipe(const AckSample &ack) {
+    if (_filled_pipe or not _round_start or ack.app_limited) {
+        return;
+    }
+    if (btl_bw() >= _full_bw * 1.25) {
+        _full_bw = btl_bw();
+        _full_bw_count = 0;
+        return;
+    }
+    _filled_pipe = ++_full_bw_count >= 3;
+}
+
+//! \details The draft starts the gain cycle at a random phase other than the draining one; this starts
+//! it at the first cruising phase, so that runs are reproducible.
+void Bbr::enter_probe_bw(const uint64_t now_ms) {
+    _mode = Mode::ProbeBW;
+    _cycle_index = 2;
+    _cycle_stamp = now_ms;
+}
+
+//! \details A ProbeBW phase lasts a round-trip propagation time, except that probing goes on until
+//! the extra data is in flight (or a loss shows there's no room for it), and draining stops early
+//! once the extra data has left.
+void Bbr::advance_mode(const AckSample &ack, const bool rt_prop_expired) {
+    if (_mode == Mode::Startup and _filled_pipe) {
+        _mode = Mode::Drain;
+    }
+    if (_mode == Mode::Drain and ack.bytes_in_flight <= inflight_target(1)) {
+        enter_probe_bw(ack.now_ms);
+    }
+
+    if (_mode == Mode::ProbeBW) {
+        const bool full_length = ack.now_ms - _cycle_stamp > _rt_prop.value_or(0);
+        const double gain = pacing_gain();
+        bool next = full_length;
+        if (gain > 1) {
+            next = full_length and (in_recovery() or ack.bytes_in_flight >= inflight_target(gain));
+        } else if (gain < 1) {
+            next = full_length or ack.bytes_in_flight <= inflight_target(1);
+        }
+        if (next) {
+            _cycle_index = (_cycle_index + 1) % size(PROBE_BW_GAINS);
+            _cycle_stamp = ack.now_ms;
+        }
+    }
+
+    if (_mode != Mode::ProbeRTT and rt_prop_expired) {
+        _mode = Mode::ProbeRTT;
+        save_cwnd();
+        _probe_rtt_done_stamp.reset();
+    }
+    if (_mode == Mode::ProbeRTT) {
+        if (not _probe_rtt_done_stamp.has_value()) {
+            if (ack.bytes_in_flight <= MIN_CWND_SEGMENTS * _mss) {
+                _probe_rtt_done_stamp = ack.now_ms + PROBE_RTT_MS;
+                _probe_rtt_round_done = false;
+                _next_round_delivered = ack.delivered;
+            }
+        } else {
+            _probe_rtt_round_done = _probe_rtt_round_done or _round_start;
+            if (_probe_rtt_round_done and ack.now_ms > _probe_rtt_done_stamp.value()) {
+                _rt_prop_stamp = ack.now_ms;
+                restore_cwnd();
+                if (_filled_pipe) {
+                    enter_probe_bw(ack.now_ms);
+                } else {
+                    _mode = Mode::Startup;
+                }
+            }
+        }
+    }
+}
+
+//! \details The rate starts at HIGH_GAIN times the initial window per round trip, once there is a
+//! round-trip time. Until the pipe is full, it only goes up, so that a sample from a round that was
+//! short of data can't slow Startup down.
+void Bbr::set_pacing_rate() {
+    if (not _pacing_rate.has_value() and _rt_prop.has_value()) {
+        const double rate = HIGH_GAIN * static_cast<double>(_initial_cwnd);
+        _pacing_rate = rate / static_cast<double>(max(_rt_prop.value(), uint64_t{1}));
+    }
+    const double rate = pacing_gain() * btl_bw();
+    if (btl_bw() > 0 and _pacing_rate.has_value() and (_filled_pipe or rate > _pacing_rate.value())) {
+        _pacing_rate = rate;
+    }
+}
+
+//! \details The window grows by the bytes acknowledged, towards the gain times the BDP (and freely
+//! until the pipe is full). For the first round of loss recovery it is held at what is in flight
+//! plus what was just delivered (packet conservation).
+void Bbr::set_cwnd(const AckSample &ack) {
+    const size_t min_cwnd = MIN_CWND_SEGMENTS * _mss;
+    if (_conservation_round.has_value()) {
+        _cwnd = max(_cwnd, ack.bytes_in_flight + ack.bytes_acked);
+    } else if (_filled_pipe) {
+        _cwnd = min(_cwnd + ack.bytes_acked, inflight_target(cwnd_gain()));
+    } else if (_cwnd < inflight_target(cwnd_gain()) or ack.delivered < _initial_cwnd) {
+        _cwnd += ack.bytes_acked;
+    }
+    _cwnd = max(_cwnd, min_cwnd);
+    if (_mode == Mode::ProbeRTT) {
+        _cwnd = min(_cwnd, min_cwnd);
+    }
+}
+
+void Bbr::on_ack(const AckSample &ack) {
+    if (_recovery_point.has_value() and ack.ackno >= _recovery_point.value()) {
+        _recovery_point.reset();
+        _conservation_round.reset();
+        restore_cwnd();
+    }
+
+    update_round(ack);
+    update_btl_bw(ack);
+    const bool rt_prop_expired = update_rt_prop(ack);
+    check_full_pipe(ack);
+    advance_mode(ack, rt_prop_expired);
+    set_pacing_rate();
+    set_cwnd(ack);
+}
+
+//! \details Segments SACKed by a duplicate ack still tell of the bandwidth.
+void Bbr::on_duplicate_ack(const AckSample &ack) {
+    update_round(ack);
+    update_btl_bw(ack);
+    set_pacing_rate();
+}
+
+void Bbr::on_loss(const uint64_t recovery_point, const size_t bytes_in_flight) {
+    if (_recovery_point.has_value()) {
+        return;
+    }
+    _recovery_point = recovery_point;
+    _conservation_round = _round_count;
+    save_cwnd();
+    _cwnd = max(bytes_in_flight + _mss, MIN_CWND_SEGMENTS * _mss);
+}
+
+void Bbr::on_rto(const size_t) {
+    _recovery_point.reset();
+    _conservation_round.reset();
+    _rto_round = _round_count;
+    save_cwnd();
+    _cwnd = _mss;
+}
@@ -0,0 +1,317 @@
+#ifndef SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+#define SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <utility>
+
+//! \brief What a TCPSender tells its CongestionControl about an acknowledgment
+struct AckSample {
+    uint64_t ackno;                    //!< absolute ackno
+    size_t bytes_acked;                //!< payload bytes newly acknowledged (zero for a duplicate ack)
+    size_t bytes_in_flight;            //!< sequence numbers still outstanding once this ack is processed
+    uint64_t now_ms;                   //!< the sender's clock (the sum of the times passed to TCPSender::tick)
+    std::optional<uint64_t> rtt_ms{};  //!< round-trip time of the newest segment acked, unless it was retransmitted
+
+    //! \name Delivery-rate sample
+    //! Taken from the most recently sent of the segments this ack delivered (acknowledged or SACKed), if any
+    //!@{
+    std::optional<double> delivery_rate{};  //!< sequence numbers delivered per millisecond while it was in flight
+    bool app_limited{false};                //!< it was sent while the application, not the network, limited sending
+    uint64_t delivered{0};                  //!< sequence numbers delivered so far, on the connection
+    uint64_t prior_delivered{0};            //!< `delivered` when it was sent
+    //!@}
+};
+
+//! \brief A congestion controller, owned by a TCPSender
+//! \details The sender reports acknowledgments and losses, and never has more than
+//! min(cwnd(), receiver's window) sequence numbers outstanding.
+class CongestionControl {
+  public:
+    //! \brief The available congestion control algorithms
+    enum class Algorithm {
+        None,     //!< no congestion window: only the receiver's window limits the sender
+        NewReno,  //!< slow start, congestion avoidance and fast recovery (RFC 5681 and RFC 6582)
+        Cubic,    //!< NewReno, with CUBIC's window growth and reduction (RFC 9438)
+        Bbr,      //!< a model of the path's bottleneck bandwidth and round-trip time, rather than losses (BBR)
+        Ledbat    //!< yields to other traffic once queueing delay nears a target: for background transfers
+    };
+
+    //! \brief Construct the controller for an algorithm
+    //! \param[in] mss is the largest payload the sender puts in a segment
+    //! \param[in] initial_window is the initial congestion window, in bytes
+    static std::unique_ptr<CongestionControl> make(const Algorithm algorithm,
+                                                   const size_t mss,
+                                                   const size_t initial_window);
+
+    //! \brief An ack acknowledged new data
+    virtual void on_ack(const AckSample &ack) = 0;
+
+    //! \brief An ack acknowledged nothing new while data was outstanding
+    virtual void on_duplicate_ack(const AckSample &) {}
+
+    //! \brief The sender inferred a loss without a timeout (e.g. from duplicate acks) and retransmitted
+    //! \param[in] recovery_point is the sender's next seqno; the loss episode ends when it is acknowledged
+    //! \param[in] bytes_in_flight is the number of sequence numbers outstanding
+    virtual void on_loss(const uint64_t recovery_point, const size_t bytes_in_flight) = 0;
+
+    //! \brief The retransmission timer expired
+    //! \param[in] bytes_in_flight is the number of sequence numbers outstanding
+    virtual void on_rto(const size_t bytes_in_flight) = 0;
+
+    //! \brief The receiver echoed a congestion mark (ECN, RFC 3168): nothing was lost or retransmitted
+    //! \details The sender reports at most one per window of data, and none while in recovery.
+    //! \param[in] bytes_in_flight is the number of sequence numbers outstanding
+    virtual void on_ecn(const size_t) {}
+
+    //! \returns the congestion window, in bytes
+    virtual size_t cwnd() const = 0;
+
+    //! \returns the slow start threshold, in bytes
+    virtual size_t ssthresh() const = 0;
+
+    //! \returns `true` if the controller is recovering from a loss reported by on_loss()
+    virtual bool in_recovery() const { return false; }
+
+    //! \returns the rate to pace segments at, in bytes per millisecond, if the controller sets one
+    virtual std::optional<double> pacing_rate() const { return std::nullopt; }
+
+    virtual ~CongestionControl() = default;
+};
+
+//! \brief No congestion control: the congestion window is unlimited
+class NoCongestionControl : public CongestionControl {
+  public:
+    void on_ack(const AckSample &) override {}
+    void on_loss(const uint64_t, const size_t) override {}
+    void on_rto(const size_t) override {}
+    size_t cwnd() const override;
+    size_t ssthresh() const override { return cwnd(); }
+};
+
+//! \brief NewReno congestion control
+//! \details In slow start the window grows by up to one MSS per ack, and in congestion avoidance
+//! by one MSS per window's worth of acknowledged bytes. A loss reported by on_loss() halves the
+//! window and starts fast recovery, in which each duplicate ack inflates the window by one MSS and
+//! each partial ack deflates it by the bytes acknowledged; recovery ends when the recovery point
+//! is acknowledged. A timeout halves ssthresh and drops the window to one MSS. An echoed congestion
+//! mark sets ssthresh as a loss would, and the window to it, without fast recovery.
+class NewReno : public CongestionControl {
+  private:
+    size_t _bytes_acked_in_avoidance{0};       //!< bytes acked since the window last grew in congestion avoidance
+    std::optional<uint64_t> _recovery_point{};  //!< set while in fast recovery
+
+  protected:
+    size_t _mss;
+    size_t _cwnd;
+    size_t _ssthresh;
+
+    //! \brief Set ssthresh after a loss or a timeout: to half the flight size, but at least two segments
+    virtual void reduce_ssthresh(const size_t bytes_in_flight);
+
+    //! \brief Grow the window for an ack in congestion avoidance: by one MSS per window's worth of bytes acked
+    virtual void grow_in_avoidance(const AckSample &ack);
+
+  public:
+    NewReno(const size_t mss, const size_t initial_window);
+
+    void on_ack(const AckSample &ack) override;
+    void on_duplicate_ack(const AckSample &ack) override;
+    void on_loss(const uint64_t recovery_point, const size_t bytes_in_flight) override;
+    void on_rto(const size_t bytes_in_flight) override;
+    void on_ecn(const size_t bytes_in_flight) override;
+    size_t cwnd() const override { return _cwnd; }
+    size_t ssthresh() const override { return _ssthresh; }
+    bool in_recovery() const override { return _recovery_point.has_value(); }
+};
+
+//! \brief CUBIC congestion control (RFC 9438)
+//! \details Slow start and fast recovery are NewReno's. A loss reduces the window to BETA times the flight
+//! size, and remembers the flight size as W_max (or less, if the window was already shrinking: fast
+//! convergence). In congestion avoidance the window then follows W(t) = C (t - K)^3 + W_max, in segments,
+//! where t is the time since the avoidance epoch began and K the time W(t) takes to climb back to W_max:
+//! concave up to W_max, flat around it and convex beyond, independent of the round-trip time. It never
+//! grows more slowly than an estimate of what Reno would have reached (the Reno-friendly region).
+class Cubic : public NewReno {
+  public:
+    static constexpr double C = 0.4;     //!< scales the cubic growth, in segments per second cubed
+    static constexpr double BETA = 0.7;  //!< multiplicative decrease factor
+    //! Reno-friendly additive increase per round trip, in segments, that matches Reno's average rate with BETA
+    static constexpr double ALPHA = 3 * (1 - BETA) / (1 + BETA);
+
+  private:
+    double _w_max{0};                         //!< window before the latest reduction, in segments
+    std::optional<uint64_t> _epoch_start{};  //!< when the current congestion avoidance epoch began
+    double _origin{0};                        //!< the window W(t) levels off at, in segments
+    double _k{0};                             //!< seconds from the epoch's start until W(t) reaches `_origin`
+    double _w_est{0};                         //!< Reno-friendly window estimate, in segments
+    double _growth{0};                        //!< bytes of growth not yet added to the window, less than a segment
+    std::optional<uint64_t> _min_rtt{};       //!< least round-trip time sampled, in milliseconds
+
+  protected:
+    void reduce_ssthresh(const size_t bytes_in_flight) override;
+    void grow_in_avoidance(const AckSample &ack) override;
+
+  public:
+    Cubic(const size_t mss, const size_t initial_window) : NewReno(mss, initial_window) {}
+
+    void on_ack(const AckSample &ack) override;
+};
+
+//! \brief LEDBAT, low-priority congestion control (RFC 6817, with the decrease of LEDBAT++)
+//! \details Queueing delay is estimated from the sender's RTT samples, as the current delay (the least of
+//! the last CURRENT_FILTER samples) less the base delay (the least seen in the last BASE_HISTORY minutes).
+//! In congestion avoidance the window grows by up to GAIN segments per round trip while the queueing
+//! delay is under TARGET_MS, in proportion to how far under it is, and once it is over shrinks in
+//! proportion to the excess: by the window times (delay / TARGET_MS - 1) per round trip, at most half.
+//! So a background transfer keeps the queue it adds to a path below TARGET_MS, and gives the path up
+//! within a few round trips when other traffic builds a queue. Slow start ends once the queueing delay
+//! reaches three quarters of the target, and losses are handled as in NewReno.
+class Ledbat : public NewReno {
+  public:
+    static constexpr uint64_t TARGET_MS = 25;  //!< queueing delay to stay under (RFC 6817 allows up to 100)
+    static constexpr double GAIN = 1;          //!< segments of growth per round trip with no queueing delay
+    static constexpr size_t CURRENT_FILTER = 4;             //!< RTT samples the current delay is the least of
+    static constexpr size_t BASE_HISTORY = 10;              //!< minutes the base delay is the least over
+    static constexpr size_t MIN_CWND_SEGMENTS = 2;          //!< the window never shrinks below this
+    static constexpr size_t ALLOWED_INCREASE_SEGMENTS = 1;  //!< most the window may exceed the flight size by
+
+  private:
+    std::deque<uint64_t> _current_delays{};                    //!< the last CURRENT_FILTER RTT samples
+    std::deque<std::pair<uint64_t, uint64_t>> _base_delays{};  //!< (minute, least RTT sampled in it)
+    double _growth{0};  //!< bytes of growth (or shrinkage) not yet applied to the window, under a segment
+
+    void sample_delay(const uint64_t rtt_ms, const uint64_t now_ms);
+
+  protected:
+    void grow_in_avoidance(const AckSample &ack) override;
+
+  public:
+    Ledbat(const size_t mss, const size_t initial_window) : NewReno(mss, initial_window) {}
+
+    void on_ack(const AckSample &ack) override;
+
+    //! \returns the estimated queueing delay, in milliseconds, once there has been an RTT sample
+    std::optional<uint64_t> queueing_delay() const;
+};
+
+//! \brief BBR congestion control (BBR v1, draft-cardwell-iccrg-bbr-congestion-control-00)
+//! \details Rather than reacting to losses, BBR models the path: its bottleneck bandwidth is the windowed
+//! maximum of the delivery rates sampled over the last BW_FILTER_ROUNDS round trips, and its round-trip
+//! propagation time the minimum RTT seen in the last RTPROP_FILTER_MS. It paces at a gain times the
+//! bandwidth, and caps the data in flight at a gain times their product (the BDP). The gains depend on
+//! the mode:
+//! - Startup doubles the sending rate every round trip (at HIGH_GAIN), until three rounds in a row
+//!   fail to raise the bandwidth estimate by a quarter: the pipe is full.
+//! - Drain paces at 1 / HIGH_GAIN until the queue Startup built has drained, down to one BDP in flight.
+//! - ProbeBW cycles through PROBE_BW_GAINS, a phase per round-trip propagation time: one probing for
+//!   more bandwidth at 1.25, one draining what that queued at 0.75, then six cruising at 1.
+//! - ProbeRTT, entered when the round-trip estimate has gone RTPROP_FILTER_MS without being refreshed,
+//!   caps the window at MIN_CWND_SEGMENTS for PROBE_RTT_MS and a round trip, so that the queue empties
+//!   and a fresh minimum can be measured.
+//!
+//! A loss reported by on_loss() limits the window to what is in flight (packet conservation) until the
+//! recovery point is acknowledged, then restores it; a timeout drops it to one MSS until a round trip
+//! has passed. Echoed congestion marks are ignored, as in BBR v1.
+class Bbr : public CongestionControl {
+  public:
+    static constexpr double HIGH_GAIN = 2.885;  //!< 2/ln(2): the smallest gain that doubles the rate each round
+    static constexpr double CWND_GAIN = 2;      //!< the window, per BDP, in Drain and ProbeBW
+    static constexpr double PROBE_BW_GAINS[] = {1.25, 0.75, 1, 1, 1, 1, 1, 1};  //!< ProbeBW's pacing gains
+    static constexpr uint64_t BW_FILTER_ROUNDS = 10;
+    static constexpr uint64_t RTPROP_FILTER_MS = 10000;
+    static constexpr uint64_t PROBE_RTT_MS = 200;
+    static constexpr size_t MIN_CWND_SEGMENTS = 4;
+
+    //! \brief BBR's modes
+    enum class Mode { Startup, Drain, ProbeBW, ProbeRTT };
+
+  private:
+    size_t _mss;
+    size_t _cwnd;
+    size_t _initial_cwnd;
+    Mode _mode{Mode::Startup};
+
+    //! \name The model
+    //!@{
+    std::deque<std::pair<uint64_t, double>> _bw_samples{};  //!< (round, rate), rates decreasing: the max filter
+    std::optional<uint64_t> _rt_prop{};                     //!< in milliseconds
+    uint64_t _rt_prop_stamp{0};                             //!< when `_rt_prop` was last set
+    std::optional<double> _pacing_rate{};                   //!< in bytes per millisecond
+    //!@}
+
+    //! \name Round trips, counted by deliveries
+    //!@{
+    uint64_t _round_count{0};
+    uint64_t _next_round_delivered{0};  //!< a segment sent once this much has been delivered ends the round
+    bool _round_start{false};           //!< the ack being processed ended a round
+    //!@}
+
+    //! \name Startup
+    //!@{
+    bool _filled_pipe{false};
+    double _full_bw{0};
+    unsigned _full_bw_count{0};  //!< rounds without a quarter more bandwidth
+    //!@}
+
+    //! \name ProbeBW and ProbeRTT
+    //!@{
+    size_t _cycle_index{0};
+    uint64_t _cycle_stamp{0};
+    std::optional<uint64_t> _probe_rtt_done_stamp{};
+    bool _probe_rtt_round_done{false};
+    //!@}
+
+    //! \name Loss recovery
+    //!@{
+    std::optional<uint64_t> _recovery_point{};
+    std::optional<uint64_t> _conservation_round{};  //!< the round a loss was found in, until the next one starts
+    std::optional<uint64_t> _rto_round{};           //!< the round a timeout happened in, until the next one starts
+    size_t _prior_cwnd{0};                          //!< the window before a loss or timeout, restored when it's over
+    //!@}
+
+    double pacing_gain() const;
+    double cwnd_gain() const { return _mode == Mode::Startup or _mode == Mode::Drain ? HIGH_GAIN : CWND_GAIN; }
+    double btl_bw() const { return _bw_samples.empty() ? 0 : _bw_samples.front().second; }
+    //! the bandwidth-delay product times `gain`, plus some room for acks that are delayed or stretched
+    size_t inflight_target(const double gain) const;
+    void save_cwnd() { _prior_cwnd = std::max(_prior_cwnd, _cwnd); }
+    void restore_cwnd();
+
+    void update_round(const AckSample &ack);
+    void update_btl_bw(const AckSample &ack);
+    //! \returns `true` if the estimate had gone RTPROP_FILTER_MS without being refreshed
+    bool update_rt_prop(const AckSample &ack);
+    void check_full_pipe(const AckSample &ack);
+    void enter_probe_bw(const uint64_t now_ms);
+    void advance_mode(const AckSample &ack, const bool rt_prop_expired);
+    void set_pacing_rate();
+    void set_cwnd(const AckSample &ack);
+
+  public:
+    Bbr(const size_t mss, const size_t initial_window);
+
+    void on_ack(const AckSample &ack) override;
+    void on_duplicate_ack(const AckSample &ack) override;
+    void on_loss(const uint64_t recovery_point, const size_t bytes_in_flight) override;
+    void on_rto(const size_t bytes_in_flight) override;
+    size_t cwnd() const override { return _cwnd; }
+    size_t ssthresh() const override;
+    bool in_recovery() const override { return _recovery_point.has_value(); }
+    std::optional<double> pacing_rate() const override;
+
+    //! \returns the current mode
+    Mode mode() const { return _mode; }
+
+    //! \returns the bottleneck bandwidth estimate, in bytes per millisecond
+    double bottleneck_bandwidth() const { return btl_bw(); }
+
+    //! \returns the round-trip propagation time estimate, in milliseconds, once there has been a sample
+    std::optional<uint64_t> round_trip_propagation_time() const { return _rt_prop; }
+};
+
+#endif  // SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
@@ -0,0 +1,214 @@
+#include "reassembly_tracker.hh"
+
+#include <algorithm>
+#include <iterator>
+
+using namespace std;
+
+//! \details Merges every range that overlaps or touches `[start, end)` into it
+void ListTracker::insert(const uint64_t start, const uint64_t end) {
+    if (start >= end) {
+        return;
+    }
+    uint64_t merged_start = start, merged_end = end;
+    auto it = _ranges.begin();
+    while (it != _ranges.end()) {
+        if (it->first <= merged_end and it->second >= merged_start) {
+            merged_start = min(it->first, merged_start);
+            merged_end = max(it->second, merged_end);
+            it = _ranges.erase(it);
+        } else {
+            it++;
+        }
+    }
+    _ranges.emplace_back(merged_start, merged_end);
+}
+
+bool ListTracker::contains(const uint64_t start, const uint64_t end) const {
+    for (const auto &range : _ranges) {
+        if (start >= range.first and end <= range.second) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t ListTracker::pop_contiguous(const uint64_t index) {
+    for (auto it = _ranges.begin(); it != _ranges.end(); it++) {
+        if (it->first <= index and it->second > index) {
+            const uint64_t end = it->second;
+            _ranges.erase(it);
+            return end;
+        }
+    }
+    return index;
+}
+
+size_t ListTracker::size() const {
+    size_t bytes = 0;
+    for (const auto &range : _ranges) {
+        bytes += range.second - range.first;
+    }
+    return bytes;
+}
+
+vector<pair<uint64_t, uint64_t>> ListTracker::ranges(const uint64_t from, const uint64_t to) const {
+    vector<pair<uint64_t, uint64_t>> r;
+    for (const auto &range : _ranges) {
+        if (range.first < to and range.second > from) {
+            r.emplace_back(max(range.first, from), min(range.second, to));
+        }
+    }
+    sort(r.begin(), r.end());
+    return r;
+}
+
+//! \details Merges every range that overlaps or touches `[start, end)` into it
+void IntervalTracker::insert(const uint64_t start, const uint64_t end) {
+    if (start >= end) {
+        return;
+    }
+    uint64_t merged_start = start, merged_end = end;
+
+    // the range before `start` may overlap or touch the new one
+    auto it = _ranges.upper_bound(start);
+    if (it != _ranges.begin()) {
+        const auto prev = std::prev(it);
+        if (prev->second >= start) {
+            merged_start = prev->first;
+            merged_end = max(prev->second, merged_end);
+            _size -= prev->second - prev->first;
+            _ranges.erase(prev);
+        }
+    }
+
+    // so may any number of ranges that start within it
+    while (it != _ranges.end() and it->first <= merged_end) {
+        merged_end = max(it->second, merged_end);
+        _size -= it->second - it->first;
+        it = _ranges.erase(it);
+    }
+
+    _ranges.emplace_hint(it, merged_start, merged_end);
+    _size += merged_end - merged_start;
+}
+
+bool IntervalTracker::contains(const uint64_t start, const uint64_t end) const {
+    auto it = _ranges.upper_bound(start);
+    if (it == _ranges.begin()) {
+        return false;
+    }
+    it = std::prev(it);
+    return end <= it->second;
+}
+
+uint64_t IntervalTracker::pop_contiguous(const uint64_t index) {
+    auto it = _ranges.upper_bound(index);
+    if (it == _ranges.begin()) {
+        return index;
+    }
+    it = std::prev(it);
+    if (it->second <= index) {
+        return index;
+    }
+    const uint64_t end = it->second;
+    _size -= it->second - it->first;
+    _ranges.erase(it);
+    return end;
+}
+
+vector<pair<uint64_t, uint64_t>> IntervalTracker::ranges(const uint64_t from, const uint64_t to) const {
+    vector<pair<uint64_t, uint64_t>> r;
+    auto it = _ranges.upper_bound(from);
+    if (it != _ranges.begin()) {
+        it = std::prev(it);
+    }
+    for (; it != _ranges.end() and it->first < to; ++it) {
+        if (it->second > from) {
+            r.emplace_back(max(it->first, from), min(it->second, to));
+        }
+    }
+    return r;
+}
+
+//! \returns the bits from `from` (inclusive) to `to` (exclusive) of a word
+static uint64_t bit_range(const unsigned from, const unsigned to) {
+    const uint64_t below_to = to == 64 ? ~uint64_t{0} : (uint64_t{1} << to) - 1;
+    return below_to & ~((uint64_t{1} << from) - 1);
+}
+
+template <typename F>
+void BitmapTracker::for_each_word(const uint64_t start, const uint64_t end, F &&f) {
+    for (uint64_t i = start; i < end;) {
+        const uint64_t next = min(end, (i / 64 + 1) * 64);
+        f(_words[(i / 64) % _words.size()], bit_range(i % 64, (next - 1) % 64 + 1));
+        i = next;
+    }
+}
+
+void BitmapTracker::insert(const uint64_t start, const uint64_t end) {
+    for_each_word(start, end, [&](uint64_t &word, const uint64_t mask) {
+        _size += __builtin_popcountll(mask & ~word);
+        word |= mask;
+    });
+}
+
+bool BitmapTracker::contains(const uint64_t start, const uint64_t end) const {
+    for (uint64_t i = start; i < end;) {
+        const uint64_t next = min(end, (i / 64 + 1) * 64);
+        const uint64_t mask = bit_range(i % 64, (next - 1) % 64 + 1);
+        if ((_words[(i / 64) % _words.size()] & mask) != mask) {
+            return false;
+        }
+        i = next;
+    }
+    return true;
+}
+
+//! \details Uses the trailing zeros of the inverted word to find where the run stops
+unsigned BitmapTracker::run_in_word(const uint64_t index) const {
+    const uint64_t held = _words[(index / 64) % _words.size()] >> (index % 64);
+    return ~held == 0 ? 64 - index % 64 : __builtin_ctzll(~held);
+}
+
+//! \details Clears whole words of set bits until it finds a word with a clear bit
+uint64_t BitmapTracker::pop_contiguous(const uint64_t index) {
+    uint64_t end = index;
+    while (true) {
+        const unsigned run = run_in_word(end);
+        if (run == 0) {
+            return end;
+        }
+        const uint64_t mask = bit_range(end % 64, end % 64 + run);
+        _words[(end / 64) % _words.size()] &= ~mask;
+        _size -= run;
+        end += run;
+        if (end % 64 != 0) {
+            return end;
+        }
+    }
+}
+
+//! \details Skips clear bits a word at a time, using the trailing zeros of each word to find
+//! where the next range starts, and run_in_word() to find where it stops
+vector<pair<uint64_t, uint64_t>> BitmapTracker::ranges(const uint64_t from, const uint64_t to) const {
+    vector<pair<uint64_t, uint64_t>> r;
+    uint64_t i = from;
+    while (i < to) {
+        const uint64_t held = _words[(i / 64) % _words.size()] >> (i % 64);
+        if (held == 0) {
+            i = (i / 64 + 1) * 64;
+            continue;
+        }
+        i += __builtin_ctzll(held);
+        if (i >= to) {
+            break;
+        }
+        const uint64_t start = i;
+        for (unsigned run = run_in_word(i); run > 0 and i < to; run = i % 64 == 0 ? run_in_word(i) : 0) {
+            i += run;
+        }
+        r.emplace_back(start, min(i, to));
+    }
+    return r;
+}
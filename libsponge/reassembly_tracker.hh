@@ -0,0 +1,98 @@
+#ifndef SPONGE_LIBSPONGE_REASSEMBLY_TRACKER_HH
+#define SPONGE_LIBSPONGE_REASSEMBLY_TRACKER_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <utility>
+#include <vector>
+
+//! \brief Bookkeeping for which bytes a StreamReassembler is holding but has not yet assembled
+//! \details Ranges are half-open, `[start, end)`, in stream indices. The reassembler only inserts
+//! ranges at or after its assembled index, and takes the held bytes back out with pop_contiguous()
+//! as soon as they continue the assembled stream.
+class ReassemblyTracker {
+  public:
+    //! \brief Record that the bytes in `[start, end)` are held (some of them may already be)
+    virtual void insert(const uint64_t start, const uint64_t end) = 0;
+
+    //! \returns `true` if every byte in `[start, end)` is already held
+    virtual bool contains(const uint64_t start, const uint64_t end) const = 0;
+
+    //! \brief Stop tracking the held bytes that start at `index` and run contiguously from it
+    //! \returns the index just past those bytes (`index` itself, if the byte at `index` isn't held)
+    virtual uint64_t pop_contiguous(const uint64_t index) = 0;
+
+    //! \returns the number of bytes held, each byte counted once
+    virtual size_t size() const = 0;
+
+    //! \returns the held ranges that overlap `[from, to)`, clipped to it, in order and with no two adjacent
+    virtual std::vector<std::pair<uint64_t, uint64_t>> ranges(const uint64_t from, const uint64_t to) const = 0;
+
+    //! \returns `true` if no bytes are held
+    bool empty() const { return size() == 0; }
+
+    virtual ~ReassemblyTracker() = default;
+};
+
+//! \brief An unordered list of disjoint ranges, scanned in full on every call
+//! \note This was the StreamReassembler's original bookkeeping. It is linear in the number of
+//! holes per segment (and per call to size()), so it is kept only for comparison.
+class ListTracker : public ReassemblyTracker {
+  private:
+    std::list<std::pair<uint64_t, uint64_t>> _ranges{};
+
+  public:
+    void insert(const uint64_t start, const uint64_t end) override;
+    bool contains(const uint64_t start, const uint64_t end) const override;
+    uint64_t pop_contiguous(const uint64_t index) override;
+    size_t size() const override;
+    std::vector<std::pair<uint64_t, uint64_t>> ranges(const uint64_t from, const uint64_t to) const override;
+};
+
+//! \brief Disjoint, non-adjacent ranges in a std::map keyed by start, plus a running byte count
+//! \details insert(), contains() and pop_contiguous() are logarithmic in the number of holes
+//! (plus the number of ranges a new range swallows), and size() is constant time.
+class IntervalTracker : public ReassemblyTracker {
+  private:
+    std::map<uint64_t, uint64_t> _ranges{};  //!< start -> end of each held range
+    size_t _size{0};                         //!< total length of `_ranges`
+
+  public:
+    void insert(const uint64_t start, const uint64_t end) override;
+    bool contains(const uint64_t start, const uint64_t end) const override;
+    uint64_t pop_contiguous(const uint64_t index) override;
+    size_t size() const override { return _size; }
+    std::vector<std::pair<uint64_t, uint64_t>> ranges(const uint64_t from, const uint64_t to) const override;
+};
+
+//! \brief One bit per byte of the reassembler's window, in a ring of 64-bit words
+//! \details Marking, testing and clearing bytes is done a word (64 bytes of stream) at a time,
+//! the end of the contiguous run is found with a count of trailing zeros, and newly held bytes
+//! are counted with popcount. The cost of each call is proportional to the length of the range,
+//! however many holes the window has.
+class BitmapTracker : public ReassemblyTracker {
+  private:
+    std::vector<uint64_t> _words;  //!< bit `i % 64` of word `(i / 64) % _words.size()` is set if byte `i` is held
+    size_t _size{0};               //!< number of bits set
+
+    //! Call `f(word, mask)` for each word that holds a bit of `[start, end)`, with the bits in the range as the mask
+    template <typename F>
+    void for_each_word(const uint64_t start, const uint64_t end, F &&f);
+
+    //! \returns the number of consecutive bits set from bit `index` on, up to the end of its word
+    unsigned run_in_word(const uint64_t index) const;
+
+  public:
+    //! Track bytes in any window of `capacity` consecutive indices
+    explicit BitmapTracker(const size_t capacity) : _words(capacity / 64 + 2) {}
+
+    void insert(const uint64_t start, const uint64_t end) override;
+    bool contains(const uint64_t start, const uint64_t end) const override;
+    uint64_t pop_contiguous(const uint64_t index) override;
+    size_t size() const override { return _size; }
+    std::vector<std::pair<uint64_t, uint64_t>> ranges(const uint64_t from, const uint64_t to) const override;
+};
+
+#endif  // SPONGE_LIBSPONGE_REASSEMBLY_TRACKER_HH
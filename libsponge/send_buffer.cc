@@ -0,0 +1,74 @@
+#include "send_buffer.hh"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+
+using namespace std;
+
+void SendBuffer::push(Buffer data) {
+    if (data.size() == 0) {
+        return;
+    }
+    const size_t len = data.size();
+    _chunks.emplace_back(end(), move(data));
+    _size += len;
+}
+
+//! \details The chunk holding `seqno` is found by binary search.
+Buffer SendBuffer::slice(const uint64_t seqno, const size_t len) const {
+    if (len == 0) {
+        return {};
+    }
+    if (seqno < _start or seqno + len > end()) {
+        throw out_of_range("SendBuffer::slice: bytes not held");
+    }
+
+    auto it = prev(upper_bound(_chunks.begin(), _chunks.end(), seqno, [](const uint64_t s, const auto &chunk) {
+        return s < chunk.first;
+    }));
+    const size_t offset = seqno - it->first;
+    if (offset + len <= it->second.size()) {
+        Buffer r = it->second;
+        r.remove_prefix(offset);
+        r.remove_suffix(r.size() - len);
+        return r;
+    }
+
+    string r;
+    r.reserve(len);
+    for (size_t skip = offset; r.size() < len; ++it, skip = 0) {
+        r.append(it->second.str().substr(skip, len - r.size()));
+    }
+    return Buffer{move(r)};
+}
+
+void SendBuffer::acknowledge(const uint64_t ackno) {
+    while (_start < ackno and _size > 0) {
+        Buffer &front = _chunks.front().second;
+        const size_t n = min<uint64_t>(ackno - _start, front.size());
+        _start += n;
+        _size -= n;
+        if (n == front.size()) {
+            _chunks.pop_front();
+        } else {
+            front.remove_prefix(n);
+            _chunks.front().first = _start;
+        }
+    }
+    // an ack of the FIN reaches past the last byte
+    _start = max(_start, ackno);
+}
+
+//! \details A Buffer read from the stream in pieces (one per segment) shares its storage, which is counted once.
+size_t SendBuffer::footprint() const {
+    size_t total = 0;
+    unordered_set<const void *> counted{};
+    for (const auto &[seqno, chunk] : _chunks) {
+        if (counted.insert(chunk.storage_id()).second) {
+            total += chunk.storage_size();
+        }
+    }
+    return total;
+}
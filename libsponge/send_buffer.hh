@@ -0,0 +1,45 @@
+#ifndef SPONGE_LIBSPONGE_SEND_BUFFER_HH
+#define SPONGE_LIBSPONGE_SEND_BUFFER_HH
+
+#include "buffer.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+//! \brief The payload bytes a TCPSender has sent and not yet had acknowledged, indexed by absolute seqno
+//! \details The Buffers read from the outbound stream are held as they are, so a segment, whether sent
+//! for the first time or retransmitted, is a slice of them rather than a copy, and can start and end
+//! at any byte. Acknowledged bytes are discarded a chunk at a time.
+class SendBuffer {
+  private:
+    std::deque<std::pair<uint64_t, Buffer>> _chunks{};  //!< each Buffer, after the absolute seqno of its first byte
+    uint64_t _start;                                    //!< absolute seqno of the first byte held
+    uint64_t _size{0};                                  //!< number of bytes held
+
+  public:
+    //! \param[in] start is the absolute seqno of the first byte that will be pushed
+    explicit SendBuffer(const uint64_t start = 1) : _start(start) {}
+
+    //! \brief Append bytes, which follow the last ones held in sequence space
+    void push(Buffer data);
+
+    //! \brief The `len` bytes from absolute seqno `seqno`, all of which must be held
+    //! \note This only copies if the bytes span more than one of the pushed Buffers.
+    Buffer slice(const uint64_t seqno, const size_t len) const;
+
+    //! \brief Discard the bytes before absolute seqno `ackno`
+    void acknowledge(const uint64_t ackno);
+
+    //! \returns the absolute seqno just past the last byte held
+    uint64_t end() const { return _start + _size; }
+
+    //! \returns the number of bytes held
+    size_t size() const { return _size; }
+
+    //! \returns the bytes of memory held: the whole of each Buffer that bytes held are sliced from
+    size_t footprint() const;
+};
+
+#endif  // SPONGE_LIBSPONGE_SEND_BUFFER_HH
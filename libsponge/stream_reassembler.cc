@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <stdexcept>
+#include <unordered_set>
 
 // Dummy implementation of a stream reassembler.
 
@@ -15,107 +16,137 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
-StreamReassembler::StreamReassembler(const size_t capacity)
-    : buffer(capacity + 1)
-    , head(0)
+//! \param[in] tracker selects how the bytes not yet reassembled are tracked
+static unique_ptr<ReassemblyTracker> make_tracker(const size_t capacity, const StreamReassembler::Tracker tracker) {
+    switch (tracker) {
+        case StreamReassembler::Tracker::List:
+            return make_unique<ListTracker>();
+        case StreamReassembler::Tracker::Bitmap:
+            return make_unique<BitmapTracker>(capacity);
+        case StreamReassembler::Tracker::IntervalMap:
+        default:
+            return make_unique<IntervalTracker>();
+    }
+}
+
+StreamReassembler::StreamReassembler(const size_t capacity,
+                                     const ByteStream::Storage storage,
+                                     const Tracker tracker)
+    : _held()
     , assembled_index(0)
-    , head_index(0)
-    , unassembled_list()
+    , _unassembled(make_tracker(capacity, tracker))
     , detect_eof(false)
     , eof_index(0)
-    , _output(capacity)
+    , _output(capacity, storage)
     , _capacity(capacity) {}
 
+void StreamReassembler::push_substring(const string &data, const size_t index, const bool eof) {
+    push_substring(Buffer{string(data)}, index, eof);
+}
+
 //! \details This function accepts a substring (aka a segment) of bytes,
 //! possibly out-of-order, from the logical stream, and assembles any newly
 //! contiguous substrings and writes them into the output stream in order.
-void StreamReassembler::push_substring(const string &data, const size_t index, const bool eof) {
-    // check if already assembled, out of capacity, or in unassembled list; already contain -> return
-    if (index + data.size() >= assembled_index && index < acceptable_last_index() &&
-        !substring_contains_in_unassembled_list(index, data.length())) {
-        // copy substring into buffer, check eof
-        size_t copy_start_index = max(index, assembled_index);
-        size_t copy_end_index = min(index + data.length(), acceptable_last_index());
-        for (size_t i = copy_start_index; i < copy_end_index; i++) {
-            buffer[index2off(i)] = data[i - index];
-        }
-        if (copy_end_index == index + data.length() && eof) {
+void StreamReassembler::push_substring(Buffer data, const size_t index, const bool eof) {
+    // check if already assembled or out of capacity
+    if (index + data.size() >= assembled_index && index < acceptable_last_index()) {
+        // trim the part already assembled and the part beyond capacity, check eof
+        size_t start_index = max(index, assembled_index);
+        size_t end_index = min(index + data.size(), acceptable_last_index());
+        if (end_index == index + data.size() && eof) {
             detect_eof = true;
-            eof_index = copy_end_index;
+            eof_index = end_index;
         }
-
-        // combine with unassembled list region
-        list<pair<size_t, size_t>>::iterator it = unassembled_list.begin();
-        size_t start_index = copy_start_index, end_index = copy_end_index;
-        while (it != unassembled_list.end()) {
-            if (is_overlap(start_index, end_index, it->first, it->second)) {
-                start_index = min(it->first, start_index);
-                end_index = max(it->second, end_index);
-                unassembled_list.erase(it++);
+        data.remove_prefix(start_index - index);
+        data.remove_suffix(data.size() - (end_index - start_index));
+
+        if (start_index == assembled_index && start_index < end_index) {
+            // in order: write straight to the stream, followed by any held bytes it now reaches
+            _unassembled->insert(start_index, end_index);
+            assembled_index = _unassembled->pop_contiguous(assembled_index);
+            _output.write(move(data));
+            if (_output.can_stage()) {
+                _output.commit_write(assembled_index - end_index);
             } else {
-                it++;
+                write_held(end_index, assembled_index);
             }
-        }
-
-        // finally check if can combine into assemble data
-        if (start_index == assembled_index) {
-            assembled_index = end_index;
-        } else {
-            unassembled_list.push_back(pair<size_t, size_t>(start_index, end_index));
+        } else if (start_index < end_index && !_unassembled->contains(start_index, end_index)) {
+            // out of order: put the bytes in their place in the stream if it can hold them there,
+            // or else hold on to the ones not already held
+            if (_output.can_stage()) {
+                _output.stage_write(start_index - assembled_index, data);
+            } else {
+                hold(start_index, data);
+            }
+            _unassembled->insert(start_index, end_index);
         }
     }
 
-    // write to byte_stream, set eof if
-    if (head_index < assembled_index) {
-        size_t w_len = min(assembled_index - head_index, _output.remaining_capacity());
-        _output.write(pop_string(w_len));
-    }
-    if (detect_eof && head_index == eof_index) {
+    if (detect_eof && assembled_index == eof_index) {
         _output.end_input();
     }
 }
 
-size_t StreamReassembler::unassembled_bytes() const {
-    size_t bytes = 0;
-    for (const auto &pir : unassembled_list) {
-        bytes += pir.second - pir.first;
-    }
-    return bytes;
-}
+size_t StreamReassembler::unassembled_bytes() const { return _unassembled->size(); }
 
-bool StreamReassembler::empty() const { return unassembled_list.empty(); }
+bool StreamReassembler::empty() const { return _unassembled->empty(); }
 
-// Implemented private functions
-bool StreamReassembler::substring_contains_in_unassembled_list(const size_t index, const size_t str_len) const {
-    for (const auto &pir : unassembled_list) {
-        if (index >= pir.first && index + str_len <= pir.second) {
-            return true;
+//! \details Slices of one Buffer (a segment split around bytes already held) share its storage, which is
+//! counted once.
+size_t StreamReassembler::footprint() const {
+    size_t held = 0;
+    unordered_set<const void *> counted{};
+    for (const auto &[index, slice] : _held) {
+        if (counted.insert(slice.storage_id()).second) {
+            held += slice.storage_size();
         }
     }
-    return false;
+    return held + _output.footprint();
 }
 
-size_t StreamReassembler::index2off(const size_t index) const {
-    if (index < head_index || index >= acceptable_last_index()) {
-        throw std::runtime_error("index2off error: index out of bound");
+// Implemented private functions
+
+//! \details Adds slices of `data` (whose first byte is at `index`) to `_held`, covering
+//! just the bytes that aren't held already
+void StreamReassembler::hold(const size_t index, const Buffer &data) {
+    const size_t end_index = index + data.size();
+    size_t cursor = index;
+
+    auto it = _held.upper_bound(index);
+    if (it != _held.begin()) {
+        const auto &[prev_index, prev] = *std::prev(it);
+        cursor = max(cursor, prev_index + prev.size());
     }
-    return (index - head_index + head) % (_capacity + 1);
-}
 
-bool StreamReassembler::is_overlap(const size_t s1, const size_t e1, const size_t s2, const size_t e2) const {
-    if ((s2 < s1 && e2 >= s1) || (s2 >= s1 && s2 <= e1)) {
-        return true;
-    } else {
-        return false;
+    while (cursor < end_index) {
+        const size_t next_index = (it == _held.end()) ? end_index : min(it->first, end_index);
+        if (cursor < next_index) {
+            Buffer slice = data;
+            slice.remove_prefix(cursor - index);
+            slice.remove_suffix(end_index - next_index);
+            _held.emplace_hint(it, cursor, move(slice));
+        }
+        if (it == _held.end() or it->first >= end_index) {
+            break;
+        }
+        cursor = max(cursor, it->first + it->second.size());
+        it++;
     }
 }
 
-string StreamReassembler::pop_string(const size_t length) {
-    string r;
-    for (size_t i = 0; i < length; i++) {
-        r += buffer[head];
-        head = (head + 1) % (_capacity + 1);
-        head_index++;
+//! \details Writes the held bytes in `[from_index, to_index)` to the stream and stops holding
+//! them, along with any held bytes before `from_index` (which were written already).
+void StreamReassembler::write_held(const size_t from_index, const size_t to_index) {
+    size_t cursor = from_index;
+    while (not _held.empty() and _held.begin()->first < to_index) {
+        auto node = _held.extract(_held.begin());
+        const size_t held_index = node.key();
+        Buffer &held = node.mapped();
+        if (held_index + held.size() <= cursor) {
+            continue;
+        }
+        held.remove_prefix(cursor - held_index);
+        cursor += held.size();
+        _output.write(move(held));
     }
-    return r;
-}
\ No newline at end of file
+}
@@ -1,24 +1,39 @@
 #ifndef SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
 #define SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
 
+#include "buffer.hh"
 #include "byte_stream.hh"
+#include "reassembly_tracker.hh"
 
 #include <cstdint>
-#include <list>
+#include <map>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 //! \brief A class that assembles a series of excerpts from a byte stream (possibly out of order,
 //! possibly overlapping) into an in-order byte stream.
 class StreamReassembler {
+  public:
+    //! \brief How the reassembler keeps track of the bytes it holds but hasn't assembled
+    enum class Tracker {
+        List,         //!< an unordered list of ranges, scanned on every segment (see ListTracker)
+        IntervalMap,  //!< ordered ranges in a std::map, with a running byte count (see IntervalTracker)
+        Bitmap        //!< one bit per byte of the window, scanned a word at a time (see BitmapTracker)
+    };
+
   private:
     // Your code here -- add private members as necessary.
-    std::vector<uint8_t> buffer;
-    size_t head;
+    //! Out-of-order bytes, as slices of the Buffers they arrived in, keyed by the index of
+    //! their first byte. The slices never overlap.
+    //! \note Only used if the stream can't stage bytes in place (see ByteStream::can_stage); otherwise
+    //! out-of-order bytes are copied straight to their place in the stream's free space, and become
+    //! readable when the bytes before them arrive.
+    std::map<size_t, Buffer> _held;
     size_t assembled_index;
-    size_t head_index;
 
-    std::list<std::pair<size_t, size_t>> unassembled_list;
+    std::unique_ptr<ReassemblyTracker> _unassembled;
     bool detect_eof;
     size_t eof_index;
 
@@ -26,16 +41,18 @@ class StreamReassembler {
     size_t _capacity;    //!< The maximum number of bytes
 
     // private functions
-    bool substring_contains_in_unassembled_list(const size_t index, const size_t str_len) const;
-    size_t index2off(const size_t index) const;
-    bool is_overlap(const size_t s1, const size_t e1, const size_t s2, const size_t e2) const;
-    std::string pop_string(const size_t length);
+    void hold(const size_t index, const Buffer &data);
+    void write_held(const size_t from_index, const size_t to_index);
 
   public:
     //! \brief Construct a `StreamReassembler` that will store up to `capacity` bytes.
     //! \note This capacity limits both the bytes that have been reassembled,
     //! and those that have not yet been reassembled.
-    StreamReassembler(const size_t capacity);
+    //! \param storage selects how the reassembled stream holds its bytes (see ByteStream::Storage)
+    //! \param tracker selects how the bytes not yet reassembled are tracked
+    StreamReassembler(const size_t capacity,
+                      const ByteStream::Storage storage = ByteStream::Storage::Ring,
+                      const Tracker tracker = Tracker::IntervalMap);
 
     //! \brief Receive a substring and write any newly contiguous bytes into the stream.
     //!
@@ -47,6 +64,14 @@ class StreamReassembler {
     //! \param eof the last byte of `data` will be the last byte in the entire stream
     void push_substring(const std::string &data, const uint64_t index, const bool eof);
 
+    //! \brief Receive a substring held in a Buffer, without copying it.
+    //!
+    //! Bytes that continue the reassembled stream are written to it as a slice of `data`
+    //! (adopted without a copy if the stream is ByteStream::Storage::Chunked). Bytes that arrive
+    //! out of order are staged in their place in the stream's free space, or, for a Chunked
+    //! stream, held as slices of `data` until the bytes before them arrive.
+    void push_substring(Buffer data, const uint64_t index, const bool eof);
+
     //! \name Access the reassembled byte stream
     //!@{
     const ByteStream &stream_out() const { return _output; }
@@ -59,10 +84,19 @@ class StreamReassembler {
     //! should only be counted once for the purpose of this function.
     size_t unassembled_bytes() const;
 
+    //! \returns the ranges `[start, end)` of stream indices stored but not yet reassembled, in order
+    std::vector<std::pair<uint64_t, uint64_t>> unassembled_ranges() const {
+        return _unassembled->ranges(assembled_index, acceptable_last_index());
+    }
+
     //! \brief Is the internal state empty (other than the output stream)?
     //! \returns `true` if no substrings are waiting to be assembled
     bool empty() const;
 
+    //! \brief Number of bytes of memory held for bytes not yet reassembled and by the reassembled stream
+    //! \note Bytes held out of order keep alive the whole of the Buffers they arrived in, so those count in full.
+    size_t footprint() const;
+
     // my pubilc
     size_t acceptable_last_index() const { return _output.bytes_read() + _capacity; }
     size_t get_assembled_index() const { return assembled_index; }
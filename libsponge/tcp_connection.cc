@@ -37,11 +37,64 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
         return;
     }
 
+    // once timestamps are agreed, every segment but a RST carries them; one that doesn't is dropped,
+    // unacked, so that leaving the option out can't get a segment past PAWS (RFC 7323, section 3.2)
+    const auto &timestamps = seg.header().timestamps;
+    if (_timestamps_enabled && !timestamps.has_value() && !seg.header().syn) {
+        return;
+    }
+
     _time_since_last_segment_received = 0;
 
+    if (_timestamps_enabled && timestamps.has_value() && !seg.header().syn) {
+        // PAWS: a segment stamped before the latest one is an old duplicate, perhaps from a
+        // previous wrap of the sequence numbers; drop it, but ack (RFC 7323, section 5)
+        if (static_cast<int32_t>(timestamps->tsval - _ts_recent) < 0) {
+            _sender.send_empty_segment();
+            _flush_segments_out();
+            return;
+        }
+        if (_last_ack_sent.has_value() && seg.header().seqno - _last_ack_sent.value() <= 0) {
+            _ts_recent = timestamps->tsval;
+        }
+    }
+
+    if (seg.header().syn) {
+        _timestamps_enabled = _cfg.timestamps && timestamps.has_value();
+        if (_timestamps_enabled) {
+            _ts_recent = timestamps->tsval;
+        }
+        // every segment will carry the timestamps, so they come out of the payload
+        _sender.set_max_payload_size(TCPConfig::MAX_PAYLOAD_SIZE -
+                                     (_timestamps_enabled ? TCPHeader::TIMESTAMPS_OPTION_LENGTH : 0));
+        _sack_enabled = _cfg.sack && seg.header().sack_permitted;
+        // a SYN asks for ECN with both flags; a SYN-ACK agrees with ECE alone
+        _ecn_enabled = _cfg.ecn && seg.header().ece && seg.header().cwr != seg.header().ack;
+        _sender.set_ecn(_ecn_enabled);
+        _window_scaling_enabled = _cfg.window_scaling && seg.header().window_scale.has_value();
+        if (_window_scaling_enabled) {
+            _snd_wscale = min(seg.header().window_scale.value(), TCPHeader::MAX_WINDOW_SCALE);
+            _rcv_wscale = _window_scale_offer();
+        }
+    }
+
+    const bool had_gap = _receiver.unassembled_bytes() > 0;
+    const optional<WrappingInt32> ackno_before = _receiver.ackno();
     _receiver.segment_received(seg);
+    const bool in_order = !had_gap && _receiver.unassembled_bytes() == 0 && _receiver.ackno() != ackno_before;
     if (seg.header().ack) {
-        _sender.ack_received(seg.header().ackno, seg.header().win);
+        if (_sack_enabled && !seg.header().sack.empty()) {
+            _sender.sack_received(seg.header().sack);
+        }
+        if (_timestamps_enabled && timestamps.has_value()) {
+            _sender.timestamp_echo_received(timestamps->tsecr);
+        }
+        if (_ecn_enabled && seg.header().ece && !seg.header().syn) {
+            _sender.ecn_echo_received();
+        }
+        // the window in a SYN is never scaled
+        const uint64_t window = seg.header().syn ? seg.header().win : uint64_t{seg.header().win} << _snd_wscale;
+        _sender.ack_received(seg.header().ackno, window, seg.length_in_sequence_space() > 0);
     }
     // check if the other side: fin acked --> no need to linger
     if (_receiver.stream_out().input_ended() && !_sender.fin_setted()) {
@@ -49,12 +102,40 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
     }
     // old is wrong: if (seg.length_in_sequence_space() > 0) {
     _sender.fill_window();  // new ack means have extra windows size, need to fill window again
-    if (seg.length_in_sequence_space() > 0 && _sender.segments_out().empty()) {
-        _sender.send_empty_segment();
+    if (seg.length_in_sequence_space() > 0) {
+        _segments_since_ack++;
+        if (_sender.segments_out().empty()) {
+            if (_may_delay_ack(seg, in_order)) {
+                if (!_ack_delayed_for.has_value()) {
+                    _ack_delayed_for = 0;
+                }
+            } else {
+                _sender.send_empty_segment();
+            }
+        }
     }
     _flush_segments_out();
 }
 
+//! \details An ack may wait for the delayed-ack timer (or for data to ride on) only if the segment
+//! arrived in order, filled no hole, carries neither SYN nor FIN and wasn't marked CE, and if less than
+//! two full-sized segments have gone unacknowledged (RFC 1122, section 4.2.3.2; RFC 5681, section 4.2).
+bool TCPConnection::_may_delay_ack(const TCPSegment &seg, const bool in_order) const {
+    if (!_cfg.delayed_ack || !in_order || seg.header().syn || seg.header().fin || !_last_ack_sent.has_value()) {
+        return false;
+    }
+    if (_ecn_enabled && seg.ecn() == IPv4Header::CE) {
+        return false;
+    }
+    const int32_t two_segments = static_cast<int32_t>(2 * _sender.max_payload_size());
+    return _receiver.ackno().value() - _last_ack_sent.value() < two_segments;
+}
+
+bool TCPConnection::waiting_on_time() const {
+    return active() and (_sender.timers_running() or _sender.time_until_release().has_value() or
+                         _ack_delayed_for.has_value() or _stream_finish() or not _receiver.stream_out().buffer_empty());
+}
+
 bool TCPConnection::active() const {
     // RST
     if (_receiver.stream_out().error() || _sender.stream_in().error()) {
@@ -72,13 +153,21 @@ size_t TCPConnection::write(const string &data) {
     if (!active()) {
         return 0;
     }
+    return _send_written(_sender.stream_in().write(data));
+}
 
-    size_t len = _sender.stream_in().write(data);
+size_t TCPConnection::write(string &&data) {
+    if (!active()) {
+        return 0;
+    }
+    return _send_written(_sender.stream_in().write(move(data)));
+}
+
+size_t TCPConnection::_send_written(const size_t len) {
     if (len > 0) {
         _sender.fill_window();
         _flush_segments_out();
     }
-
     return len;
 }
 
@@ -96,6 +185,17 @@ void TCPConnection::tick(const size_t ms_since_last_tick) {
         _rst();
         return;
     }
+    // a delayed ack that nothing has carried yet goes out on its own once the timer expires
+    if (_ack_delayed_for.has_value()) {
+        *_ack_delayed_for += ms_since_last_tick;
+        if (*_ack_delayed_for >= _cfg.delayed_ack_timeout && _sender.segments_out().empty()) {
+            _sender.send_empty_segment();
+        }
+    }
+    // the application has read enough to open the window by a worthwhile step: tell the peer
+    if (_receiver.window_update_due() && _sender.segments_out().empty()) {
+        _sender.send_empty_segment();
+    }
     // flush segments need after MAX_RETX_ATTEMPS check
     _flush_segments_out();
     // 3. end the connection cleany;
@@ -134,20 +234,68 @@ TCPConnection::~TCPConnection() {
 // my private functions
 void TCPConnection::_flush_segments_out() {
     while (!_sender.segments_out().empty()) {
-        TCPSegment &seg = _sender.segments_out().front();
+        TCPSegment seg = std::move(_sender.segments_out().front());
         _sender.segments_out().pop();
 
         // set ACK (from receiver)
         if (_receiver.ackno().has_value()) {
             seg.header().ack = 1;
             seg.header().ackno = _receiver.ackno().value();
+            _last_ack_sent = seg.header().ackno;
+            // this ack covers every segment received since the last one; count those whose own ack was saved
+            const size_t own_ack = seg.length_in_sequence_space() == 0 ? 1 : 0;
+            _acks_avoided += _segments_since_ack > own_ack ? _segments_since_ack - own_ack : 0;
+            _segments_since_ack = 0;
+            _ack_delayed_for.reset();
+        }
+        // set window size, scaled unless the segment is a SYN
+        const uint8_t shift = seg.header().syn ? 0 : _rcv_wscale;
+        const size_t window = _receiver.advertised_window() >> shift;
+        seg.header().win = window > 0xffff ? static_cast<uint16_t>(0xffff) : static_cast<uint16_t>(window);
+        _receiver.window_advertised(size_t{seg.header().win} << shift);
+        // offer SACK, window scaling, timestamps and ECN on our SYN, unless it answers a SYN that didn't
+        if (seg.header().syn) {
+            const bool active_open = !_receiver.ackno().has_value();
+            seg.header().sack_permitted = _cfg.sack && (active_open || _sack_enabled);
+            seg.header().ece = _cfg.ecn && (active_open || _ecn_enabled);
+            seg.header().cwr = _cfg.ecn && active_open;
+            if (_cfg.window_scaling && (active_open || _window_scaling_enabled)) {
+                seg.header().window_scale = _window_scale_offer();
+            }
+            if (_cfg.timestamps && active_open) {
+                seg.header().timestamps = TCPHeader::Timestamps{_sender.timestamp_value(), 0};
+            }
+        }
+        if (_timestamps_enabled) {
+            seg.header().timestamps = TCPHeader::Timestamps{_sender.timestamp_value(), _ts_recent};
         }
-        // set window size
-        seg.header().win = _receiver.window_size() > 0xffff ? static_cast<uint16_t>(0xffff)
-                                                            : static_cast<uint16_t>(_receiver.window_size());
+        // echo congestion marks until the peer has reduced its window
+        if (_ecn_enabled && !seg.header().syn && _receiver.ce_echo()) {
+            seg.header().ece = true;
+        }
+        if (_sack_enabled && seg.header().ack) {
+            const size_t max_blocks =
+                _timestamps_enabled ? TCPHeader::MAX_SACK_BLOCKS_WITH_TIMESTAMPS : TCPHeader::MAX_SACK_BLOCKS;
+            seg.header().sack = _receiver.sack_blocks(max_blocks);
+            // on a data segment, only the blocks that fit beside its payload under the MTU (the pieces of an
+            // offloaded segment are each a full MSS)
+            const size_t payload = min(seg.payload().size(), _sender.max_payload_size());
+            while (!seg.header().sack.empty() &&
+                   seg.header().serialize_options().size() + payload > TCPConfig::MAX_PAYLOAD_SIZE) {
+                seg.header().sack.pop_back();
+            }
+        }
+
+        _segments_out.push(std::move(seg));
+    }
+}
 
-        _segments_out.push(seg);
+uint8_t TCPConnection::_window_scale_offer() const {
+    uint8_t shift = 0;
+    while (shift < TCPHeader::MAX_WINDOW_SCALE && (_cfg.recv_capacity >> shift) > 0xffff) {
+        shift++;
     }
+    return shift;
 }
 
 void TCPConnection::_rst() {
@@ -6,12 +6,23 @@
 #include "tcp_sender.hh"
 #include "tcp_state.hh"
 
+#include <algorithm>
+
 //! \brief A complete endpoint of a TCP connection
 class TCPConnection {
+  public:
+    //! Counts of segments the connection didn't need to send
+    struct Counters {
+        uint64_t nagle_coalesced = 0;  //!< small writes merged into a segment by Nagle's algorithm
+        uint64_t acks_avoided = 0;     //!< received segments whose ack was delayed into, or rode on, another
+    };
+
   private:
     TCPConfig _cfg;
-    TCPReceiver _receiver{_cfg.recv_capacity};
-    TCPSender _sender{_cfg.send_capacity, _cfg.rt_timeout, _cfg.fixed_isn};
+    TCPReceiver _receiver{_cfg.recv_capacity,
+                          _cfg.recv_storage,
+                          _cfg.sws_avoidance ? std::min(TCPConfig::MAX_PAYLOAD_SIZE, _cfg.recv_capacity / 2) : 0};
+    TCPSender _sender{_cfg};
 
     //! outbound queue of segments that the TCPConnection wants sent
     std::queue<TCPSegment> _segments_out{};
@@ -25,12 +36,49 @@ class TCPConnection {
     //! in case the remote TCPConnection doesn't know we've received its whole stream?
     bool _linger_after_streams_finish{true};
 
+    //! Did both sides' SYNs carry the SACK-permitted option?
+    bool _sack_enabled{false};
+
+    //! Did both sides agree to ECN (RFC 3168): a SYN with ECE and CWR, answered by a SYN-ACK with ECE?
+    bool _ecn_enabled{false};
+
+    //! \name Window scaling (RFC 7323)
+    //! Both shifts stay zero unless both sides' SYNs carried the window scale option
+    //!@{
+    bool _window_scaling_enabled{false};  //!< did both sides' SYNs carry the window scale option?
+    uint8_t _snd_wscale{0};               //!< shift applied to the windows the peer advertises
+    uint8_t _rcv_wscale{0};               //!< shift applied to the windows we advertise
+    //!@}
+
+    //! \name Timestamps (RFC 7323)
+    //!@{
+    bool _timestamps_enabled{false};  //!< did both sides' SYNs carry the timestamps option?
+    uint32_t _ts_recent{0};           //!< the TSval to echo: the peer's latest, from an in-window segment
+    std::optional<WrappingInt32> _last_ack_sent{};  //!< the ackno of our latest segment
+    //!@}
+
+    //! \name Acknowledgments
+    //!@{
+    size_t _segments_since_ack{0};             //!< segments received, occupying sequence numbers, since our last ack
+    std::optional<size_t> _ack_delayed_for{};  //!< how long the pending delayed ack has waited, if there is one
+    uint64_t _acks_avoided{0};                 //!< see Counters::acks_avoided
+    //!@}
+
+    //! Should the ack for `seg` be delayed? (see TCPConfig::delayed_ack)
+    bool _may_delay_ack(const TCPSegment &seg, const bool in_order) const;
+
+    //! The window scale we offer: the smallest shift that lets our receive capacity be advertised
+    uint8_t _window_scale_offer() const;
+
     bool _stream_finish() const {
         return _sender.fin_setted() && bytes_in_flight() == 0 && _receiver.stream_out().input_ended();
     }
     void _flush_segments_out();
     void _rst();
 
+    //! Send what was just written to the outbound stream, if anything; returns `len`, the bytes written
+    size_t _send_written(const size_t len);
+
   public:
     //! \name "Input" interface for the writer
     //!@{
@@ -42,11 +90,18 @@ class TCPConnection {
     //! \returns the number of bytes from `data` that were actually written.
     size_t write(const std::string &data);
 
+    //! \brief Write data to the outbound byte stream, taking ownership of its storage where possible
+    //! \returns the number of bytes from `data` that were actually written.
+    size_t write(std::string &&data);
+
     //! \returns the number of `bytes` that can be written right now.
     size_t remaining_outbound_capacity() const;
 
     //! \brief Shut down the outbound byte stream (still allows reading incoming data)
     void end_input_stream();
+
+    //! \brief Disable (or re-enable) Nagle's algorithm, like TCP_NODELAY
+    void set_nodelay(const bool nodelay) { _sender.set_nagle(!nodelay); }
     //!@}
 
     //! \name "Output" interface for the reader
@@ -65,6 +120,17 @@ class TCPConnection {
     size_t unassembled_bytes() const;
     //! \brief Number of milliseconds since the last segment was received
     size_t time_since_last_segment_received() const;
+    //! \brief Milliseconds until a paced segment is next released, if one is waiting (see TCPConfig::pacing)
+    std::optional<uint64_t> time_until_release() const { return _sender.time_until_release(); }
+    //! \brief Is anything waiting on the passage of time: a retransmission, persist, delayed-ack or pacing
+    //! timer, the linger after both streams end, or inbound bytes the application may read (which can call
+    //! for a window update)? While nothing is, calls to tick() can be saved up and made as one.
+    bool waiting_on_time() const;
+    //! \brief Segments avoided by Nagle's algorithm and by delayed and piggybacked acks
+    Counters counters() const { return {_sender.nagle_coalesced(), _acks_avoided}; }
+    //! \brief Bytes of memory held by the connection's buffers (both streams, the reassembler,
+    //! and segments awaiting acknowledgment)
+    size_t footprint() const { return _sender.footprint() + _receiver.footprint(); }
     //!< \brief summarize the state of the sender, receiver, and the connection
     TCPState state() const { return {_sender, _receiver, active(), _linger_after_streams_finish}; };
     //!@}
@@ -46,11 +46,20 @@ optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
 }
 
 //! Serialize a TCP segment and send it as the payload of a UDP datagram.
+//! A segment with more than TCPConfig::MAX_PAYLOAD_SIZE bytes of payload and options is first cut into
+//! pieces that fit, each sent in a datagram of its own.
 //! \param[in] seg is the TCP segment to write
 void TCPOverUDPSocketAdapter::write(TCPSegment &seg) {
     seg.header().sport = config().source.port();
     seg.header().dport = config().destination.port();
-    _sock.sendto(config().destination, seg.serialize(0));
+    const size_t max_payload = TCPConfig::MAX_PAYLOAD_SIZE - seg.header().serialize_options().size();
+    if (seg.payload().size() <= max_payload) {
+        _sock.sendto(config().destination, seg.serialize(0));
+        return;
+    }
+    for (const auto &piece : seg.split(max_payload)) {
+        _sock.sendto(config().destination, piece.serialize(0));
+    }
 }
 
 //! Specialize LossyFdAdapter to TCPOverUDPSocketAdapter
@@ -10,6 +10,15 @@ struct IPv4Header {
     static constexpr uint8_t DEFAULT_TTL = 128;  //!< A reasonable default TTL value
     static constexpr uint8_t PROTO_TCP = 6;      //!< Protocol number for [tcp](\ref rfc::rfc793)
 
+    //! \name ECN codepoints (RFC 3168), carried in the two low bits of `tos`
+    //!@{
+    static constexpr uint8_t ECN_MASK = 0b11;
+    static constexpr uint8_t NOT_ECT = 0b00;  //!< the transport is not ECN-capable
+    static constexpr uint8_t ECT_1 = 0b01;    //!< ECN-capable transport
+    static constexpr uint8_t ECT_0 = 0b10;    //!< ECN-capable transport
+    static constexpr uint8_t CE = 0b11;       //!< congestion experienced: marked by a router, instead of a drop
+    //!@}
+
     //! \struct IPv4Header
     //! ~~~{.txt}
     //!   0                   1                   2                   3
@@ -55,6 +64,9 @@ struct IPv4Header {
     //! Length of the payload
     uint16_t payload_length() const;
 
+    //! ECN codepoint, from `tos`
+    uint8_t ecn() const { return tos & ECN_MASK; }
+
     //! [pseudo-header's](\ref rfc::rfc793) contribution to the TCP checksum
     uint32_t pseudo_cksum() const;
 
@@ -10,7 +10,7 @@
 #include <random>
 #include <utility>
 
-//! An adapter class that adds random dropping behavior to an FD adapter
+//! An adapter class that adds random dropping, and congestion marking, behavior to an FD adapter
 template <typename AdapterT>
 class LossyFdAdapter {
   private:
@@ -29,6 +29,17 @@ class LossyFdAdapter {
         return loss != 0 && uint16_t(_rand()) < loss;
     }
 
+    //! \brief Mark an ECN-capable segment as having experienced congestion, as a router with an AQM might
+    //! \param[in] uplink is `true` to use the uplink marking probability, else use the downlink one
+    void _maybe_mark(TCPSegment &seg, bool uplink) {
+        const auto &cfg = _adapter.config();
+        const uint16_t rate = uplink ? cfg.ce_rate_up : cfg.ce_rate_dn;
+        const bool capable = seg.ecn() == IPv4Header::ECT_0 || seg.ecn() == IPv4Header::ECT_1;
+        if (capable && rate != 0 && uint16_t(_rand()) < rate) {
+            seg.ecn() = IPv4Header::CE;
+        }
+    }
+
   public:
     //! Conversion to a FileDescriptor by returning the underlying AdapterT
     operator const FileDescriptor &() const { return _adapter; }
@@ -37,6 +48,7 @@ class LossyFdAdapter {
     explicit LossyFdAdapter(AdapterT &&adapter) : _adapter(std::move(adapter)) {}
 
     //! \brief Read from the underlying AdapterT instance, potentially dropping the read datagram
+    //! or marking it CE
     //! \returns std::optional<TCPSegment> that is empty if the segment was dropped or if
     //!          the underlying AdapterT returned an empty value
     std::optional<TCPSegment> read() {
@@ -44,15 +56,21 @@ class LossyFdAdapter {
         if (_should_drop(false)) {
             return {};
         }
+        if (ret.has_value()) {
+            _maybe_mark(ret.value(), false);
+        }
         return ret;
     }
 
     //! \brief Write to the underlying AdapterT instance, potentially dropping the datagram to be written
+    //! or marking it CE
     //! \param[in] seg is the packet to either write or drop
+    //! \note Only adapters that wrap segments in IP carry the mark on to the peer.
     void write(TCPSegment &seg) {
         if (_should_drop(true)) {
             return;
         }
+        _maybe_mark(seg, true);
         return _adapter.write(seg);
     }
 
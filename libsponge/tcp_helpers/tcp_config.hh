@@ -2,6 +2,8 @@
 #define SPONGE_LIBSPONGE_TCP_CONFIG_HH
 
 #include "address.hh"
+#include "byte_stream.hh"
+#include "congestion_control.hh"
 #include "wrapping_integers.hh"
 
 #include <cstddef>
@@ -13,13 +15,64 @@ class TCPConfig {
   public:
     static constexpr size_t DEFAULT_CAPACITY = 64000;  //!< Default capacity
     static constexpr size_t MAX_PAYLOAD_SIZE = 1452;   //!< Max TCP payload that fits in either IPv4 or UDP datagram
+    //! Max payload of a segment built for segmentation offload: as many full segments as fit in 64 KiB
+    static constexpr size_t MAX_OFFLOAD_PAYLOAD_SIZE = 45 * MAX_PAYLOAD_SIZE;
     static constexpr uint16_t TIMEOUT_DFLT = 1000;     //!< Default re-transmit timeout is 1 second
+    static constexpr uint32_t RTO_MIN_DFLT = 200;      //!< Default lower bound on an adaptive timeout (as in Linux)
+    static constexpr uint32_t RTO_MAX_DFLT = 60000;    //!< Default upper bound on an adaptive timeout (RFC 6298)
+    static constexpr unsigned DUPACK_THRESHOLD = 3;    //!< Duplicate acks that trigger a fast retransmit
     static constexpr unsigned MAX_RETX_ATTEMPTS = 8;   //!< Maximum re-transmit attempts before giving up
+    static constexpr size_t INITIAL_CWND = 10 * MAX_PAYLOAD_SIZE;  //!< Default initial congestion window (RFC 6928)
+    static constexpr double PACING_GAIN_SLOW_START = 2.0;  //!< Pacing rate per cwnd/SRTT in slow start (as in Linux)
+    static constexpr double PACING_GAIN_AVOIDANCE = 1.2;   //!< Pacing rate per cwnd/SRTT otherwise (as in Linux)
+    static constexpr size_t PACING_BURST = 2 * MAX_PAYLOAD_SIZE;  //!< Most bytes a paced sender releases at once
+    static constexpr uint16_t DELAYED_ACK_TIMEOUT_DFLT = 200;     //!< Default delayed-ack timeout (as in BSD)
+    static constexpr uint32_t PERSIST_TIMEOUT_DFLT = 500;         //!< Default first zero-window probe interval
+    static constexpr uint32_t PERSIST_TIMEOUT_MAX_DFLT = 60000;   //!< Default bound on the backed-off interval
 
     uint16_t rt_timeout = TIMEOUT_DFLT;       //!< Initial value of the retransmission timeout, in milliseconds
+    bool adaptive_rto = false;                //!< Derive the retransmission timeout from measured RTTs (RFC 6298)
+    uint32_t rto_min = RTO_MIN_DFLT;          //!< Lower bound on the adaptive retransmission timeout, in milliseconds
+    uint32_t rto_max = RTO_MAX_DFLT;          //!< Upper bound on the (backed-off) adaptive timeout, in milliseconds
     size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes
     size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes
+    ByteStream::Storage recv_storage = ByteStream::Storage::Ring;  //!< How the inbound stream holds its bytes
+    ByteStream::Storage send_storage = ByteStream::Storage::Ring;  //!< How the outbound stream holds its bytes
     std::optional<WrappingInt32> fixed_isn{};
+    //! Congestion control used by the sender
+    CongestionControl::Algorithm congestion_control = CongestionControl::Algorithm::None;
+    size_t initial_cwnd = INITIAL_CWND;  //!< Initial congestion window, in bytes
+    bool fast_retransmit = false;        //!< Retransmit after DUPACK_THRESHOLD duplicate acks (RFC 5681)
+    bool limited_transmit = false;       //!< Send new data on the first two duplicate acks (RFC 3042)
+    bool sack = false;                   //!< Offer, and if the peer agrees use, selective acks (RFC 2018)
+    //! Offer, and if the peer agrees use, window scaling (RFC 7323), so that windows can exceed 64 KiB
+    bool window_scaling = false;
+    //! Offer, and if the peer agrees use, timestamps (RFC 7323): an RTT sample from every ack, and PAWS
+    bool timestamps = false;
+    //! Release segments over time at a pacing rate derived from cwnd/SRTT, rather than a window at a time
+    bool pacing = false;
+    //! Hold back segments smaller than the MSS while data is in flight (Nagle's algorithm, RFC 896)
+    bool nagle = false;
+    //! Acknowledge every second full-sized segment, or after `delayed_ack_timeout` (RFC 1122)
+    bool delayed_ack = false;
+    uint16_t delayed_ack_timeout = DELAYED_ACK_TIMEOUT_DFLT;  //!< Longest an ack is delayed, in milliseconds
+    //! Open the advertised window only in steps of min(MSS, half the receive capacity), and send a window
+    //! update whenever it opens by such a step (receiver-side SWS avoidance, RFC 1122)
+    bool sws_avoidance = false;
+    //! Probe a zero window from a persist timer, separate from the retransmission timer, whose interval
+    //! starts at `persist_timeout` and doubles after each probe, up to `persist_timeout_max` (RFC 1122)
+    bool persist_timer = false;
+    uint32_t persist_timeout = PERSIST_TIMEOUT_DFLT;          //!< First zero-window probe interval, in milliseconds
+    uint32_t persist_timeout_max = PERSIST_TIMEOUT_MAX_DFLT;  //!< Longest interval between probes, in milliseconds
+    //! Merge a run of small unacknowledged segments, up to the MSS, when retransmitting them
+    bool repacketize = false;
+    //! Build segments of up to MAX_OFFLOAD_PAYLOAD_SIZE bytes, for the adapter to cut into
+    //! MAX_PAYLOAD_SIZE pieces on the way out (segmentation offload)
+    bool segmentation_offload = false;
+    //! Offer, and if the peer agrees use, Explicit Congestion Notification (RFC 3168): new data goes out
+    //! ECN-capable, congestion marks are echoed back, and an echoed mark shrinks the congestion window
+    //! as a loss would, without a retransmission
+    bool ecn = false;
 };
 
 //! Config for classes derived from FdAdapter
@@ -30,6 +83,8 @@ class FdAdapterConfig {
 
     uint16_t loss_rate_dn = 0;  //!< Downlink loss rate (for LossyFdAdapter)
     uint16_t loss_rate_up = 0;  //!< Uplink loss rate (for LossyFdAdapter)
+    uint16_t ce_rate_dn = 0;    //!< Downlink rate of CE marks on ECN-capable segments (for LossyFdAdapter)
+    uint16_t ce_rate_up = 0;    //!< Uplink rate of CE marks on ECN-capable segments (for LossyFdAdapter)
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_CONFIG_HH
@@ -0,0 +1,147 @@
+#include "tcp_engine.hh"
+
+#include "address.hh"
+#include "tcp_over_ip.hh"
+
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+bool FourTuple::operator==(const FourTuple &other) const {
+    return local_address == other.local_address and local_port == other.local_port and
+           remote_address == other.remote_address and remote_port == other.remote_port;
+}
+
+string FourTuple::to_string() const {
+    return Address::from_ipv4_numeric(local_address).ip() + ":" + std::to_string(local_port) + " <-> " +
+           Address::from_ipv4_numeric(remote_address).ip() + ":" + std::to_string(remote_port);
+}
+
+//! \details The addresses and the ports are each packed into a 64-bit word, and the words are mixed by
+//! multiplying with odd constants, so that connections differing only in a port spread across buckets.
+size_t FourTupleHash::operator()(const FourTuple &tuple) const {
+    const uint64_t addresses = (uint64_t{tuple.local_address} << 32) | tuple.remote_address;
+    const uint64_t ports = (uint64_t{tuple.local_port} << 16) | tuple.remote_port;
+    const uint64_t h = addresses * 0x9e3779b97f4a7c15 ^ ports * 0xc2b2ae3d27d4eb4f;
+    return h ^ (h >> 32);
+}
+
+void TCPEngine::connect(const FourTuple &tuple) {
+    if (contains(tuple)) {
+        throw runtime_error("TCPEngine::connect: " + tuple.to_string() + " is already in use");
+    }
+    const auto it = _connections.try_emplace(tuple, _cfg, _time_ms).first;
+    it->second.connection.connect();
+    _service(it);
+}
+
+size_t TCPEngine::write(const FourTuple &tuple, string &&data) {
+    const auto it = _find(tuple);
+    _catch_up(it->second);
+    const size_t written = it->second.connection.write(move(data));
+    _service(it);
+    return written;
+}
+
+void TCPEngine::end_input_stream(const FourTuple &tuple) {
+    const auto it = _find(tuple);
+    _catch_up(it->second);
+    it->second.connection.end_input_stream();
+    _service(it);
+}
+
+void TCPEngine::datagram_received(const InternetDatagram &dgram) {
+    const auto seg = TCPOverIPv4Adapter::parse_tcp_in_ip(dgram);
+    if (not seg.has_value()) {
+        return;
+    }
+    const TCPHeader &header = seg->header();
+    const FourTuple tuple{dgram.header().dst, header.dport, dgram.header().src, header.sport};
+
+    auto it = _connections.find(tuple);
+    if (it == _connections.end()) {
+        if (not header.syn or header.ack or header.rst or _listening.count(header.dport) == 0) {
+            _reset(tuple, seg.value());
+            return;
+        }
+        it = _connections.try_emplace(tuple, _cfg, _time_ms).first;
+        _accepted.push(tuple);
+    } else {
+        _catch_up(it->second);
+    }
+
+    it->second.connection.segment_received(seg.value());
+    _service(it);
+}
+
+//! \details The connections to visit are copied first, since visiting one can end its wait.
+void TCPEngine::tick(const size_t ms_since_last_tick) {
+    _time_ms += ms_since_last_tick;
+
+    const vector<FourTuple> due(_timed.begin(), _timed.end());
+    for (const auto &tuple : due) {
+        const auto it = _connections.find(tuple);
+        _catch_up(it->second);
+        _service(it);
+    }
+}
+
+void TCPEngine::_catch_up(Entry &entry) {
+    if (entry.ticked_ms < _time_ms) {
+        entry.connection.tick(_time_ms - entry.ticked_ms);
+        entry.ticked_ms = _time_ms;
+    }
+}
+
+void TCPEngine::_service(const Table::iterator it) {
+    TCPConnection &connection = it->second.connection;
+    while (not connection.segments_out().empty()) {
+        _send(it->first, connection.segments_out().front());
+        connection.segments_out().pop();
+    }
+
+    // a finished connection stays (and is visited by tick) until the application has read what arrived
+    const ByteStream &inbound = connection.inbound_stream();
+    if (not connection.active() and (inbound.buffer_empty() or inbound.error())) {
+        _timed.erase(it->first);
+        _connections.erase(it);
+        _closed++;
+    } else if (not connection.active() or connection.waiting_on_time()) {
+        _timed.insert(it->first);
+    } else {
+        _timed.erase(it->first);
+    }
+}
+
+void TCPEngine::_send(const FourTuple &tuple, TCPSegment &seg) {
+    for (auto &dgram : TCPOverIPv4Adapter::wrap_tcp_in_ip(
+             seg, tuple.local_address, tuple.local_port, tuple.remote_address, tuple.remote_port)) {
+        _datagrams_out.push(move(dgram));
+    }
+}
+
+//! \details As in RFC 793: a RST takes its seqno from the segment's ackno, or else acknowledges the segment.
+void TCPEngine::_reset(const FourTuple &tuple, const TCPSegment &seg) {
+    if (seg.header().rst) {
+        return;
+    }
+
+    TCPSegment rst;
+    rst.header().rst = true;
+    if (seg.header().ack) {
+        rst.header().seqno = seg.header().ackno;
+    } else {
+        rst.header().ack = true;
+        rst.header().ackno = seg.header().seqno + seg.length_in_sequence_space();
+    }
+    _send(tuple, rst);
+}
+
+TCPEngine::Table::iterator TCPEngine::_find(const FourTuple &tuple) {
+    const auto it = _connections.find(tuple);
+    if (it == _connections.end()) {
+        throw runtime_error("TCPEngine: no connection " + tuple.to_string());
+    }
+    return it;
+}
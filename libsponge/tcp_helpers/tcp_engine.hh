@@ -0,0 +1,163 @@
+#ifndef SPONGE_LIBSPONGE_TCP_ENGINE_HH
+#define SPONGE_LIBSPONGE_TCP_ENGINE_HH
+
+#include "byte_stream.hh"
+#include "ipv4_datagram.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_segment.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+//! \brief The addresses and ports of a TCP connection, in host byte order, as seen from this end
+struct FourTuple {
+    uint32_t local_address{0};
+    uint16_t local_port{0};
+    uint32_t remote_address{0};
+    uint16_t remote_port{0};
+
+    bool operator==(const FourTuple &other) const;
+    bool operator!=(const FourTuple &other) const { return not(*this == other); }
+
+    //! Human-readable string, e.g., "10.0.0.1:80 <-> 10.0.0.2:1024"
+    std::string to_string() const;
+};
+
+//! \brief Hash of a FourTuple, for the connection table
+struct FourTupleHash {
+    size_t operator()(const FourTuple &tuple) const;
+};
+
+//! \brief Many TCP connections over one stream of IPv4 datagrams
+class TCPEngine {
+  private:
+    //! A connection, and how much of the engine's time it has been told about
+    struct Entry {
+        TCPConnection connection;
+        uint64_t ticked_ms;
+
+        Entry(const TCPConfig &cfg, const uint64_t now) : connection(cfg), ticked_ms(now) {}
+    };
+
+    using Table = std::unordered_map<FourTuple, Entry, FourTupleHash>;
+
+    TCPConfig _cfg;        //!< configuration for every connection
+    uint64_t _time_ms{0};  //!< milliseconds passed to tick() so far
+    Table _connections{};  //!< every connection still active, by its addresses and ports
+    uint64_t _closed{0};   //!< connections that have finished and been dropped from the table
+
+    std::unordered_set<uint16_t> _listening{};              //!< local ports that accept new connections
+    std::unordered_set<FourTuple, FourTupleHash> _timed{};  //!< connections waiting on time
+    std::queue<FourTuple> _accepted{};                      //!< connections opened by a peer
+    std::queue<InternetDatagram> _datagrams_out{};          //!< outbound datagrams, from every connection
+
+    //! Tell a connection about the time since it was last told
+    void _catch_up(Entry &entry);
+
+    //! Move a connection's outbound segments to the shared queue, and note whether it's waiting on time
+    //! (or drop it from the table once it has finished and its inbound bytes have been read)
+    void _service(const Table::iterator it);
+
+    //! Wrap a segment in datagrams for the shared queue
+    void _send(const FourTuple &tuple, TCPSegment &seg);
+
+    //! Answer a segment that belongs to no connection, unless it's a RST itself
+    void _reset(const FourTuple &tuple, const TCPSegment &seg);
+
+    //! The connection with these addresses and ports; throws if there isn't one
+    Table::iterator _find(const FourTuple &tuple);
+
+  public:
+    //! Construct an engine whose connections all use the given configuration
+    explicit TCPEngine(const TCPConfig &cfg) : _cfg{cfg} {}
+
+    //! \name Opening connections
+    //!@{
+
+    //! \brief Accept connections to a local port
+    void listen(const uint16_t port) { _listening.insert(port); }
+
+    //! \brief Open a connection by sending a SYN
+    //! \note throws if there's already a connection with these addresses and ports
+    void connect(const FourTuple &tuple);
+
+    //! \brief Connections a peer has opened (each from its SYN), not yet taken by the owner
+    //! \note A connection may have been reset, and dropped from the table, by the time it's taken.
+    std::queue<FourTuple> &accepted() { return _accepted; }
+    //!@}
+
+    //! \name The application's side of a connection
+    //!@{
+
+    //! \brief Write data to a connection's outbound byte stream, and send it if possible
+    //! \returns the number of bytes from `data` that were actually written.
+    size_t write(const FourTuple &tuple, std::string &&data);
+
+    //! \brief Shut down a connection's outbound byte stream
+    void end_input_stream(const FourTuple &tuple);
+
+    //! \brief A connection's inbound byte stream
+    //! \note Reading may open the receive window; the update goes out on the next tick().
+    ByteStream &inbound_stream(const FourTuple &tuple) { return _find(tuple)->second.connection.inbound_stream(); }
+
+    //! \brief A connection, for its state and accessors
+    const TCPConnection &connection(const FourTuple &tuple) { return _find(tuple)->second.connection; }
+
+    //! \brief Is there an active connection with these addresses and ports?
+    bool contains(const FourTuple &tuple) const { return _connections.count(tuple) > 0; }
+    //!@}
+
+    //! \name Methods for the owner or operating system to call
+    //!@{
+
+    //! \brief Called when a datagram has been received from the network
+    //! \details Its segment goes to the connection with matching addresses and ports; a SYN to a
+    //! listening port opens a new one. Anything else that isn't a RST is answered with one.
+    void datagram_received(const InternetDatagram &dgram);
+
+    //! \brief Called periodically when time elapses
+    //! \details Only the connections waiting on time are ticked; the rest are told about the time
+    //! that has passed when something next happens to them.
+    void tick(const size_t ms_since_last_tick);
+
+    //! \brief Datagrams that the connections have enqueued for transmission, in the order they were sent
+    std::queue<InternetDatagram> &datagrams_out() { return _datagrams_out; }
+    //!@}
+
+    //! \name Accessors
+    //!@{
+
+    //! \brief Number of active connections
+    size_t size() const { return _connections.size(); }
+
+    //! \brief Number of active connections that each tick() has to visit
+    size_t timed() const { return _timed.size(); }
+
+    //! \brief Number of connections that have finished
+    uint64_t closed() const { return _closed; }
+    //!@}
+};
+
+//! \class TCPEngine
+//! The engine plays the part of the kernel for every connection on one IPv4 endpoint. It doesn't do
+//! any I/O: the owner moves datagrams between it and a single device (e.g. one TunFD), and calls
+//! tick() on one timer for all of the connections, much as it would for a NetworkInterface:
+//!
+//!     InternetDatagram dgram;
+//!     if (dgram.parse(tun.read()) == ParseResult::NoError) {
+//!         engine.datagram_received(dgram);
+//!     }
+//!     while (not engine.datagrams_out().empty()) {
+//!         tun.write(engine.datagrams_out().front().serialize());
+//!         engine.datagrams_out().pop();
+//!     }
+//!
+//! Each inbound segment reaches its connection by one lookup in a hash table keyed on the
+//! (local address, local port, remote address, remote port) four-tuple.
+
+#endif  // SPONGE_LIBSPONGE_TCP_ENGINE_HH
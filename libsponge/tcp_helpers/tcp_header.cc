@@ -1,9 +1,20 @@
 #include "tcp_header.hh"
 
+#include <algorithm>
 #include <sstream>
 
 using namespace std;
 
+//! TCP option kinds
+enum : uint8_t {
+    OPT_EOL = 0,
+    OPT_NOP = 1,
+    OPT_WINDOW_SCALE = 3,
+    OPT_SACK_PERMITTED = 4,
+    OPT_SACK = 5,
+    OPT_TIMESTAMPS = 8,
+};
+
 //! \param[in,out] p is a NetParser from which the TCP fields will be extracted
 //! \returns a ParseResult indicating success or the reason for failure
 //! \details It is important to check for (at least) the following potential errors
@@ -14,6 +25,9 @@ using namespace std;
 //! - the header's `doff` field is shorter than the minimum allowed
 //! - there is less data in the header than the `doff` field claims
 //! - the checksum is bad
+//!
+//! Options with unknown kinds are skipped. A malformed option (a length that is too short or
+//! runs past `doff`) ends the parsing of options, and the rest of them are ignored.
 ParseResult TCPHeader::parse(NetParser &p) {
     sport = p.u16();                 // source port
     dport = p.u16();                 // destination port
@@ -22,7 +36,9 @@ ParseResult TCPHeader::parse(NetParser &p) {
     doff = p.u8() >> 4;              // data offset
 
     const uint8_t fl_b = p.u8();                  // byte including flags
-    urg = static_cast<bool>(fl_b & 0b0010'0000);  // binary literals and ' digit separator since C++14!!!
+    cwr = static_cast<bool>(fl_b & 0b1000'0000);  // binary literals and ' digit separator since C++14!!!
+    ece = static_cast<bool>(fl_b & 0b0100'0000);
+    urg = static_cast<bool>(fl_b & 0b0010'0000);
     ack = static_cast<bool>(fl_b & 0b0001'0000);
     psh = static_cast<bool>(fl_b & 0b0000'1000);
     rst = static_cast<bool>(fl_b & 0b0000'0100);
@@ -37,8 +53,48 @@ ParseResult TCPHeader::parse(NetParser &p) {
         return ParseResult::HeaderTooShort;
     }
 
-    // skip any options or anything extra in the header
-    p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
+    window_scale.reset();
+    sack_permitted = false;
+    timestamps.reset();
+    sack.clear();
+    size_t options_left = doff * 4 - TCPHeader::LENGTH;
+    while (options_left > 0 and not p.error()) {
+        const uint8_t kind = p.u8();
+        options_left--;
+        if (kind == OPT_EOL) {
+            break;
+        } else if (kind == OPT_NOP) {
+            continue;
+        }
+
+        if (options_left == 0) {
+            break;
+        }
+        const uint8_t len = p.u8();
+        options_left--;
+        if (len < 2 or size_t{len} - 2 > options_left) {
+            break;
+        }
+        options_left -= len - 2;
+        if (kind == OPT_WINDOW_SCALE and len == 3) {
+            window_scale = p.u8();
+        } else if (kind == OPT_SACK_PERMITTED and len == 2) {
+            sack_permitted = true;
+        } else if (kind == OPT_TIMESTAMPS and len == 10) {
+            const uint32_t tsval = p.u32();
+            timestamps = Timestamps{tsval, p.u32()};
+        } else if (kind == OPT_SACK and len % 8 == 2) {
+            for (unsigned i = 0; i < len / 8; i++) {
+                const WrappingInt32 left{p.u32()};
+                sack.emplace_back(left, WrappingInt32{p.u32()});
+            }
+        } else {
+            p.remove_prefix(len - 2);
+        }
+    }
+
+    // skip any options left or anything extra in the header
+    p.remove_prefix(options_left);
 
     if (p.error()) {
         return p.get_error();
@@ -48,23 +104,31 @@ ParseResult TCPHeader::parse(NetParser &p) {
 }
 
 //! Serialize the TCPHeader to a string (does not recompute the checksum)
+//! \note The data offset written is `doff`, or more if the options need it
 string TCPHeader::serialize() const {
     // sanity check
     if (doff < 5) {
         throw runtime_error("TCP header too short");
     }
 
+    const string options = serialize_options();
+    if (options.size() > MAX_OPTIONS_LENGTH) {
+        throw runtime_error("TCP options too long");
+    }
+    const uint8_t data_offset = max(doff, static_cast<uint8_t>((LENGTH + options.size()) / 4));
+
     string ret;
-    ret.reserve(4 * doff);
+    ret.reserve(4 * data_offset);
 
     NetUnparser::u16(ret, sport);              // source port
     NetUnparser::u16(ret, dport);              // destination port
     NetUnparser::u32(ret, seqno.raw_value());  // sequence number
     NetUnparser::u32(ret, ackno.raw_value());  // ack number
-    NetUnparser::u8(ret, doff << 4);           // data offset
+    NetUnparser::u8(ret, data_offset << 4);    // data offset
 
-    const uint8_t fl_b = (urg ? 0b0010'0000 : 0) | (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) |
-                         (rst ? 0b0000'0100 : 0) | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
+    const uint8_t fl_b = (cwr ? 0b1000'0000 : 0) | (ece ? 0b0100'0000 : 0) | (urg ? 0b0010'0000 : 0) |
+                         (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) | (rst ? 0b0000'0100 : 0) |
+                         (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
     NetUnparser::u8(ret, fl_b);  // flags
     NetUnparser::u16(ret, win);  // window size
 
@@ -72,11 +136,36 @@ string TCPHeader::serialize() const {
 
     NetUnparser::u16(ret, uptr);  // urgent pointer
 
-    ret.resize(4 * doff);  // expand header to advertised size
+    ret.append(options);
+    ret.resize(4 * data_offset);  // expand header to advertised size
 
     return ret;
 }
 
+//! \details Each option is preceded by NOPs that align what follows it to four bytes, as in RFC 2018's examples
+string TCPHeader::serialize_options() const {
+    string ret;
+    if (window_scale.has_value()) {
+        ret.append({OPT_NOP, OPT_WINDOW_SCALE, 3, static_cast<char>(window_scale.value())});
+    }
+    if (sack_permitted) {
+        ret.append({OPT_NOP, OPT_NOP, OPT_SACK_PERMITTED, 2});
+    }
+    if (timestamps.has_value()) {
+        ret.append({OPT_NOP, OPT_NOP, OPT_TIMESTAMPS, 10});
+        NetUnparser::u32(ret, timestamps->tsval);
+        NetUnparser::u32(ret, timestamps->tsecr);
+    }
+    if (not sack.empty()) {
+        ret.append({OPT_NOP, OPT_NOP, OPT_SACK, static_cast<char>(2 + 8 * sack.size())});
+        for (const auto &[left, right] : sack) {
+            NetUnparser::u32(ret, left.raw_value());
+            NetUnparser::u32(ret, right.raw_value());
+        }
+    }
+    return ret;
+}
+
 //! \returns A string with the header's contents
 string TCPHeader::to_string() const {
     stringstream ss{};
@@ -86,23 +175,43 @@ string TCPHeader::to_string() const {
        << "TCP ackno: " << ackno << '\n'
        << "TCP doff: " << +doff << '\n'
        << "Flags: urg: " << urg << " ack: " << ack << " psh: " << psh << " rst: " << rst << " syn: " << syn
-       << " fin: " << fin << '\n'
+       << " fin: " << fin << " ece: " << ece << " cwr: " << cwr << '\n'
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
-       << "TCP uptr: " << +uptr << '\n';
+       << "TCP uptr: " << +uptr << '\n'
+       << "TCP window scale: " << (window_scale.has_value() ? std::to_string(window_scale.value()) : "none") << '\n'
+       << "TCP SACK permitted: " << sack_permitted << '\n';
+    if (timestamps.has_value()) {
+        ss << "TCP timestamps: TSval " << timestamps->tsval << " TSecr " << timestamps->tsecr << '\n';
+    }
+    for (const auto &[left, right] : sack) {
+        ss << "TCP SACK block: " << left << " - " << right << '\n';
+    }
     return ss.str();
 }
 
 string TCPHeader::summary() const {
     stringstream ss{};
     ss << "Header(flags=" << (syn ? "S" : "") << (ack ? "A" : "") << (rst ? "R" : "") << (fin ? "F" : "")
-       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << ")";
+       << (ece ? "E" : "") << (cwr ? "C" : "") << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win;
+    if (window_scale.has_value()) {
+        ss << ",wscale=" << +window_scale.value();
+    }
+    if (timestamps.has_value()) {
+        ss << ",ts=" << timestamps->tsval << "/" << timestamps->tsecr;
+    }
+    for (const auto &[left, right] : sack) {
+        ss << ",sack=" << left << "-" << right;
+    }
+    ss << ")";
     return ss.str();
 }
 
 bool TCPHeader::operator==(const TCPHeader &other) const {
     // TODO(aozdemir) more complete check (right now we omit cksum, src, dst
-    return seqno == other.seqno && ackno == other.ackno && doff == other.doff && urg == other.urg && ack == other.ack &&
-           psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && win == other.win &&
-           uptr == other.uptr;
+    return seqno == other.seqno && ackno == other.ackno && doff == other.doff && cwr == other.cwr &&
+           ece == other.ece && urg == other.urg && ack == other.ack && psh == other.psh && rst == other.rst &&
+           syn == other.syn && fin == other.fin && win == other.win && uptr == other.uptr &&
+           window_scale == other.window_scale && sack_permitted == other.sack_permitted &&
+           timestamps == other.timestamps && sack == other.sack;
 }
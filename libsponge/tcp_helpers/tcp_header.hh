@@ -4,10 +4,21 @@
 #include "parser.hh"
 #include "wrapping_integers.hh"
 
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
+//! \note The window scale and timestamps (RFC 7323), SACK-permitted and SACK (RFC 2018) options are
+//! supported; other options are skipped.
 struct TCPHeader {
-    static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t LENGTH = 20;            //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t MAX_OPTIONS_LENGTH = 40;  //!< The most option bytes that fit in `doff`
+    static constexpr size_t MAX_SACK_BLOCKS = 4;      //!< The most SACK blocks that fit in the options
+    static constexpr size_t MAX_SACK_BLOCKS_WITH_TIMESTAMPS = 3;  //!< ... alongside the timestamps option
+    static constexpr size_t TIMESTAMPS_OPTION_LENGTH = 12;        //!< Bytes the timestamps option takes, padded
+    static constexpr uint8_t MAX_WINDOW_SCALE = 14;   //!< The largest window scale shift allowed (RFC 7323)
 
     //! \struct TCPHeader
     //! ~~~{.txt}
@@ -20,9 +31,9 @@ struct TCPHeader {
     //!  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
     //!  |                    Acknowledgment Number                      |
     //!  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-    //!  |  Data |           |U|A|P|R|S|F|                               |
-    //!  | Offset| Reserved  |R|C|S|S|Y|I|            Window             |
-    //!  |       |           |G|K|H|T|N|N|                               |
+    //!  |  Data |       |C|E|U|A|P|R|S|F|                               |
+    //!  | Offset| Rsrvd |W|C|R|C|S|S|Y|I|            Window             |
+    //!  |       |       |R|E|G|K|H|T|N|N|                               |
     //!  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
     //!  |           Checksum            |         Urgent Pointer        |
     //!  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
@@ -39,6 +50,8 @@ struct TCPHeader {
     WrappingInt32 seqno{0};     //!< sequence number
     WrappingInt32 ackno{0};     //!< ack number
     uint8_t doff = LENGTH / 4;  //!< data offset
+    bool cwr = false;           //!< congestion window reduced flag (RFC 3168)
+    bool ece = false;           //!< ECN-echo flag (RFC 3168)
     bool urg = false;           //!< urgent flag
     bool ack = false;           //!< ack flag
     bool psh = false;           //!< push flag
@@ -50,12 +63,33 @@ struct TCPHeader {
     uint16_t uptr = 0;          //!< urgent pointer
     //!@}
 
+    //! The timestamps option (RFC 7323)
+    struct Timestamps {
+        uint32_t tsval = 0;  //!< the sender's clock when the segment was sent
+        uint32_t tsecr = 0;  //!< the most recent TSval received from the peer, echoed back
+
+        bool operator==(const Timestamps &other) const { return tsval == other.tsval && tsecr == other.tsecr; }
+        bool operator!=(const Timestamps &other) const { return !(*this == other); }
+    };
+
+    //! \name TCP options
+    //! Serialized after the fixed header, padded with NOPs, with `doff` grown to fit them
+    //!@{
+    std::optional<uint8_t> window_scale{};                        //!< Window scale shift, only sent on a SYN
+    bool sack_permitted = false;                                  //!< SACK-permitted option, only sent on a SYN
+    std::optional<Timestamps> timestamps{};                       //!< Timestamps option
+    std::vector<std::pair<WrappingInt32, WrappingInt32>> sack{};  //!< SACK blocks: [left edge, right edge)
+    //!@}
+
     //! Parse the TCP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
     //! Serialize the TCP fields
     std::string serialize() const;
 
+    //! Serialize the TCP options, padded to a multiple of four bytes
+    std::string serialize_options() const;
+
     //! Return a string containing a header in human-readable format
     std::string to_string() const;
 
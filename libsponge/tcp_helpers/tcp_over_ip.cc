@@ -35,16 +35,11 @@ optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram
         return {};
     }
 
-    // does the IPv4 datagram claim that its payload is a TCP segment?
-    if (ip_dgram.header().proto != IPv4Header::PROTO_TCP) {
-        return {};
-    }
-
-    // is the payload a valid TCP segment?
-    TCPSegment tcp_seg;
-    if (ParseResult::NoError != tcp_seg.parse(ip_dgram.payload(), ip_dgram.header().pseudo_cksum())) {
+    auto parsed = parse_tcp_in_ip(ip_dgram);
+    if (not parsed.has_value()) {
         return {};
     }
+    TCPSegment &tcp_seg = parsed.value();
 
     // is the TCP segment for us?
     if (tcp_seg.header().dport != config().source.port()) {
@@ -67,24 +62,61 @@ optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram
         return {};
     }
 
+    return parsed;
+}
+
+//! \details The segment carries the datagram's ECN codepoint.
+optional<TCPSegment> TCPOverIPv4Adapter::parse_tcp_in_ip(const InternetDatagram &ip_dgram) {
+    // does the IPv4 datagram claim that its payload is a TCP segment?
+    if (ip_dgram.header().proto != IPv4Header::PROTO_TCP) {
+        return {};
+    }
+
+    // is the payload a valid TCP segment?
+    TCPSegment tcp_seg;
+    if (ParseResult::NoError != tcp_seg.parse(ip_dgram.payload(), ip_dgram.header().pseudo_cksum())) {
+        return {};
+    }
+
+    tcp_seg.ecn() = ip_dgram.header().ecn();
     return tcp_seg;
 }
 
-//! Takes a TCP segment, sets port numbers as necessary, and wraps it in an IPv4 datagram
+//! Takes a TCP segment, sets port numbers as necessary, and wraps it in IPv4 datagrams: just one, unless
+//! the segment has more than TCPConfig::MAX_PAYLOAD_SIZE bytes of payload and options, when it is cut into
+//! pieces that fit.
+//! The datagrams carry the segment's ECN codepoint.
 //! \param[in] seg is the TCP segment to convert
-InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg) {
-    // set the port numbers in the TCP segment
-    seg.header().sport = config().source.port();
-    seg.header().dport = config().destination.port();
+vector<InternetDatagram> TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg) {
+    return wrap_tcp_in_ip(seg,
+                          config().source.ipv4_numeric(),
+                          config().source.port(),
+                          config().destination.ipv4_numeric(),
+                          config().destination.port());
+}
 
-    // create an Internet Datagram and set its addresses and length
-    InternetDatagram ip_dgram;
-    ip_dgram.header().src = config().source.ipv4_numeric();
-    ip_dgram.header().dst = config().destination.ipv4_numeric();
-    ip_dgram.header().len = ip_dgram.header().hlen * 4 + seg.header().doff * 4 + seg.payload().size();
+vector<InternetDatagram> TCPOverIPv4Adapter::wrap_tcp_in_ip(
+    TCPSegment &seg, const uint32_t src, const uint16_t sport, const uint32_t dst, const uint16_t dport) {
+    // set the port numbers in the TCP segment
+    seg.header().sport = sport;
+    seg.header().dport = dport;
 
-    // set payload, calculating TCP checksum using information from IP header
-    ip_dgram.payload() = seg.serialize(ip_dgram.header().pseudo_cksum());
+    // the pieces carry the segment's options, which take room from their payloads
+    const size_t max_payload = TCPConfig::MAX_PAYLOAD_SIZE - seg.header().serialize_options().size();
+    vector<InternetDatagram> datagrams;
+    for (const auto &piece : seg.split(max_payload)) {
+        // create an Internet Datagram and set its addresses and length
+        InternetDatagram ip_dgram;
+        ip_dgram.header().src = src;
+        ip_dgram.header().dst = dst;
+        ip_dgram.header().tos = piece.ecn();
+        // (the header is measured serialized, since `doff` doesn't yet count any options)
+        const size_t tcp_len = piece.header().serialize().size() + piece.payload().size();
+        ip_dgram.header().len = ip_dgram.header().hlen * 4 + tcp_len;
 
-    return ip_dgram;
+        // set payload, calculating TCP checksum using information from IP header
+        ip_dgram.payload() = piece.serialize(ip_dgram.header().pseudo_cksum());
+        datagrams.push_back(move(ip_dgram));
+    }
+    return datagrams;
 }
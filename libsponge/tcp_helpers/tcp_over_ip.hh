@@ -6,14 +6,31 @@
 #include "ipv4_datagram.hh"
 #include "tcp_segment.hh"
 
+#include <cstdint>
 #include <optional>
+#include <vector>
 
 //! \brief A converter from TCP segments to serialized IPv4 datagrams
 class TCPOverIPv4Adapter : public FdAdapterBase {
   public:
     std::optional<TCPSegment> unwrap_tcp_in_ip(const InternetDatagram &ip_dgram);
 
-    InternetDatagram wrap_tcp_in_ip(TCPSegment &seg);
+    std::vector<InternetDatagram> wrap_tcp_in_ip(TCPSegment &seg);
+
+    //! \name Conversions for any pair of endpoints, rather than the configured connection's
+    //!@{
+
+    //! \brief Parse the TCP segment in a datagram, whatever its addresses and ports
+    //! \returns nothing if the datagram doesn't carry a valid TCP segment
+    static std::optional<TCPSegment> parse_tcp_in_ip(const InternetDatagram &ip_dgram);
+
+    //! \brief Wrap a TCP segment in IPv4 datagrams, from `src`:`sport` to `dst`:`dport` (in host byte order)
+    static std::vector<InternetDatagram> wrap_tcp_in_ip(TCPSegment &seg,
+                                                        const uint32_t src,
+                                                        const uint16_t sport,
+                                                        const uint32_t dst,
+                                                        const uint16_t dport);
+    //!@}
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_OVER_IP_HH
@@ -3,6 +3,7 @@
 #include "parser.hh"
 #include "util.hh"
 
+#include <algorithm>
 #include <variant>
 
 using namespace std;
@@ -26,6 +27,31 @@ size_t TCPSegment::length_in_sequence_space() const {
     return payload().str().size() + (header().syn ? 1 : 0) + (header().fin ? 1 : 0);
 }
 
+//! \details Each piece has a copy of the header, options included, with its own seqno, and the ECN
+//! codepoint. The SYN and CWR flags go with the first piece, and the FIN and PSH flags with the last.
+//! The payloads are slices of this one's, and the checksums are left to serialize().
+vector<TCPSegment> TCPSegment::split(const size_t max_payload) const {
+    vector<TCPSegment> pieces;
+    size_t offset = 0;
+    do {
+        const size_t len = min(max_payload, _payload.size() - offset);
+        TCPSegment piece;
+        piece._header = _header;
+        piece._header.seqno = _header.seqno + (offset > 0 ? offset + (_header.syn ? 1 : 0) : 0);
+        piece._header.syn = _header.syn and offset == 0;
+        piece._header.cwr = _header.cwr and offset == 0;
+        piece._ecn = _ecn;
+        piece._payload = _payload;
+        piece._payload.remove_prefix(offset);
+        piece._payload.remove_suffix(piece._payload.size() - len);
+        offset += len;
+        piece._header.fin = _header.fin and offset == _payload.size();
+        piece._header.psh = _header.psh and offset == _payload.size();
+        pieces.push_back(move(piece));
+    } while (offset < _payload.size());
+    return pieces;
+}
+
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
 BufferList TCPSegment::serialize(const uint32_t datagram_layer_checksum) const {
     TCPHeader header_out = _header;
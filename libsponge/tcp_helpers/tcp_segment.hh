@@ -2,15 +2,18 @@
 #define SPONGE_LIBSPONGE_TCP_SEGMENT_HH
 
 #include "buffer.hh"
+#include "ipv4_header.hh"
 #include "tcp_header.hh"
 
 #include <cstdint>
+#include <vector>
 
 //! \brief [TCP](\ref rfc::rfc793) segment
 class TCPSegment {
   private:
     TCPHeader _header{};
     Buffer _payload{};
+    uint8_t _ecn{IPv4Header::NOT_ECT};
 
   public:
     //! \brief Parse the segment from a string
@@ -26,11 +29,20 @@ class TCPSegment {
 
     const Buffer &payload() const { return _payload; }
     Buffer &payload() { return _payload; }
+
+    //! The ECN codepoint of the datagram the segment arrived in, or is to be sent in (see IPv4Header::ecn)
+    //! \note It isn't part of the segment: only adapters that wrap segments in IP carry it.
+    uint8_t ecn() const { return _ecn; }
+    uint8_t &ecn() { return _ecn; }
     //!@}
 
     //! \brief Segment's length in sequence space
     //! \note Equal to payload length plus one byte if SYN is set, plus one byte if FIN is set
     size_t length_in_sequence_space() const;
+
+    //! \brief Cut the segment into segments carrying at most `max_payload` bytes each
+    //! \note Used to put a large segment from a sender using segmentation offload on the wire.
+    std::vector<TCPSegment> split(const size_t max_payload) const;
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_SEGMENT_HH
@@ -5,6 +5,7 @@
 #include "tun.hh"
 #include "util.hh"
 
+#include <algorithm>
 #include <cstddef>
 #include <exception>
 #include <iostream>
@@ -25,7 +26,10 @@ template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
     auto base_time = timestamp_ms();
     while (condition()) {
-        auto ret = _eventloop.wait_next_event(TCP_TICK_MS);
+        // wake in time for the next paced segment, if that comes before the next tick
+        const auto release = _tcp.value().time_until_release();
+        const size_t timeout = release.has_value() ? min<uint64_t>(release.value(), TCP_TICK_MS) : TCP_TICK_MS;
+        auto ret = _eventloop.wait_next_event(timeout);
         if (ret == EventLoop::Result::Exit or _abort) {
             break;
         }
@@ -96,7 +100,7 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
         _thread_data,
         Direction::In,
         [&] {
-            const auto data = _thread_data.read(_tcp->remaining_outbound_capacity());
+            auto data = _thread_data.read(_tcp->remaining_outbound_capacity());
             const auto len = data.size();
             const auto amount_written = _tcp->write(move(data));
             if (amount_written != len) {
@@ -126,11 +130,10 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
         [&] {
             ByteStream &inbound = _tcp->inbound_stream();
             // Write from the inbound_stream into
-            // the pipe, handling the possibility of a partial
+            // the pipe, straight out of the stream's buffer,
+            // handling the possibility of a partial
             // write (i.e., only pop what was actually written).
-            const size_t amount_to_write = min(size_t(65536), inbound.buffer_size());
-            const std::string buffer = inbound.peek_output(amount_to_write);
-            const auto bytes_written = _thread_data.write(move(buffer), false);
+            const auto bytes_written = _thread_data.write(inbound.peek_spans(inbound.buffer_size()), false);
             inbound.pop_output(bytes_written);
 
             if (inbound.eof() or inbound.error()) {
@@ -1,5 +1,7 @@
 #include "tcp_receiver.hh"
 
+#include <algorithm>
+
 // Dummy implementation of a TCP receiver
 
 // For Lab 2, please replace with a real implementation that passes the
@@ -11,6 +13,14 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 using namespace std;
 
 void TCPReceiver::segment_received(const TCPSegment &seg) {
+    // a CWR and a CE mark on the same segment leave the echo on, for the new congestion
+    if (seg.header().cwr) {
+        _ce_echo = false;
+    }
+    if (seg.ecn() == IPv4Header::CE) {
+        _ce_echo = true;
+    }
+
     if (!isn.has_value()) {
         // detect SYN (LISTEN)
         if (seg.header().syn) {
@@ -23,8 +33,10 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
         // receive data (SYN_RECV)
         WrappingInt32 payload_seqno = seg.header().syn ? seg.header().seqno + 1 : seg.header().seqno;
         uint64_t payload_absolute_seqno = unwrap(payload_seqno, isn.value(), absolute_ackno);
-        _reassembler.push_substring(
-            static_cast<string>(seg.payload().str()), payload_absolute_seqno - 1, seg.header().fin);
+        if (seg.payload().size() > 0) {
+            _last_payload_index = payload_absolute_seqno - 1;
+        }
+        _reassembler.push_substring(seg.payload(), payload_absolute_seqno - 1, seg.header().fin);
 
         absolute_ackno = _reassembler.get_assembled_index() + 1;
         if (stream_out().input_ended()) {
@@ -48,3 +60,45 @@ size_t TCPReceiver::window_size() const {
         return 0;
     }
 }
+
+size_t TCPReceiver::advertised_window() const {
+    const size_t window = window_size();
+    if (_sws_step == 0 or not isn.has_value() or window_update_due()) {
+        return window;
+    }
+    const uint64_t assembled = _reassembler.get_assembled_index();
+    return _window_edge > assembled ? min<uint64_t>(window, _window_edge - assembled) : 0;
+}
+
+void TCPReceiver::window_advertised(const size_t window) {
+    _window_edge = max(_window_edge, _reassembler.get_assembled_index() + window);
+}
+
+bool TCPReceiver::window_update_due() const {
+    return _sws_step > 0 and isn.has_value() and not stream_out().input_ended() and
+           _reassembler.acceptable_last_index() >= _window_edge + _sws_step;
+}
+
+vector<pair<WrappingInt32, WrappingInt32>> TCPReceiver::sack_blocks(const size_t max_blocks) const {
+    vector<pair<WrappingInt32, WrappingInt32>> blocks;
+    if (not isn.has_value()) {
+        return blocks;
+    }
+
+    auto ranges = _reassembler.unassembled_ranges();
+    const auto latest = find_if(ranges.begin(), ranges.end(), [&](const auto &range) {
+        return range.first <= _last_payload_index and _last_payload_index < range.second;
+    });
+    if (latest != ranges.end()) {
+        rotate(ranges.begin(), latest, latest + 1);
+    }
+
+    for (const auto &[start, end] : ranges) {
+        if (blocks.size() == max_blocks) {
+            break;
+        }
+        // stream index i is absolute seqno i + 1
+        blocks.emplace_back(wrap(start + 1, isn.value()), wrap(end + 1, isn.value()));
+    }
+    return blocks;
+}
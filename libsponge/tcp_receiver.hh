@@ -7,6 +7,8 @@
 #include "wrapping_integers.hh"
 
 #include <optional>
+#include <utility>
+#include <vector>
 
 //! \brief The "receiver" part of a TCP implementation.
 
@@ -23,13 +25,27 @@ class TCPReceiver {
     // private members
     std::optional<WrappingInt32> isn;  // ISN: Initial Sequence Number
     uint64_t absolute_ackno;           // Absolute Sequence Number for ACKNO
+    uint64_t _last_payload_index{0};   //!< stream index of the latest payload received
+    bool _ce_echo{false};              //!< a CE mark arrived, and the peer hasn't yet sent CWR
+
+    //! \name Receiver-side silly window syndrome avoidance (RFC 1122, section 4.2.3.3)
+    //!@{
+    size_t _sws_step;          //!< least distance the window's right edge is moved (0: no SWS avoidance)
+    uint64_t _window_edge{0};  //!< stream index just past the window last advertised
+    //!@}
 
   public:
     //! \brief Construct a TCP receiver
     //!
     //! \param capacity the maximum number of bytes that the receiver will
     //!                 store in its buffers at any give time.
-    TCPReceiver(const size_t capacity) : _reassembler(capacity), _capacity(capacity), isn(), absolute_ackno(0) {}
+    //! \param storage how the inbound stream holds its bytes (see ByteStream::Storage)
+    //! \param sws_step if nonzero, the advertised window's right edge is only moved right once it can
+    //!                 move by at least this many bytes, rather than as each byte is read
+    TCPReceiver(const size_t capacity,
+                const ByteStream::Storage storage = ByteStream::Storage::Ring,
+                const size_t sws_step = 0)
+        : _reassembler(capacity, storage), _capacity(capacity), isn(), absolute_ackno(0), _sws_step(sws_step) {}
 
     //! \name Accessors to provide feedback to the remote TCPSender
     //!@{
@@ -52,11 +68,37 @@ class TCPReceiver {
     //! accepted by the receiver) and (b) the sequence number of the
     //! beginning of the window (the ackno).
     size_t window_size() const;
+
+    //! \brief The window to advertise in the next segment
+    //! \details The same as window_size(), except that with SWS avoidance the window's right edge stays
+    //! where it was last advertised until it can move by at least `sws_step` bytes. The edge never
+    //! moves left, so the window shrinks only as data arrives.
+    size_t advertised_window() const;
+
+    //! \brief Record that a segment advertising `window` bytes was sent
+    void window_advertised(const size_t window);
+
+    //! \returns `true` if the window has opened far enough past the edge last advertised to be
+    //! worth a window update (only with SWS avoidance)
+    bool window_update_due() const;
+
+    //! \brief SACK blocks (RFC 2018) describing the out-of-order bytes held: the block holding
+    //! the latest segment received first, then the others in sequence order
+    //! \param max_blocks is the most blocks to return
+    std::vector<std::pair<WrappingInt32, WrappingInt32>> sack_blocks(const size_t max_blocks) const;
+
+    //! \brief Should the segments sent carry the ECE flag? (only if ECN is in use, RFC 3168)
+    //! \details From the arrival of a segment marked CE until one carrying CWR shows that the peer
+    //! has reduced its window
+    bool ce_echo() const { return _ce_echo; }
     //!@}
 
     //! \brief number of bytes stored but not yet reassembled
     size_t unassembled_bytes() const { return _reassembler.unassembled_bytes(); }
 
+    //! \brief Bytes of memory held by the reassembler and the inbound stream
+    size_t footprint() const { return _reassembler.footprint(); }
+
     //! \brief handle an inbound segment
     void segment_received(const TCPSegment &seg);
 
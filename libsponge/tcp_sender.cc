@@ -2,6 +2,8 @@
 
 #include "tcp_config.hh"
 
+#include <algorithm>
+#include <cmath>
 #include <random>
 
 // Dummy implementation of a TCP sender
@@ -17,31 +19,114 @@ using namespace std;
 //! \param[in] capacity the capacity of the outgoing byte stream
 //! \param[in] retx_timeout the initial amount of time to wait before retransmitting the oldest outstanding segment
 //! \param[in] fixed_isn the Initial Sequence Number to use, if set (otherwise uses a random ISN)
-TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const std::optional<WrappingInt32> fixed_isn)
+//! \param[in] storage how the outgoing byte stream holds its bytes
+TCPSender::TCPSender(const size_t capacity,
+                     const uint16_t retx_timeout,
+                     const std::optional<WrappingInt32> fixed_isn,
+                     const ByteStream::Storage storage)
     : _isn(fixed_isn.value_or(WrappingInt32{random_device()()}))
     , _initial_retransmission_timeout{retx_timeout}
-    , _stream(capacity)
-    , _timer(retx_timeout)
+    , _stream(capacity, storage)
+    , _timer()
     , _last_ackno(0)
     , _last_windowsize(1)
-    , _FIN_setted(false) {}
+    , _FIN_setted(false)
+    , _congestion_control(CongestionControl::make(
+          CongestionControl::Algorithm::None, TCPConfig::MAX_PAYLOAD_SIZE, TCPConfig::INITIAL_CWND))
+    , _rtt(retx_timeout, TCPConfig::RTO_MIN_DFLT, TCPConfig::RTO_MAX_DFLT) {}
+
+//! \param[in] config supplies the outgoing stream's capacity and storage, the retransmission timeout
+//! and how it adapts, the ISN, and the congestion control algorithm and its initial window
+TCPSender::TCPSender(const TCPConfig &config)
+    : TCPSender(config.send_capacity, config.rt_timeout, config.fixed_isn, config.send_storage) {
+    _algorithm = config.congestion_control;
+    _initial_cwnd = config.initial_cwnd;
+    _congestion_control = CongestionControl::make(_algorithm, TCPConfig::MAX_PAYLOAD_SIZE, _initial_cwnd);
+    _rtt = RTTEstimator{config.rt_timeout, config.rto_min, config.rto_max};
+    _adaptive_rto = config.adaptive_rto;
+    if (_adaptive_rto) {
+        _timer = RetransTimer{config.rto_max};
+    }
+    _fast_retransmit = config.fast_retransmit;
+    _limited_transmit = config.limited_transmit;
+    _pacing = config.pacing;
+    _nagle = config.nagle;
+    _persist = config.persist_timer;
+    _persist_timeout = config.persist_timeout;
+    _persist_timer = RetransTimer{config.persist_timeout_max};
+    _repacketize = config.repacketize;
+    _offload = config.segmentation_offload;
+    set_max_payload_size(TCPConfig::MAX_PAYLOAD_SIZE);
+}
+
+//! \details The congestion controller works in whole segments of the MSS, so a change of MSS builds it
+//! anew, with an initial window of as many segments as `initial_cwnd` holds of TCPConfig::MAX_PAYLOAD_SIZE.
+//! (Setting the same MSS again, as a duplicate SYN does, leaves it alone.)
+void TCPSender::set_max_payload_size(const size_t mss) {
+    if (mss != _mss) {
+        _congestion_control =
+            CongestionControl::make(_algorithm, mss, _initial_cwnd * mss / TCPConfig::MAX_PAYLOAD_SIZE);
+    }
+    _mss = mss;
+    _max_payload_size = _offload ? TCPConfig::MAX_OFFLOAD_PAYLOAD_SIZE / TCPConfig::MAX_PAYLOAD_SIZE * mss : mss;
+}
+
+//! \details The first sample sets SRTT = R and RTTVAR = R/2; later ones update RTTVAR by 1/4 of
+//! |SRTT - R| and SRTT by 1/8 of R, each divided by `expected_samples`.
+//! RTO = SRTT + max(G, 4 * RTTVAR), clamped to [rto_min, rto_max].
+void RTTEstimator::sample(const uint64_t rtt_ms, const uint64_t expected_samples) {
+    const double r = static_cast<double>(rtt_ms);
+    if (_srtt) {
+        const double beta = 0.25 / static_cast<double>(max(expected_samples, uint64_t{1}));
+        const double alpha = 0.125 / static_cast<double>(max(expected_samples, uint64_t{1}));
+        _rttvar = (1 - beta) * _rttvar + beta * abs(_srtt.value() - r);
+        _srtt = (1 - alpha) * _srtt.value() + alpha * r;
+    } else {
+        _srtt = r;
+        _rttvar = r / 2;
+    }
+    _min_rtt = min(_min_rtt.value_or(rtt_ms), rtt_ms);
+    const double rto = ceil(_srtt.value() + max(CLOCK_GRANULARITY, 4 * _rttvar));
+    _rto = static_cast<uint32_t>(min(max(rto, static_cast<double>(_rto_min)), static_cast<double>(_rto_max)));
+}
 
 uint64_t TCPSender::bytes_in_flight() const {
     // cout << "seq_no:" << _next_seqno << ", ack_no:" << abs_ackno << endl;
     return _next_seqno - _last_ackno;
 }
 
+//! \details A paced sender sends new segments only while it has pacing credit, and each one
+//! is charged against it. Retransmissions and zero-window probes are not paced.
+//!
+//! With Nagle's algorithm, a segment smaller than the MSS is held back while any data is in flight,
+//! unless it would carry the FIN.
+//!
+//! With the persist timer, a zero window with nothing in flight starts the timer, and the probes are
+//! left to it (see send_window_probe()).
+//!
+//! If the congestion window has room that there is nothing to fill, the delivery-rate samples taken
+//! until what is in flight has been delivered are marked app-limited.
 void TCPSender::fill_window() {
+    const optional<double> rate = pacing_rate();
     bool ahead = _last_ackno + _last_windowsize < _next_seqno;
     uint64_t window_left = ahead ? 0 : _last_ackno + _last_windowsize - _next_seqno;
 
+    // the congestion window bounds the sequence numbers in flight, just as the receiver's window does
+    window_left = min(window_left, congestion_window_left());
+
     // _last_windowsize == 0?
     if ((_stream.buffer_size() > 0 || (!_FIN_setted && _stream.eof())) && _last_windowsize == 0 && !ahead) {
+        if (_persist) {
+            if (!_persist_timer.is_running()) {
+                _persist_timer.init(_persist_timeout);
+            }
+            return;
+        }
         TCPSegment segment;
         // TODO: only send once here?
         segment.header().seqno = next_seqno();
         if (_stream.buffer_size() > 0) {
-            segment.payload() = Buffer(_stream.read(1));
+            segment.payload() = read_payload(1);
         } else {
             segment.header().fin = 1;
             _FIN_setted = 1;
@@ -53,6 +138,10 @@ void TCPSender::fill_window() {
 
     // continue send segment, until window=0 or output stream empty
     while (1) {
+        if (rate.has_value() && _pacing_credit <= 0) {
+            break;
+        }
+
         TCPSegment segment;
 
         // store current seqno into header, may change later
@@ -66,13 +155,27 @@ void TCPSender::fill_window() {
         }
 
         // step 2.a: calculate payload_size
-        // it should be min of buffer available, window_left, and MAX_PAYLOAD_SIZE(1452 Bytes)
+        // it should be min of buffer available, window_left, and the MSS
+        // (or a multiple of it, with segmentation offload)
         uint64_t payload_size = min(_stream.buffer_size(), window_left);
-        payload_size = min(payload_size, TCPConfig::MAX_PAYLOAD_SIZE);
+        payload_size = min(payload_size, _max_payload_size);
+
+        // Nagle: hold back a small segment while data is in flight, unless it ends the stream
+        const bool ends_stream = _stream.input_ended() && payload_size == _stream.buffer_size() &&
+                                 window_left > payload_size && !_FIN_setted;
+        if (_nagle && !segment.header().syn && payload_size > 0 && payload_size < _mss &&
+            bytes_in_flight() > 0 && !ends_stream) {
+            if (_stream.buffer_size() > _nagle_held) {
+                _nagle_coalesced += _nagle_held > 0 ? 1 : 0;
+                _nagle_held = _stream.buffer_size();
+            }
+            break;
+        }
 
         // step 2.b: read payload
         if (payload_size > 0) {
-            segment.payload() = Buffer(_stream.read(payload_size));
+            _nagle_held = 0;
+            segment.payload() = read_payload(payload_size);
             _next_seqno += payload_size;
             window_left -= payload_size;
         }
@@ -89,22 +192,77 @@ void TCPSender::fill_window() {
 
         // send segment
         if (segment.header().syn || segment.header().fin || payload_size > 0) {
+            // new data is ECN-capable (retransmissions, probes and pure acks never are), and the
+            // first after a reduction for an echoed mark tells the receiver to stop echoing it
+            if (_ecn && payload_size > 0) {
+                segment.ecn() = IPv4Header::ECT_0;
+                segment.header().cwr = _cwr_pending;
+                _cwr_pending = false;
+            }
             send_tcpsegment(segment);
+            if (rate.has_value()) {
+                _pacing_credit -= segment.length_in_sequence_space();
+            }
         } else {
             break;
         }
     }
+
+    const bool waiting = _stream.buffer_size() > 0 or (not _FIN_setted and _stream.eof());
+    if (not waiting and _next_seqno > 0 and congestion_window_left() > 0) {
+        _app_limited_until = max(_delivered + bytes_in_flight(), uint64_t{1});
+    }
 }
 
+//! \details An ack that acknowledges nothing new, carries no data and leaves the window unchanged while
+//! data is outstanding is a duplicate (RFC 5681). With fast retransmit enabled, the DUPACK_THRESHOLD'th
+//! in a row retransmits the oldest outstanding segment and reports a loss to the congestion controller;
+//! while it is then in fast recovery, each partial ack retransmits the next hole (RFC 6582), and so
+//! does each further duplicate ack if SACK blocks have shown where the holes are (RFC 6675).
+//!
+//! A new ack gives an RTT sample from the timestamp it echoes, if timestamp_echo_received() was just
+//! called, and otherwise from the newest segment it acknowledges.
+//!
+//! An ack that ecn_echo_received() was just called for reduces the congestion window (see ecn_echoed()).
 //! \param ackno The remote receiver's ackno (acknowledgment number)
-//! \param window_size The remote receiver's advertised window size
-void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_size) {
+//! \param window_size The remote receiver's advertised window size, already scaled if window scaling is in use
+//! \param carries_data whether the ack arrived on a segment that occupies sequence numbers
+void TCPSender::ack_received(const WrappingInt32 ackno, const uint64_t window_size, const bool carries_data) {
+    const optional<uint32_t> timestamp_echo = _timestamp_echo;
+    _timestamp_echo.reset();
+    const bool ecn_echo = _ecn_echo;
+    _ecn_echo = false;
+
     // check if the ackno is the newest
     uint64_t recv_ackno = unwrap(ackno, _isn, _next_seqno);
     if (recv_ackno < _last_ackno) {
         return;
     } else if (recv_ackno == _last_ackno) {
-        _last_windowsize = max(static_cast<uint64_t>(window_size), _last_windowsize);
+        // (the answer to a zero-window probe is no sign of loss)
+        const bool duplicate = bytes_in_flight() > 0 and not carries_data and window_size == _last_windowsize and
+                               not _persist_timer.is_running();
+        _last_windowsize = max(window_size, _last_windowsize);
+        if (_last_windowsize > 0) {
+            stop_persisting();
+        }
+        if (duplicate) {
+            _dupacks++;
+            AckSample sample{recv_ackno, 0, bytes_in_flight(), _time_ms};
+            sample_delivery_rate(sample);
+            _congestion_control->on_duplicate_ack(sample);
+            if (_fast_retransmit and _congestion_control->in_recovery()) {
+                // a segment has left the network, so another hole reported by SACK can be repaired (the
+                // duplicates of a partial ack are no new loss, and don't repeat its retransmission)
+                retransmit_next_hole();
+            } else if (_fast_retransmit and _dupacks == TCPConfig::DUPACK_THRESHOLD) {
+                _congestion_control->on_loss(_next_seqno, bytes_in_flight());
+                _high_rxt = _last_ackno;
+                retransmit_next_hole();
+            }
+        }
+        if (ecn_echo) {
+            ecn_echoed(recv_ackno);
+        }
         return;
     }
 
@@ -113,37 +271,118 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
         return;
     }
 
+    // the SYN's sequence number isn't payload, so it doesn't open the congestion window
+    const size_t bytes_acked = recv_ackno - max(_last_ackno, uint64_t{1});
+    const uint64_t flight_size = bytes_in_flight();
     _last_ackno = recv_ackno;
     _last_windowsize = window_size;
+    _dupacks = 0;
+    if (_last_windowsize > 0) {
+        stop_persisting();
+    }
 
     // receiver sucessful receipt of new data
-    while (!_outstanding_segments.empty()) {
-        const TCPSegment &top_segment = _outstanding_segments.front();
-        uint64_t seqno = unwrap(top_segment.header().seqno, _isn, _next_seqno);
-        if (seqno + top_segment.length_in_sequence_space() <= recv_ackno) {
-            _outstanding_segments.pop();
-        } else {
-            break;
+    // the newest segment acked gives an RTT sample, unless it was retransmitted
+    optional<uint64_t> rtt_ms{};
+    while (!_outstanding_segments.empty() && _outstanding_segments.front().end() <= recv_ackno) {
+        const OutstandingSegment &top = _outstanding_segments.front();
+        rtt_ms = top.retransmitted ? nullopt : optional<uint64_t>{_time_ms - top.sent_ms};
+        if (not top.sacked) {
+            deliver(top);
         }
+        _outstanding_segments.pop_front();
+    }
+    // a segment acknowledged in part is retransmitted whole, so its bytes are kept
+    _send_buffer.acknowledge(_outstanding_segments.empty() ? recv_ackno : _outstanding_segments.front().seqno);
+    if (timestamp_echo) {
+        // every ack is timed, so each sample is weighted by the number expected per round trip,
+        // taking an ack for every other full-sized segment
+        rtt_ms = static_cast<uint32_t>(timestamp_value() - timestamp_echo.value());
+        const uint64_t bytes_per_ack = 2 * _mss;
+        _rtt.sample(rtt_ms.value(), (flight_size + bytes_per_ack - 1) / bytes_per_ack);
+    } else if (rtt_ms) {
+        _rtt.sample(rtt_ms.value());
+    }
+    const bool was_in_recovery = _congestion_control->in_recovery();
+    AckSample sample{recv_ackno, bytes_acked, bytes_in_flight(), _time_ms, rtt_ms};
+    sample_delivery_rate(sample);
+    _congestion_control->on_ack(sample);
+    if (was_in_recovery and _congestion_control->in_recovery()) {
+        _high_rxt = max(_high_rxt, _last_ackno);
+        retransmit_next_hole();
+    }
+    if (ecn_echo) {
+        ecn_echoed(recv_ackno);
     }
 
     // set timer
     if (_outstanding_segments.empty()) {
         _timer.close();
     } else {
-        _timer.init();
+        _timer.init(retransmission_timeout());
     }
 }
 
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void TCPSender::tick(const size_t ms_since_last_tick) {
-    if (!_timer.is_running())
-        return;
+    _time_ms += ms_since_last_tick;
+    if (_timer.is_running()) {
+        _timer.consume(ms_since_last_tick);
+        if (_timer.is_alarm()) {
+            // a lost zero-window probe says nothing about congestion
+            if (_last_windowsize != 0) {
+                _congestion_control->on_rto(bytes_in_flight());
+            }
+            _dupacks = 0;
+            resend_tcpsegment();
+        }
+    }
+
+    if (_persist_timer.is_running()) {
+        _persist_timer.consume(ms_since_last_tick);
+        if (_persist_timer.is_alarm()) {
+            send_window_probe();
+            _persist_timer.restart();
+        }
+    }
+
+    // pacing credit accrues with time, up to a burst or a millisecond's worth (the clock's granularity),
+    // so that an idle sender can't save it up; what it releases is sent at once
+    const optional<double> rate = pacing_rate();
+    if (rate.has_value()) {
+        const double accrued = rate.value() * static_cast<double>(ms_since_last_tick);
+        _pacing_credit = min(_pacing_credit + accrued, max(rate.value(), static_cast<double>(TCPConfig::PACING_BURST)));
+        fill_window();
+    }
+}
+
+//! \details A congestion controller that sets its own rate (BBR) is paced at it, whether or not pacing
+//! is enabled. Otherwise the rate is the gain times the window (the smaller of cwnd and the receiver's
+//! window) per SRTT. The gain is higher while cwnd is in the lower half of slow start and is what limits
+//! the window (as in Linux), so that the rate keeps up with a window that doubles each round trip.
+optional<double> TCPSender::pacing_rate() const {
+    const optional<double> model_rate = _congestion_control->pacing_rate();
+    if (model_rate.has_value()) {
+        return model_rate;
+    }
+    const optional<double> srtt = _rtt.srtt();
+    if (not _pacing or not srtt.has_value()) {
+        return nullopt;
+    }
+    const CongestionControl &cc = *_congestion_control;
+    const uint64_t rwnd = max(_last_windowsize, uint64_t{_mss});
+    const bool growing = cc.cwnd() < cc.ssthresh() / 2 and cc.cwnd() < rwnd;
+    const double gain = growing ? TCPConfig::PACING_GAIN_SLOW_START : TCPConfig::PACING_GAIN_AVOIDANCE;
+    return gain * static_cast<double>(min(uint64_t{cc.cwnd()}, rwnd)) / max(srtt.value(), 1.0);
+}
 
-    _timer.consume(ms_since_last_tick);
-    if (_timer.is_alarm()) {
-        resend_tcpsegment();
+optional<uint64_t> TCPSender::time_until_release() const {
+    const optional<double> rate = pacing_rate();
+    const bool waiting = _stream.buffer_size() > 0 or (not _FIN_setted and _stream.eof());
+    if (not rate.has_value() or _pacing_credit > 0 or not waiting) {
+        return nullopt;
     }
+    return static_cast<uint64_t>(-_pacing_credit / rate.value()) + 1;
 }
 
 unsigned int TCPSender::consecutive_retransmissions() const { return _timer.get_retransmission_count(); }
@@ -164,14 +403,235 @@ void TCPSender::send_rst_segment() {
 // implementation private functions
 void TCPSender::send_tcpsegment(const TCPSegment &segment, bool need_back_off_rto) {
     _segments_out.push(segment);
-    _outstanding_segments.push(segment);
+    track_outstanding(segment);
     if (!_timer.is_running()) {
-        _timer.init(need_back_off_rto);
+        _timer.init(retransmission_timeout(), need_back_off_rto);
+    }
+}
+
+//! \details Slices the payload out of the outgoing stream; this only copies
+//! if the bytes straddle more than one of the stream's chunks.
+Buffer TCPSender::read_payload(const size_t len) {
+    const BufferList payload = _stream.peek_buffers(len);
+    _stream.pop_output(len);
+    if (payload.buffers().size() == 1) {
+        return payload.buffers().front();
+    }
+    return Buffer(payload.concatenate());
+}
+
+//! \brief Keep a segment just sent, as bookkeeping plus its payload, until it is acknowledged
+//! \details A segment larger than the MSS (see TCPConfig::segmentation_offload) is recorded as the
+//! segments it is cut into on the wire, so that SACK blocks and retransmissions deal in those.
+void TCPSender::track_outstanding(const TCPSegment &segment) {
+    const TCPHeader &header = segment.header();
+    const uint64_t seqno = unwrap(header.seqno, _isn, _next_seqno);
+    const size_t payload_size = segment.payload().size();
+    _send_buffer.push(segment.payload());
+    if (_outstanding_segments.empty()) {
+        // the first segment after an idle period starts the delivery-rate intervals afresh
+        _first_sent_ms = _delivered_ms = _time_ms;
     }
+
+    size_t offset = 0;
+    do {
+        const size_t len = min(_mss, payload_size - offset);
+        const bool syn = header.syn and offset == 0;
+        const bool fin = header.fin and offset + len == payload_size;
+        const uint64_t start = offset == 0 ? seqno : seqno + offset + (header.syn ? 1 : 0);
+        _outstanding_segments.push_back({start, len + (syn ? 1 : 0) + (fin ? 1 : 0), syn, fin, _time_ms});
+        stamp_delivery_state(_outstanding_segments.back());
+        offset += len;
+    } while (offset < payload_size);
 }
 
 void TCPSender::resend_tcpsegment() {
-    const TCPSegment &top_segment = _outstanding_segments.front();
-    _segments_out.push(top_segment);
+    repacketize(0);
+    retransmit(_outstanding_segments.front());
     _timer.restart();
 }
+
+//! \details The payload is sliced out of the send buffer.
+TCPSegment TCPSender::make_segment(const OutstandingSegment &outstanding) const {
+    TCPSegment segment;
+    segment.header().seqno = wrap(outstanding.seqno, _isn);
+    segment.header().syn = outstanding.syn;
+    segment.header().fin = outstanding.fin;
+    segment.payload() =
+        _send_buffer.slice(outstanding.seqno + (outstanding.syn ? 1 : 0), outstanding.payload_size());
+    return segment;
+}
+
+void TCPSender::retransmit(OutstandingSegment &outstanding) {
+    outstanding.retransmitted = true;
+    stamp_delivery_state(outstanding);
+    _segments_out.push(make_segment(outstanding));
+}
+
+//! \details With repacketizing, the outstanding segments that follow the one at `index` are merged into it
+//! while the merged payload fits in one MSS, so that a run of small segments (from small writes, say) is
+//! repaired by a single retransmission. The SYN, and segments the receiver has SACKed, are never merged.
+void TCPSender::repacketize(const size_t index) {
+    OutstandingSegment &first = _outstanding_segments.at(index);
+    if (not _repacketize or first.syn or first.fin) {
+        return;
+    }
+    size_t last = index + 1;
+    for (; last < _outstanding_segments.size(); last++) {
+        const OutstandingSegment &next = _outstanding_segments[last];
+        if (next.sacked or next.syn or first.payload_size() + next.payload_size() > _mss) {
+            break;
+        }
+        first.length += next.length;
+        first.fin = next.fin;
+    }
+    _outstanding_segments.erase(_outstanding_segments.begin() + index + 1, _outstanding_segments.begin() + last);
+}
+
+//! \details The probe is the next byte (or the FIN), sent past the closed window; while it goes
+//! unacknowledged, each probe resends it. Probes are timed by the persist timer rather than the
+//! retransmission timer, so a peer that keeps its window closed never makes the connection give up.
+void TCPSender::send_window_probe() {
+    if (not _outstanding_segments.empty()) {
+        retransmit(_outstanding_segments.front());
+        return;
+    }
+
+    TCPSegment segment;
+    segment.header().seqno = next_seqno();
+    if (_stream.buffer_size() > 0) {
+        segment.payload() = read_payload(1);
+    } else if (not _FIN_setted and _stream.eof()) {
+        segment.header().fin = true;
+        _FIN_setted = true;
+    } else {
+        return;
+    }
+    _next_seqno++;
+    _segments_out.push(segment);
+    track_outstanding(segment);
+}
+
+//! \details An unacknowledged probe is then ordinary data in flight, for the retransmission timer.
+void TCPSender::stop_persisting() {
+    if (not _persist_timer.is_running()) {
+        return;
+    }
+    _persist_timer.close();
+    if (not _outstanding_segments.empty() and not _timer.is_running()) {
+        _timer.init(retransmission_timeout());
+    }
+}
+
+//! \details Limited transmit (RFC 3042) lets one new segment out for each of the first two duplicate acks,
+//! beyond the congestion window but not beyond the receiver's.
+uint64_t TCPSender::congestion_window_left() const {
+    uint64_t cwnd = _congestion_control->cwnd();
+    if (_limited_transmit and not _congestion_control->in_recovery()) {
+        const uint64_t extra = min(_dupacks, 2u) * _mss;
+        cwnd = cwnd > numeric_limits<uint64_t>::max() - extra ? numeric_limits<uint64_t>::max() : cwnd + extra;
+    }
+    return cwnd > bytes_in_flight() ? cwnd - bytes_in_flight() : 0;
+}
+
+//! \details Marks the outstanding segments that lie wholly within a block. Blocks that don't lie
+//! between the last ackno and the next seqno are ignored.
+void TCPSender::sack_received(const vector<pair<WrappingInt32, WrappingInt32>> &blocks) {
+    for (const auto &[left_edge, right_edge] : blocks) {
+        const uint64_t left = unwrap(left_edge, _isn, _next_seqno);
+        const uint64_t right = unwrap(right_edge, _isn, _next_seqno);
+        if (left >= right or left < _last_ackno or right > _next_seqno) {
+            continue;
+        }
+        _highest_sacked = max(_highest_sacked, right);
+
+        // the outstanding segments are in sequence order
+        auto it = partition_point(_outstanding_segments.begin(),
+                                  _outstanding_segments.end(),
+                                  [&](const auto &o) { return o.seqno < left; });
+        for (; it != _outstanding_segments.end() and it->end() <= right; ++it) {
+            if (not it->sacked) {
+                it->sacked = true;
+                deliver(*it);
+            }
+        }
+    }
+}
+
+//! \details A hole is the first outstanding segment, or any segment below the highest SACKed
+//! sequence number, that hasn't been SACKed and hasn't been retransmitted in this recovery.
+//! \returns `true` if a hole was found and retransmitted
+bool TCPSender::retransmit_next_hole() {
+    for (size_t i = 0; i < _outstanding_segments.size(); i++) {
+        const OutstandingSegment &outstanding = _outstanding_segments[i];
+        if (i > 0 and outstanding.seqno >= _highest_sacked) {
+            break;
+        }
+        if (outstanding.sacked or outstanding.end() <= _high_rxt) {
+            continue;
+        }
+        repacketize(i);
+        retransmit(_outstanding_segments[i]);
+        _high_rxt = _outstanding_segments[i].end();
+        return true;
+    }
+    return false;
+}
+
+void TCPSender::stamp_delivery_state(OutstandingSegment &outstanding) {
+    outstanding.last_sent_ms = _time_ms;
+    outstanding.delivered = _delivered;
+    outstanding.delivered_ms = _delivered_ms;
+    outstanding.first_sent_ms = _first_sent_ms;
+    outstanding.app_limited = _app_limited_until != 0;
+}
+
+//! \details Of the segments one ack delivers, the sample is taken from the one sent last.
+void TCPSender::deliver(const OutstandingSegment &outstanding) {
+    _delivered += outstanding.length;
+    _delivered_ms = _time_ms;
+    if (not _newest_delivered.has_value() or outstanding.delivered > _newest_delivered->delivered or
+        (outstanding.delivered == _newest_delivered->delivered and
+         outstanding.last_sent_ms >= _newest_delivered->last_sent_ms)) {
+        _newest_delivered = outstanding;
+        _first_sent_ms = outstanding.last_sent_ms;
+    }
+}
+
+//! \details The rate is what was delivered while the segment was in flight, over the longer of the
+//! time it took to send that much and the time it took to be acknowledged (draft-cheng-iccrg-delivery-
+//! rate-estimation). An interval shorter than the minimum RTT comes from acks bunched up on the way
+//! back, and would overstate the rate, so it gives no sample.
+void TCPSender::sample_delivery_rate(AckSample &ack) {
+    if (_app_limited_until != 0 and _delivered > _app_limited_until) {
+        _app_limited_until = 0;
+    }
+    ack.delivered = _delivered;
+    if (not _newest_delivered.has_value()) {
+        return;
+    }
+    const OutstandingSegment newest = _newest_delivered.value();
+    _newest_delivered.reset();
+
+    ack.prior_delivered = newest.delivered;
+    ack.app_limited = newest.app_limited;
+    const uint64_t send_elapsed = newest.last_sent_ms - newest.first_sent_ms;
+    const uint64_t ack_elapsed = _delivered_ms - newest.delivered_ms;
+    const uint64_t interval = max(send_elapsed, ack_elapsed);
+    if (interval == 0 or interval < _rtt.min_rtt().value_or(0)) {
+        return;
+    }
+    ack.delivery_rate = static_cast<double>(_delivered - newest.delivered) / static_cast<double>(interval);
+}
+
+//! \details The window is reduced at most once per window of data: not again until an ack passes the
+//! sequence numbers sent before the last reduction, and not during loss recovery, which has reduced it
+//! already (RFC 3168, section 6.1.2). Nothing is retransmitted.
+void TCPSender::ecn_echoed(const uint64_t ackno) {
+    if (not _ecn or ackno <= _cwr_point or _congestion_control->in_recovery()) {
+        return;
+    }
+    _congestion_control->on_ecn(bytes_in_flight());
+    _cwr_point = _next_seqno;
+    _cwr_pending = true;
+}
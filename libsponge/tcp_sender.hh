@@ -2,16 +2,24 @@
 #define SPONGE_LIBSPONGE_TCP_SENDER_HH
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
+#include "send_buffer.hh"
 #include "tcp_config.hh"
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
 
+#include <deque>
 #include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <queue>
+#include <utility>
+#include <vector>
 
 class RetransTimer {
   private:
-    const uint32_t _initial_retransmission_timout;
+    uint32_t _max_timeout;      // backoff stops here
     uint32_t _retrans_timeout;  // RTO
     uint32_t _retrans_count;    // count of "consecutive retransmissions"
 
@@ -20,16 +28,16 @@ class RetransTimer {
     bool _need_back_off_rto;
 
   public:
-    RetransTimer(const uint32_t initial_timeout)
-        : _initial_retransmission_timout(initial_timeout)
+    RetransTimer(const uint32_t max_timeout = std::numeric_limits<uint32_t>::max())
+        : _max_timeout(max_timeout)
         , _retrans_timeout(0)
         , _retrans_count(0)
         , _running(false)
         , _time_left(0)
         , _need_back_off_rto(true) {}
 
-    void init(bool need_back_off_rto = true) {
-        _retrans_timeout = _initial_retransmission_timout;
+    void init(const uint32_t timeout, bool need_back_off_rto = true) {
+        _retrans_timeout = timeout;
         _retrans_count = 0;
         _running = true;
         _time_left = _retrans_timeout;
@@ -46,7 +54,7 @@ class RetransTimer {
         if (_running) {
             _retrans_count++;
             if (_need_back_off_rto)
-                _retrans_timeout *= 2;
+                _retrans_timeout = _retrans_timeout > _max_timeout / 2 ? _max_timeout : _retrans_timeout * 2;
             _time_left = _retrans_timeout;
         }
     }
@@ -58,6 +66,44 @@ class RetransTimer {
     uint32_t get_retransmission_count() const { return _retrans_count; }
 };
 
+//! \brief Smoothed round-trip time and the retransmission timeout derived from it (RFC 6298)
+class RTTEstimator {
+  private:
+    static constexpr double CLOCK_GRANULARITY = 1;  //!< the sender's clock ticks in milliseconds
+
+    uint32_t _rto_min;
+    uint32_t _rto_max;
+    uint32_t _rto;
+    std::optional<double> _srtt{};
+    double _rttvar{0};
+    std::optional<uint64_t> _min_rtt{};
+
+  public:
+    //! \param[in] initial_rto is the timeout until the first sample
+    //! \param[in] rto_min and rto_max bound the timeouts computed from samples
+    RTTEstimator(const uint32_t initial_rto, const uint32_t rto_min, const uint32_t rto_max)
+        : _rto_min(rto_min), _rto_max(rto_max), _rto(initial_rto) {}
+
+    //! \brief Update the estimates with a round-trip time measured from an acknowledged segment
+    //! \note Only segments that were sent once may be measured (Karn's algorithm), unless the sample
+    //! comes from an echoed timestamp.
+    //! \param[in] expected_samples is how many samples are expected per round trip; each one then
+    //! carries that much less weight (RFC 7323, Appendix G)
+    void sample(const uint64_t rtt_ms, const uint64_t expected_samples = 1);
+
+    //! \returns the smoothed round-trip time in milliseconds, once there has been a sample
+    std::optional<double> srtt() const { return _srtt; }
+
+    //! \returns the round-trip time variation in milliseconds
+    double rttvar() const { return _rttvar; }
+
+    //! \returns the least round-trip time sampled, in milliseconds
+    std::optional<uint64_t> min_rtt() const { return _min_rtt; }
+
+    //! \returns the retransmission timeout in milliseconds, before any backoff
+    uint32_t rto() const { return _rto; }
+};
+
 //! \brief The "sender" part of a TCP implementation.
 
 //! Accepts a ByteStream, divides it up into segments and sends the
@@ -81,22 +127,133 @@ class TCPSender {
     //! the (absolute) sequence number for the next byte to be sent
     uint64_t _next_seqno{0};
 
+    //! a segment sent but not yet acknowledged; its payload is kept in `_send_buffer`
+    struct OutstandingSegment {
+        uint64_t seqno;             //!< absolute seqno
+        size_t length;              //!< length in sequence space, counting SYN and FIN
+        bool syn;
+        bool fin;
+        uint64_t sent_ms;           //!< when it was first sent
+        bool retransmitted{false};  //!< an ack for it can't be timed, since it may be for any copy (Karn)
+        bool sacked{false};         //!< the receiver holds it out of order (reported by a SACK block)
+
+        //! \name The sender's delivery state when it was last sent, for delivery-rate samples
+        //!@{
+        uint64_t last_sent_ms{0};
+        uint64_t delivered{0};
+        uint64_t delivered_ms{0};
+        uint64_t first_sent_ms{0};
+        bool app_limited{false};
+        //!@}
+
+        uint64_t end() const { return seqno + length; }
+        size_t payload_size() const { return length - (syn ? 1 : 0) - (fin ? 1 : 0); }
+    };
+
     // my private variables
     RetransTimer _timer;
-    std::queue<TCPSegment> _outstanding_segments{};
+    std::deque<OutstandingSegment> _outstanding_segments{};
+    SendBuffer _send_buffer{};  //!< payload bytes sent and not yet acknowledged
+    bool _repacketize{false};
+
+    //! the MSS: the most payload a segment on the wire carries, beside the options every segment has
+    size_t _mss{TCPConfig::MAX_PAYLOAD_SIZE};
+    bool _offload{false};  //!< see TCPConfig::segmentation_offload
+    //! the largest payload put in a segment: the MSS, or a multiple of it with segmentation offload
+    size_t _max_payload_size{TCPConfig::MAX_PAYLOAD_SIZE};
     uint64_t _last_ackno;
     uint64_t _last_windowsize;
     bool _FIN_setted;
 
+    //! limits the sequence numbers in flight, along with the receiver's window
+    std::unique_ptr<CongestionControl> _congestion_control;
+    CongestionControl::Algorithm _algorithm{CongestionControl::Algorithm::None};
+    size_t _initial_cwnd{TCPConfig::INITIAL_CWND};  //!< in bytes, for segments of TCPConfig::MAX_PAYLOAD_SIZE
+
+    //! milliseconds passed to tick() so far
+    uint64_t _time_ms{0};
+
+    //! round-trip time estimates, from which the timeout is set if `_adaptive_rto` is true
+    RTTEstimator _rtt;
+    bool _adaptive_rto{false};
+
+    //! duplicate acks received since the last new ack
+    unsigned _dupacks{0};
+    bool _fast_retransmit{false};
+    bool _limited_transmit{false};
+
+    //! \name SACK scoreboard
+    //!@{
+    uint64_t _highest_sacked{0};  //!< end of the highest range the receiver has reported holding
+    uint64_t _high_rxt{0};        //!< end of the latest retransmission in the current loss recovery
+    //!@}
+
+    //! the timestamp echoed by the ack being received, if timestamps are in use
+    std::optional<uint32_t> _timestamp_echo{};
+
+    //! \name ECN (RFC 3168)
+    //!@{
+    bool _ecn{false};
+    bool _ecn_echo{false};     //!< the ack being received carries ECE
+    uint64_t _cwr_point{0};    //!< the next seqno when the window was last reduced for an echo
+    bool _cwr_pending{false};  //!< the next segment of new data carries CWR
+    //!@}
+
+    //! \name Nagle's algorithm
+    //!@{
+    bool _nagle{false};
+    size_t _nagle_held{0};          //!< bytes held back, waiting for a full segment or for in-flight data to be acked
+    uint64_t _nagle_coalesced{0};  //!< writes merged into held-back bytes
+    //!@}
+
+    //! \name Persist timer
+    //!@{
+    bool _persist{false};
+    uint32_t _persist_timeout{TCPConfig::PERSIST_TIMEOUT_DFLT};
+    RetransTimer _persist_timer{TCPConfig::PERSIST_TIMEOUT_MAX_DFLT};  //!< runs while the peer's window is zero
+    //!@}
+
+    //! \name Pacing
+    //!@{
+    bool _pacing{false};
+    double _pacing_credit{TCPConfig::PACING_BURST};  //!< bytes that may be released now; negative when in debt
+    //!@}
+
+    //! \name Delivery-rate estimation
+    //!@{
+    uint64_t _delivered{0};          //!< sequence numbers delivered so far: acknowledged, or SACKed
+    uint64_t _delivered_ms{0};       //!< when `_delivered` last grew
+    uint64_t _first_sent_ms{0};      //!< when the segment behind the latest sample was sent
+    uint64_t _app_limited_until{0};  //!< while not zero, samples are app-limited until `_delivered` passes it
+    std::optional<OutstandingSegment> _newest_delivered{};  //!< the latest sent of those the ack just delivered
+    //!@}
+
     // my private functions
     void send_tcpsegment(const TCPSegment &segment, bool need_back_off_rto = true);
+    void track_outstanding(const TCPSegment &segment);
     void resend_tcpsegment();
+    TCPSegment make_segment(const OutstandingSegment &outstanding) const;
+    void retransmit(OutstandingSegment &outstanding);
+    void repacketize(const size_t index);
+    Buffer read_payload(const size_t len);
+    uint64_t congestion_window_left() const;
+    bool retransmit_next_hole();
+    void send_window_probe();
+    void stop_persisting();
+    void stamp_delivery_state(OutstandingSegment &outstanding);
+    void deliver(const OutstandingSegment &outstanding);
+    void sample_delivery_rate(AckSample &ack);
+    void ecn_echoed(const uint64_t ackno);
 
   public:
     //! Initialize a TCPSender
     TCPSender(const size_t capacity = TCPConfig::DEFAULT_CAPACITY,
               const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT,
-              const std::optional<WrappingInt32> fixed_isn = {});
+              const std::optional<WrappingInt32> fixed_isn = {},
+              const ByteStream::Storage storage = ByteStream::Storage::Ring);
+
+    //! Initialize a TCPSender from the sender's half of a TCPConfig
+    explicit TCPSender(const TCPConfig &config);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -108,7 +265,20 @@ class TCPSender {
     //!@{
 
     //! \brief A new acknowledgment was received
-    void ack_received(const WrappingInt32 ackno, const uint16_t window_size);
+    //! \param carries_data is `true` if the ack came on a segment that occupies sequence numbers,
+    //! which makes it no duplicate even if it acknowledges nothing new
+    void ack_received(const WrappingInt32 ackno, const uint64_t window_size, const bool carries_data = false);
+
+    //! \brief SACK blocks arrived, to be applied before the ack that carried them
+    void sack_received(const std::vector<std::pair<WrappingInt32, WrappingInt32>> &blocks);
+
+    //! \brief An echoed timestamp arrived, to be applied to the ack that carried it
+    //! \details The ack then gives an RTT sample even if it acknowledges retransmitted data (RFC 7323).
+    void timestamp_echo_received(const uint32_t tsecr) { _timestamp_echo = tsecr; }
+
+    //! \brief An ECE flag arrived, to be applied to the ack that carried it
+    //! \details The congestion window is then reduced, unless it already has been for this window of data.
+    void ecn_echo_received() { _ecn_echo = true; }
 
     //! \brief Generate an empty-payload segment (useful for creating empty ACK segments)
     void send_empty_segment();
@@ -133,6 +303,55 @@ class TCPSender {
     //! \brief Number of consecutive retransmissions that have occurred in a row
     unsigned int consecutive_retransmissions() const;
 
+    //! \brief The timeout the retransmission timer starts from, before any backoff, in milliseconds
+    uint32_t retransmission_timeout() const { return _adaptive_rto ? _rtt.rto() : _initial_retransmission_timeout; }
+
+    //! \brief The TSval for a segment sent now: the sender's clock, in milliseconds
+    uint32_t timestamp_value() const { return static_cast<uint32_t>(_time_ms); }
+
+    //! \brief Set the MSS, once the options every segment will carry (such as timestamps) are known
+    //! \note Rebuilds the congestion controller for the new MSS, so call it before any data is sent.
+    void set_max_payload_size(const size_t mss);
+
+    //! \brief The MSS: the most payload a segment on the wire carries
+    size_t max_payload_size() const { return _mss; }
+
+    //! \brief Enable or disable Nagle's algorithm (disabling it is the equivalent of TCP_NODELAY)
+    void set_nagle(const bool nagle) { _nagle = nagle; }
+
+    //! \brief Enable ECN, once both sides have agreed to it: new data is then sent ECN-capable, and
+    //! echoed congestion marks are acted on
+    void set_ecn(const bool ecn) { _ecn = ecn; }
+
+    //! \brief Number of writes that Nagle's algorithm merged into a segment with earlier bytes,
+    //! rather than sending them in a small segment of their own
+    uint64_t nagle_coalesced() const { return _nagle_coalesced; }
+
+    //! \brief The rate at which segments are released, in bytes per millisecond
+    //! \returns nothing unless the congestion controller sets a rate, or pacing is enabled and there has
+    //! been an RTT sample
+    std::optional<double> pacing_rate() const;
+
+    //! \brief How long until pacing releases the next segment, in milliseconds
+    //! \returns nothing unless there is something to send that is waiting for the pacing rate
+    std::optional<uint64_t> time_until_release() const;
+
+    //! \brief Is the retransmission timer or the persist timer running?
+    bool timers_running() const { return _timer.is_running() or _persist_timer.is_running(); }
+
+    //! \brief Number of zero-window probes sent since the persist timer last started
+    unsigned int window_probes() const { return _persist_timer.get_retransmission_count(); }
+
+    //! \brief Round-trip time estimates, kept whether or not they set the retransmission timeout
+    const RTTEstimator &rtt_estimator() const { return _rtt; }
+
+    //! \brief Bytes of memory held by the outbound stream and by segments awaiting acknowledgment
+    //! \note A chunk of a Chunked stream that is still partly unread counts in both.
+    size_t footprint() const { return _stream.footprint() + _send_buffer.footprint(); }
+
+    //! \brief The congestion controller, for its window and threshold
+    const CongestionControl &congestion_control() const { return *_congestion_control; }
+
     //! \brief TCPSegments that the TCPSender has enqueued for transmission.
     //! \note These must be dequeued and sent by the TCPConnection,
     //! which will need to fill in the fields that are set by the TCPReceiver
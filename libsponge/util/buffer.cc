@@ -7,7 +7,17 @@ void Buffer::remove_prefix(const size_t n) {
         throw out_of_range("Buffer::remove_prefix");
     }
     _starting_offset += n;
-    if (_storage and _starting_offset == _storage->size()) {
+    if (_storage and _starting_offset + _removed_suffix == _storage->size()) {
+        _storage.reset();
+    }
+}
+
+void Buffer::remove_suffix(const size_t n) {
+    if (n > str().size()) {
+        throw out_of_range("Buffer::remove_suffix");
+    }
+    _removed_suffix += n;
+    if (_storage and _starting_offset + _removed_suffix == _storage->size()) {
         _storage.reset();
     }
 }
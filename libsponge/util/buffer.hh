@@ -15,6 +15,7 @@ class Buffer {
   private:
     std::shared_ptr<std::string> _storage{};
     size_t _starting_offset{};
+    size_t _removed_suffix{};  //!< number of bytes discarded from the end of `_storage`
 
   public:
     Buffer() = default;
@@ -28,7 +29,7 @@ class Buffer {
         if (not _storage) {
             return {};
         }
-        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset};
+        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset - _removed_suffix};
     }
 
     operator std::string_view() const { return str(); }
@@ -40,12 +41,25 @@ class Buffer {
     //! \brief Size of the string
     size_t size() const { return str().size(); }
 
+    //! \brief Bytes allocated for the underlying string, which every copy and slice of this Buffer shares
+    size_t storage_size() const { return _storage ? _storage->capacity() : 0; }
+
+    //! \brief Is this Buffer a copy or slice of the same underlying string as `other`?
+    bool shares_storage(const Buffer &other) const { return _storage == other._storage; }
+
+    //! \brief Identifies the underlying string: equal for Buffers that share it (see shares_storage)
+    const void *storage_id() const { return _storage.get(); }
+
     //! \brief Make a copy to a new std::string
     std::string copy() const { return std::string(str()); }
 
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
     void remove_prefix(const size_t n);
+
+    //! \brief Discard the last `n` bytes of the string (does not require a copy or move)
+    //! \note Together with remove_prefix(), this allows slicing a Buffer without copying its contents.
+    void remove_suffix(const size_t n);
 };
 
 //! \brief A reference-counted discontiguous string that can discard bytes from the front
@@ -112,6 +126,9 @@ class BufferViewList {
 
     //! \brief Construct from a std::string_view
     BufferViewList(std::string_view str) { _views.push_back({const_cast<char *>(str.data()), str.size()}); }
+
+    //! \brief Construct from a sequence of std::string_views
+    BufferViewList(std::deque<std::string_view> views) : _views(std::move(views)) {}
     //!@}
 
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
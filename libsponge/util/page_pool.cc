@@ -0,0 +1,30 @@
+#include "page_pool.hh"
+
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+static vector<PagePool::Page> &free_list() {
+    thread_local vector<PagePool::Page> pages{};
+    return pages;
+}
+
+PagePool::Page PagePool::acquire() {
+    auto &pages = free_list();
+    if (pages.empty()) {
+        return Page{new char[PAGE_SIZE]};
+    }
+    Page page = move(pages.back());
+    pages.pop_back();
+    return page;
+}
+
+void PagePool::release(Page page) {
+    auto &pages = free_list();
+    if (page and pages.size() < MAX_FREE_PAGES) {
+        pages.push_back(move(page));
+    }
+}
+
+size_t PagePool::free_pages() { return free_list().size(); }
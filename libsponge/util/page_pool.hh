@@ -0,0 +1,32 @@
+#ifndef SPONGE_LIBSPONGE_PAGE_POOL_HH
+#define SPONGE_LIBSPONGE_PAGE_POOL_HH
+
+#include <cstddef>
+#include <memory>
+
+//! \brief A per-thread free list of fixed-size pages
+//! \details Storage that grows and shrinks with its contents (PagedStorage, and the StreamReassembler's
+//! staging area) takes its memory a page at a time from the pool and gives each page back as soon as
+//! it is empty. Up to MAX_FREE_PAGES pages are kept for reuse; beyond that they are freed.
+//!
+//! Each thread has its own pool, so no locking is needed. A page may be released on a different
+//! thread than it was acquired on.
+class PagePool {
+  public:
+    static constexpr size_t PAGE_SIZE = 4096;       //!< Size of each page, in bytes
+    static constexpr size_t MAX_FREE_PAGES = 1024;  //!< Most pages kept for reuse by each thread
+
+    //! A page of PAGE_SIZE bytes (the contents of a freshly acquired page are unspecified)
+    using Page = std::unique_ptr<char[]>;
+
+    //! Take a page from this thread's pool, or allocate one if the pool is empty
+    static Page acquire();
+
+    //! Return a page to this thread's pool (or free it, if the pool is full)
+    static void release(Page page);
+
+    //! \returns the number of pages held for reuse by this thread's pool
+    static size_t free_pages();
+};
+
+#endif  // SPONGE_LIBSPONGE_PAGE_POOL_HH
@@ -0,0 +1,315 @@
+#include "stream_storage.hh"
+
+#include "file_descriptor.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace std;
+
+string_view StreamStorage::peek_view(const size_t len) const {
+    const auto spans = peek_spans(len).as_iovecs();
+    if (spans.empty()) {
+        return {};
+    }
+    return {static_cast<const char *>(spans.front().iov_base), spans.front().iov_len};
+}
+
+void StreamStorage::stage(const size_t, string_view) {
+    throw runtime_error("StreamStorage::stage: storage can't stage bytes in place");
+}
+
+void RingStorage::append(string_view data) {
+    size_t copied = 0;
+    for (const auto &span : writable_spans(data.size())) {
+        copied += data.copy(static_cast<char *>(span.iov_base), span.iov_len, copied);
+    }
+    commit(copied);
+}
+
+string RingStorage::peek(const size_t len) const {
+    string r;
+    r.reserve(len);
+    for (const auto &span : peek_spans(len).as_iovecs()) {
+        r.append(static_cast<const char *>(span.iov_base), span.iov_len);
+    }
+    return r;
+}
+
+//! \returns at most two spans: from `head` up to the end of the ring, then from the start of the ring
+BufferViewList RingStorage::peek_spans(const size_t len) const {
+    const size_t total = min(len, size());
+    const size_t first = min(total, buf_len - head);
+    deque<string_view> views{{buffer.data() + head, first}};
+    if (total > first) {
+        views.emplace_back(buffer.data(), total - first);
+    }
+    return views;
+}
+
+void RingStorage::pop(const size_t len) { head = (head + len) % buf_len; }
+
+void RingStorage::stage(const size_t offset, string_view data) {
+    const size_t start = (tail + offset) % buf_len;
+    const size_t first = min(data.size(), buf_len - start);
+    data.copy(buffer.data() + start, first);
+    data.copy(buffer.data(), data.size() - first, first);
+}
+
+//! \returns at most two spans: from `tail` up to the end of the ring, then from the start of the ring
+//! \note One slot before `head` is always left free, so that a full ring can be told apart from an empty one.
+vector<iovec> RingStorage::writable_spans(const size_t len) {
+    const size_t total = min(len, buf_len - 1 - size());
+    const size_t first = min(total, buf_len - tail);
+    vector<iovec> spans{{buffer.data() + tail, first}};
+    if (total > first) {
+        spans.push_back({buffer.data(), total - first});
+    }
+    return spans;
+}
+
+void ChunkedStorage::append(string_view data) {
+    if (not data.empty()) {
+        append(Buffer{string(data)});
+    }
+}
+
+void ChunkedStorage::append(Buffer data) {
+    if (data.size() == 0) {
+        return;
+    }
+    _size += data.size();
+    _chunks.push_back(move(data));
+}
+
+string ChunkedStorage::peek(const size_t len) const {
+    string r;
+    r.reserve(len);
+    for (auto it = _chunks.begin(); it != _chunks.end() and r.size() < len; ++it) {
+        r.append(it->str().substr(0, len - r.size()));
+    }
+    return r;
+}
+
+BufferList ChunkedStorage::peek_buffers(const size_t len) const {
+    BufferList r;
+    size_t left = len;
+    for (auto it = _chunks.begin(); it != _chunks.end() and left > 0; ++it) {
+        Buffer slice = *it;
+        if (slice.size() > left) {
+            slice.remove_suffix(slice.size() - left);
+        }
+        left -= slice.size();
+        r.append(slice);
+    }
+    return r;
+}
+
+BufferViewList ChunkedStorage::peek_spans(const size_t len) const {
+    deque<string_view> views;
+    size_t left = len;
+    for (auto it = _chunks.begin(); it != _chunks.end() and left > 0; ++it) {
+        views.push_back(it->str().substr(0, left));
+        left -= views.back().size();
+    }
+    return views;
+}
+
+void ChunkedStorage::pop(const size_t len) {
+    size_t left = min(len, _size);
+    _size -= left;
+    while (left > 0) {
+        Buffer &front = _chunks.front();
+        if (left < front.size()) {
+            front.remove_prefix(left);
+            left = 0;
+        } else {
+            left -= front.size();
+            _chunks.pop_front();
+        }
+    }
+}
+
+vector<iovec> ChunkedStorage::writable_spans(const size_t len) {
+    _staging.resize(len);
+    return {{_staging.data(), _staging.size()}};
+}
+
+//! \details A chunk less than half the size of the staging string is copied out of it, so that the chunk
+//! doesn't pin the whole staging allocation (which is as large as the stream's free space) while it waits
+//! to be read.
+void ChunkedStorage::commit(const size_t len) {
+    if (len < _staging.size() / 2) {
+        append(string_view{_staging}.substr(0, len));
+        return;
+    }
+    _staging.resize(len);
+    append(Buffer{move(_staging)});
+    _staging = {};
+}
+
+//! \details Consecutive chunks sliced from the same Buffer are counted once.
+size_t ChunkedStorage::footprint() const {
+    size_t total = _staging.capacity();
+    for (auto it = _chunks.begin(); it != _chunks.end(); ++it) {
+        if (it == _chunks.begin() or not it->shares_storage(*prev(it))) {
+            total += it->storage_size();
+        }
+    }
+    return total;
+}
+
+//! \details The whole ring is first reserved as one inaccessible mapping of twice its size, so that
+//! the two file mappings can be placed over it, back to back, without racing other mappings.
+MirroredStorage::MirroredStorage(const size_t capacity) : _map_len(0), _base(nullptr) {
+    const size_t page_size = SystemCall("sysconf", sysconf(_SC_PAGESIZE));
+    _map_len = max(size_t{1}, (capacity + page_size - 1) / page_size) * page_size;
+
+    FileDescriptor ring{SystemCall("memfd_create", memfd_create("ByteStream", MFD_CLOEXEC))};
+    SystemCall("ftruncate", ftruncate(ring.fd_num(), _map_len));
+
+    void *const reserved = mmap(nullptr, 2 * _map_len, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reserved == MAP_FAILED) {
+        throw unix_error("mmap");
+    }
+    _base = static_cast<char *>(reserved);
+
+    for (char *const half : {_base, _base + _map_len}) {
+        if (mmap(half, _map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, ring.fd_num(), 0) == MAP_FAILED) {
+            const int mmap_errno = errno;
+            munmap(_base, 2 * _map_len);
+            throw unix_error("mmap", mmap_errno);
+        }
+    }
+    // the mappings keep the memfd's pages alive once `ring` is closed
+}
+
+MirroredStorage::~MirroredStorage() { munmap(_base, 2 * _map_len); }
+
+void MirroredStorage::append(string_view data) {
+    const size_t copied = data.copy(_base + _head + _size, _map_len - _size);
+    commit(copied);
+}
+
+void MirroredStorage::stage(const size_t offset, string_view data) {
+    data.copy(_base + _head + _size + offset, data.size());
+}
+
+string_view MirroredStorage::peek_view(const size_t len) const { return {_base + _head, min(len, _size)}; }
+
+void MirroredStorage::pop(const size_t len) {
+    const size_t popped = min(len, _size);
+    _size -= popped;
+    _head += popped;
+    if (_head >= _map_len) {
+        _head -= _map_len;
+    }
+}
+
+vector<iovec> MirroredStorage::writable_spans(const size_t len) {
+    return {{_base + _head + _size, min(len, _map_len - _size)}};
+}
+
+PagedStorage::~PagedStorage() {
+    for (auto &page : _pages) {
+        PagePool::release(move(page));
+    }
+}
+
+void PagedStorage::append(string_view data) {
+    size_t copied = 0;
+    for (const auto &span : writable_spans(data.size())) {
+        copied += data.copy(static_cast<char *>(span.iov_base), span.iov_len, copied);
+    }
+    commit(copied);
+}
+
+string PagedStorage::peek(const size_t len) const {
+    string r;
+    r.reserve(len);
+    for (const auto &span : peek_spans(len).as_iovecs()) {
+        r.append(static_cast<const char *>(span.iov_base), span.iov_len);
+    }
+    return r;
+}
+
+//! \returns one span per page
+BufferViewList PagedStorage::peek_spans(const size_t len) const {
+    deque<string_view> views;
+    size_t left = min(len, _size);
+    size_t offset = _head;
+    for (auto it = _pages.begin(); it != _pages.end() and left > 0; ++it) {
+        views.emplace_back(it->get() + offset, min(left, PagePool::PAGE_SIZE - offset));
+        left -= views.back().size();
+        offset = 0;
+    }
+    return views;
+}
+
+void PagedStorage::pop(const size_t len) {
+    const size_t popped = min(len, _size);
+    _size -= popped;
+    _head += popped;
+    while (_head >= PagePool::PAGE_SIZE) {
+        PagePool::release(move(_pages.front()));
+        _pages.pop_front();
+        _head -= PagePool::PAGE_SIZE;
+    }
+    if (_size == 0 and _staged == 0) {
+        _head = 0;
+        release_unused_pages();
+    }
+}
+
+//! \returns one span per page, across at most MAX_WRITABLE_PAGES pages, taking pages from the pool as needed
+//! \note Pages that are not filled are returned to the pool by the next commit().
+vector<iovec> PagedStorage::writable_spans(const size_t len) {
+    const size_t tail = _head + _size;
+    const size_t limit = MAX_WRITABLE_PAGES * PagePool::PAGE_SIZE - tail % PagePool::PAGE_SIZE;
+    return spans_past_end(min(len, limit));
+}
+
+vector<iovec> PagedStorage::spans_past_end(const size_t len) {
+    const size_t tail = _head + _size;
+    while (_pages.size() * PagePool::PAGE_SIZE < tail + len) {
+        _pages.push_back(PagePool::acquire());
+    }
+
+    vector<iovec> spans;
+    size_t left = len;
+    for (size_t page = tail / PagePool::PAGE_SIZE, offset = tail % PagePool::PAGE_SIZE; left > 0; ++page, offset = 0) {
+        spans.push_back({_pages.at(page).get() + offset, min(left, PagePool::PAGE_SIZE - offset)});
+        left -= spans.back().iov_len;
+    }
+    return spans;
+}
+
+void PagedStorage::commit(const size_t len) {
+    _size += len;
+    _staged = _staged > len ? _staged - len : 0;
+    release_unused_pages();
+}
+
+//! \details Takes pages from the pool as needed, and keeps them until the staged bytes are committed
+void PagedStorage::stage(const size_t offset, string_view data) {
+    size_t skipped = 0, copied = 0;
+    for (const auto &span : spans_past_end(offset + data.size())) {
+        const size_t skip = min(span.iov_len, offset - skipped);  // bytes of this span before `offset`
+        skipped += skip;
+        copied += data.copy(static_cast<char *>(span.iov_base) + skip, span.iov_len - skip, copied);
+    }
+    _staged = max(_staged, offset + data.size());
+    release_unused_pages();
+}
+
+void PagedStorage::release_unused_pages() {
+    const size_t pages_in_use = (_head + _size + _staged + PagePool::PAGE_SIZE - 1) / PagePool::PAGE_SIZE;
+    while (_pages.size() > pages_in_use) {
+        PagePool::release(move(_pages.back()));
+        _pages.pop_back();
+    }
+}
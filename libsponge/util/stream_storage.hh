@@ -0,0 +1,202 @@
+#ifndef SPONGE_LIBSPONGE_STREAM_STORAGE_HH
+#define SPONGE_LIBSPONGE_STREAM_STORAGE_HH
+
+#include "buffer.hh"
+#include "page_pool.hh"
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <sys/uio.h>
+#include <vector>
+
+//! \brief Backing store for the bytes held by a ByteStream
+//! \details A StreamStorage is a FIFO of bytes. It does no flow control of its own:
+//! the owning ByteStream never appends more than its remaining capacity, and never
+//! peeks or pops more than size() bytes.
+class StreamStorage {
+  public:
+    //! \brief Copy bytes onto the end of the store
+    virtual void append(std::string_view data) = 0;
+
+    //! \brief Append a Buffer onto the end of the store
+    //! \note The default copies; storages that can hold Buffers adopt them instead.
+    virtual void append(Buffer data) { append(data.str()); }
+
+    //! \brief Copy the first `len` bytes into a new std::string
+    virtual std::string peek(const size_t len) const = 0;
+
+    //! \brief The first `len` bytes as a BufferList
+    //! \note The default copies into a single Buffer; storages that hold Buffers slice them instead.
+    virtual BufferList peek_buffers(const size_t len) const { return BufferList{peek(len)}; }
+
+    //! \brief Views of the first `len` bytes, valid until the storage is next modified
+    virtual BufferViewList peek_spans(const size_t len) const = 0;
+
+    //! \brief The longest prefix of the first `len` bytes that is contiguous in memory
+    //! \note The default is the first span returned by peek_spans().
+    virtual std::string_view peek_view(const size_t len) const;
+
+    //! \brief Discard the first `len` bytes
+    virtual void pop(const size_t len) = 0;
+
+    //! \brief Space for up to `len` more bytes, to be filled in place and then committed
+    //! \note The spans are valid until the storage is next modified.
+    virtual std::vector<iovec> writable_spans(const size_t len) = 0;
+
+    //! \brief Append the first `len` bytes of the space returned by writable_spans()
+    virtual void commit(const size_t len) = 0;
+
+    //! \returns `true` if the storage's free space keeps its contents until it is committed, so
+    //! that bytes can be staged there ahead of the bytes before them (see stage())
+    virtual bool can_stage() const { return false; }
+
+    //! \brief Copy bytes into the free space, `offset` bytes past the end of the stored bytes
+    //! \details The bytes stay where they are, unreadable, until a later commit() reaches past them.
+    //! Appending over staged bytes overwrites them.
+    virtual void stage(const size_t offset, std::string_view data);
+
+    //! \returns the number of bytes held
+    virtual size_t size() const = 0;
+
+    //! \returns the number of bytes of memory the storage is holding on to, whether in use or not
+    virtual size_t footprint() const = 0;
+
+    virtual ~StreamStorage() = default;
+};
+
+//! \brief A ring of `capacity` bytes, allocated up front
+//! \details Both the stored bytes and the free space are at most two contiguous spans,
+//! split where the ring wraps, so copies in and out are done a span at a time.
+class RingStorage : public StreamStorage {
+  private:
+    std::vector<char> buffer;
+    const size_t buf_len;
+    size_t head{0}, tail{0};
+
+  public:
+    //! Construct a ring with room for `capacity` bytes
+    explicit RingStorage(const size_t capacity) : buffer(capacity + 1), buf_len(capacity + 1) {}
+
+    void append(std::string_view data) override;
+    std::string peek(const size_t len) const override;
+    BufferViewList peek_spans(const size_t len) const override;
+    void pop(const size_t len) override;
+    std::vector<iovec> writable_spans(const size_t len) override;
+    void commit(const size_t len) override { tail = (tail + len) % buf_len; }
+    bool can_stage() const override { return true; }
+    void stage(const size_t offset, std::string_view data) override;
+    size_t size() const override { return head <= tail ? tail - head : tail + buf_len - head; }
+    size_t footprint() const override { return buffer.capacity(); }
+};
+
+//! \brief A queue of reference-counted Buffer chunks
+//! \details Buffers handed to append() are adopted rather than copied, and peek_buffers()
+//! returns slices of the stored chunks, so bytes can move from writer to reader without a copy.
+//!
+//! Writable space is a staging string that becomes a new chunk when it is committed, unless only a small
+//! part of it was filled; that part is copied into a chunk of its own, and the string kept for next time.
+class ChunkedStorage : public StreamStorage {
+  private:
+    std::deque<Buffer> _chunks{};
+    size_t _size{0};
+    std::string _staging{};
+
+  public:
+    void append(std::string_view data) override;
+    void append(Buffer data) override;
+    std::string peek(const size_t len) const override;
+    BufferList peek_buffers(const size_t len) const override;
+    BufferViewList peek_spans(const size_t len) const override;
+    void pop(const size_t len) override;
+    std::vector<iovec> writable_spans(const size_t len) override;
+    void commit(const size_t len) override;
+    size_t size() const override { return _size; }
+    //! \returns the storage held by the chunks (whole, however little of each is still unread) and staging
+    size_t footprint() const override;
+};
+
+//! \brief A ring whose pages are mapped twice, back to back, so that it never appears to wrap
+//! \details The ring is a [memfd_create(2)](\ref man2::memfd_create) file of `capacity` bytes (rounded up
+//! to a whole number of pages) mapped at `base` and again at `base + size`. A byte at offset `i` of the
+//! ring can then be reached at both `base + i` and `base + size + i`, so the stored bytes and the free space
+//! are each always one contiguous span starting at `base + head`, and moving `head` needs no modulo.
+class MirroredStorage : public StreamStorage {
+  private:
+    size_t _map_len;   //!< size of one mapping of the ring (a multiple of the page size)
+    char *_base;       //!< start of the two consecutive mappings
+    size_t _head{0};   //!< offset of the first stored byte, always less than `_map_len`
+    size_t _size{0};   //!< number of bytes stored
+
+  public:
+    //! Construct a ring with room for (at least) `capacity` bytes
+    explicit MirroredStorage(const size_t capacity);
+    ~MirroredStorage() override;
+
+    //! \name
+    //! MirroredStorage owns its mappings, and can't be copied
+    //!@{
+    MirroredStorage(const MirroredStorage &other) = delete;
+    MirroredStorage &operator=(const MirroredStorage &other) = delete;
+    //!@}
+
+    void append(std::string_view data) override;
+    std::string peek(const size_t len) const override { return std::string(peek_view(len)); }
+    BufferViewList peek_spans(const size_t len) const override { return peek_view(len); }
+    std::string_view peek_view(const size_t len) const override;
+    void pop(const size_t len) override;
+    std::vector<iovec> writable_spans(const size_t len) override;
+    void commit(const size_t len) override { _size += len; }
+    bool can_stage() const override { return true; }
+    void stage(const size_t offset, std::string_view data) override;
+    size_t size() const override { return _size; }
+    size_t footprint() const override { return _map_len; }
+};
+
+//! \brief A queue of pages from the PagePool, taken as bytes arrive and returned as they are read
+//! \details Unlike the other storages, the memory held is proportional to the number of bytes
+//! stored rather than to the stream's capacity, so an idle stream holds no pages at all.
+class PagedStorage : public StreamStorage {
+  public:
+    //! Most pages of free space writable_spans() offers at once, so that a large free space doesn't take
+    //! (and then give back) pages for all of it on every write in place
+    static constexpr size_t MAX_WRITABLE_PAGES = 16;
+
+  private:
+    std::deque<PagePool::Page> _pages{};
+    size_t _head{0};    //!< offset of the first stored byte in the first page
+    size_t _size{0};    //!< number of bytes stored
+    size_t _staged{0};  //!< number of bytes past the stored bytes whose pages hold staged bytes
+
+    //! Return pages at the back that hold no stored or staged bytes to the pool
+    void release_unused_pages();
+
+    //! One span per page for the `len` bytes past the stored bytes, taking pages from the pool as needed
+    std::vector<iovec> spans_past_end(const size_t len);
+
+  public:
+    PagedStorage() = default;
+    ~PagedStorage() override;
+
+    //! \name
+    //! PagedStorage owns its pages, and can't be copied
+    //!@{
+    PagedStorage(const PagedStorage &other) = delete;
+    PagedStorage &operator=(const PagedStorage &other) = delete;
+    //!@}
+
+    void append(std::string_view data) override;
+    std::string peek(const size_t len) const override;
+    BufferViewList peek_spans(const size_t len) const override;
+    void pop(const size_t len) override;
+    //! \returns at most MAX_WRITABLE_PAGES pages of space, however large `len` is
+    std::vector<iovec> writable_spans(const size_t len) override;
+    void commit(const size_t len) override;
+    bool can_stage() const override { return true; }
+    void stage(const size_t offset, std::string_view data) override;
+    size_t size() const override { return _size; }
+    size_t footprint() const override { return _pages.size() * PagePool::PAGE_SIZE; }
+};
+
+#endif  // SPONGE_LIBSPONGE_STREAM_STORAGE_HH
@@ -0,0 +1,167 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+#include "page_pool.hh"
+#include "stream_storage.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            ByteStreamTestHarness test{"write-in-place-pop", 15};
+
+            test.execute(WriteInPlace{"cat"}.with_bytes_written(3));
+
+            test.execute(InputEnded{false});
+            test.execute(BufferEmpty{false});
+            test.execute(Eof{false});
+            test.execute(BytesRead{0});
+            test.execute(BytesWritten{3});
+            test.execute(RemainingCapacity{12});
+            test.execute(BufferSize{3});
+            test.execute(Peek{"cat"});
+
+            test.execute(Pop{3});
+
+            test.execute(BufferEmpty{true});
+            test.execute(BytesRead{3});
+            test.execute(RemainingCapacity{15});
+        }
+
+        {
+            ByteStreamTestHarness test{"write-in-place-past-capacity", 2};
+
+            test.execute(WriteInPlace{"cat"}.with_bytes_written(2));
+
+            test.execute(BytesWritten{2});
+            test.execute(RemainingCapacity{0});
+            test.execute(BufferSize{2});
+            test.execute(Peek{"ca"});
+
+            test.execute(WriteInPlace{"t"}.with_bytes_written(0));
+
+            test.execute(BytesWritten{2});
+            test.execute(Peek{"ca"});
+        }
+
+        {
+            ByteStreamTestHarness test{"write-in-place-across-wrap", 8};
+
+            test.execute(Write{"abcdef"});
+            test.execute(Pop{5});
+            test.execute(Peek{"f"});
+
+            test.execute(WriteInPlace{"ghijklmno"}.with_bytes_written(7));
+
+            test.execute(BytesWritten{13});
+            test.execute(BytesRead{5});
+            test.execute(RemainingCapacity{0});
+            test.execute(BufferSize{8});
+            test.execute(Peek{"fghijklm"});
+
+            test.execute(Pop{4});
+            test.execute(WriteInPlace{"nop"}.with_bytes_written(3));
+            test.execute(Peek{"jklmnop"});
+
+            test.execute(EndInput{});
+            test.execute(WriteInPlace{"q"}.with_bytes_written(0));
+            test.execute(Pop{7});
+            test.execute(Eof{true});
+        }
+
+        {
+            ByteStreamTestHarness test{"mixed-writes-across-wrap", 5};
+
+            test.execute(WriteInPlace{"abc"});
+            test.execute(Pop{2});
+            test.execute(Write{"defg"}.with_bytes_written(4));
+            test.execute(Peek{"cdefg"});
+            test.execute(Pop{3});
+            test.execute(WriteInPlace{"hij"}.with_bytes_written(3));
+            test.execute(Peek{"fghij"});
+            test.execute(BytesWritten{10});
+            test.execute(BytesRead{5});
+        }
+
+        {
+            // a mirrored ring is contiguous even once its contents wrap past the end of its pages
+            ByteStream bs{4096, ByteStream::Storage::Mirrored};
+            bs.write(string(4000, 'a'));
+            bs.pop_output(4000);
+            const string data = string(500, 'b') + string(500, 'c');
+            if (bs.write(data) != data.size()) {
+                throw runtime_error("mirrored stream did not accept a write that wraps");
+            }
+            if (bs.peek_view(data.size()) != data or bs.peek_spans(data.size()).as_iovecs().size() != 1) {
+                throw runtime_error("mirrored stream was not contiguous after wrapping");
+            }
+            bs.pop_output(600);
+            if (bs.writable_spans().size() != 1 or bs.writable_spans().front().iov_len != 3696) {
+                throw runtime_error("mirrored stream's free space was not one span");
+            }
+        }
+
+        {
+            // small reads into a chunked stream's free space don't each pin an allocation that size
+            ByteStream bs{1 << 20, ByteStream::Storage::Chunked};
+            for (unsigned int i = 0; i < 64; i++) {
+                const auto spans = bs.writable_spans();
+                static_cast<char *>(spans.front().iov_base)[0] = 'x';
+                bs.commit_write(1);
+            }
+            if (bs.buffer_size() != 64 or bs.read(64) != string(64, 'x')) {
+                throw runtime_error("chunked stream lost bytes written in place");
+            }
+            if (bs.footprint() > 2 * (1 << 20)) {
+                throw runtime_error("chunked stream held " + to_string(bs.footprint()) + " bytes for 64");
+            }
+        }
+
+        {
+            // a paged stream's free space is offered a bounded number of pages at a time
+            ByteStream bs{1 << 20, ByteStream::Storage::Paged};
+            bs.write("abc");
+            for (unsigned int i = 0; i < 2; i++) {
+                size_t offered = 0;
+                for (const auto &span : bs.writable_spans()) {
+                    offered += span.iov_len;
+                }
+                const size_t expected = PagedStorage::MAX_WRITABLE_PAGES * PagePool::PAGE_SIZE - 3;
+                if (offered != expected or bs.footprint() > PagedStorage::MAX_WRITABLE_PAGES * PagePool::PAGE_SIZE) {
+                    throw runtime_error("paged stream offered " + to_string(offered) + " bytes of free space");
+                }
+                bs.commit_write(0);
+            }
+            if (bs.footprint() != PagePool::PAGE_SIZE) {
+                throw runtime_error("paged stream kept pages it offered but didn't fill");
+            }
+        }
+
+        // bytes staged ahead of the end of the stream become readable once the bytes before them are written
+        for (const auto storage :
+             {ByteStream::Storage::Ring, ByteStream::Storage::Mirrored, ByteStream::Storage::Paged}) {
+            ByteStream bs{8192, storage};
+            bs.write(string(8000, 'a'));
+            bs.pop_output(7998);
+            bs.stage_write(2, string(5000, 'c'));
+            bs.stage_write(1, "b");
+            if (bs.buffer_size() != 2 or bs.bytes_written() != 8000) {
+                throw runtime_error("staged bytes were readable before they were committed");
+            }
+            bs.write("b");
+            bs.commit_write(5001);
+            const string expected = "aabb" + string(5000, 'c');
+            if (bs.read(bs.buffer_size()) != expected or bs.bytes_written() != 13002) {
+                throw runtime_error("staged bytes were not readable once committed");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
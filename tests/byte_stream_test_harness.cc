@@ -46,7 +46,11 @@ void ByteStreamAction::execute(ByteStream &) const {}
 ByteStreamAction::~ByteStreamAction() {}
 
 ByteStreamTestHarness::ByteStreamTestHarness(const std::string &test_name, const size_t capacity)
-    : _test_name(test_name), _byte_stream(capacity) {
+    : _test_name(test_name) {
+    _byte_streams.emplace_back("ring", ByteStream{capacity, ByteStream::Storage::Ring});
+    _byte_streams.emplace_back("chunked", ByteStream{capacity, ByteStream::Storage::Chunked});
+    _byte_streams.emplace_back("mirrored", ByteStream{capacity, ByteStream::Storage::Mirrored});
+    _byte_streams.emplace_back("paged", ByteStream{capacity, ByteStream::Storage::Paged});
     std::ostringstream ss;
     ss << "Initialized with ("
        << "capacity=" << capacity << ")";
@@ -54,29 +58,31 @@ ByteStreamTestHarness::ByteStreamTestHarness(const std::string &test_name, const
 }
 
 void ByteStreamTestHarness::execute(const ByteStreamTestStep &step) {
-    try {
-        step.execute(_byte_stream);
-        _steps_executed.emplace_back(step);
-    } catch (const ByteStreamExpectationViolation &e) {
-        std::cerr << "Test Failure on expectation:\n\t" << std::string(step);
-        std::cerr << "\n\nFailure message:\n\t" << e.what();
-        std::cerr << "\n\nList of steps that executed successfully:";
-        for (const std::string &s : _steps_executed) {
-            std::cerr << "\n\t" << s;
+    for (auto &[storage, byte_stream] : _byte_streams) {
+        try {
+            step.execute(byte_stream);
+        } catch (const ByteStreamExpectationViolation &e) {
+            std::cerr << "Test Failure on expectation (" << storage << " storage):\n\t" << std::string(step);
+            std::cerr << "\n\nFailure message:\n\t" << e.what();
+            std::cerr << "\n\nList of steps that executed successfully:";
+            for (const std::string &s : _steps_executed) {
+                std::cerr << "\n\t" << s;
+            }
+            std::cerr << std::endl << std::endl;
+            throw ByteStreamExpectationViolation("The test \"" + _test_name + "\" failed");
+        } catch (const exception &e) {
+            std::cerr << "Test Failure on expectation (" << storage << " storage):\n\t" << std::string(step);
+            std::cerr << "\n\nException:\n\t" << e.what();
+            std::cerr << "\n\nList of steps that executed successfully:";
+            for (const std::string &s : _steps_executed) {
+                std::cerr << "\n\t" << s;
+            }
+            std::cerr << std::endl << std::endl;
+            throw ByteStreamExpectationViolation("The test \"" + _test_name +
+                                                 "\" caused your implementation to throw an exception!");
         }
-        std::cerr << std::endl << std::endl;
-        throw ByteStreamExpectationViolation("The test \"" + _test_name + "\" failed");
-    } catch (const exception &e) {
-        std::cerr << "Test Failure on expectation:\n\t" << std::string(step);
-        std::cerr << "\n\nException:\n\t" << e.what();
-        std::cerr << "\n\nList of steps that executed successfully:";
-        for (const std::string &s : _steps_executed) {
-            std::cerr << "\n\t" << s;
-        }
-        std::cerr << std::endl << std::endl;
-        throw ByteStreamExpectationViolation("The test \"" + _test_name +
-                                             "\" caused your implementation to throw an exception!");
     }
+    _steps_executed.emplace_back(step);
 }
 
 // EndInput
@@ -97,6 +103,26 @@ void Write::execute(ByteStream &bs) const {
     }
 }
 
+// WriteInPlace
+WriteInPlace::WriteInPlace(const std::string &data) : _data(data) {}
+WriteInPlace &WriteInPlace::with_bytes_written(const size_t bytes_written) {
+    _bytes_written = bytes_written;
+    return *this;
+}
+std::string WriteInPlace::description() const {
+    return "write \"" + _data + "\" into the stream's writable_spans() and commit it";
+}
+void WriteInPlace::execute(ByteStream &bs) const {
+    size_t bytes_written = 0;
+    for (const auto &span : bs.writable_spans()) {
+        bytes_written += _data.copy(static_cast<char *>(span.iov_base), span.iov_len, bytes_written);
+    }
+    bs.commit_write(bytes_written);
+    if (_bytes_written and bytes_written != _bytes_written.value()) {
+        throw ByteStreamExpectationViolation::property("bytes_written", _bytes_written.value(), bytes_written);
+    }
+}
+
 // Pop
 Pop::Pop(const size_t len) : _len(len) {}
 std::string Pop::description() const { return "pop " + to_string(_len); }
@@ -181,4 +207,22 @@ void Peek::execute(ByteStream &bs) const {
         throw ByteStreamExpectationViolation("Expected \"" + _output + "\" at the front of the stream, but found \"" +
                                              output + "\"");
     }
+    auto buffers = bs.peek_buffers(_output.size()).concatenate();
+    if (buffers != _output) {
+        throw ByteStreamExpectationViolation("Expected \"" + _output + "\" at the front of the stream, but found \"" +
+                                             buffers + "\" (with peek_buffers)");
+    }
+    std::string spans;
+    for (const auto &span : bs.peek_spans(_output.size()).as_iovecs()) {
+        spans.append(static_cast<const char *>(span.iov_base), span.iov_len);
+    }
+    if (spans != _output) {
+        throw ByteStreamExpectationViolation("Expected \"" + _output + "\" at the front of the stream, but found \"" +
+                                             spans + "\" (with peek_spans)");
+    }
+    const std::string_view view = bs.peek_view(_output.size());
+    if (view != std::string_view(_output).substr(0, view.size())) {
+        throw ByteStreamExpectationViolation("Expected \"" + _output + "\" at the front of the stream, but found \"" +
+                                             std::string(view) + "\" (with peek_view)");
+    }
 }
@@ -10,6 +10,8 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 struct ByteStreamTestStep {
     virtual operator std::string() const;
@@ -56,6 +58,16 @@ struct Write : public ByteStreamAction {
     void execute(ByteStream &) const override;
 };
 
+struct WriteInPlace : public ByteStreamAction {
+    std::string _data;
+    std::optional<size_t> _bytes_written{};
+
+    WriteInPlace(const std::string &data);
+    WriteInPlace &with_bytes_written(const size_t bytes_written);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
 struct Pop : public ByteStreamAction {
     size_t _len;
 
@@ -128,9 +140,10 @@ struct Peek : public ByteStreamExpectation {
     void execute(ByteStream &) const override;
 };
 
+//! Runs every step against one ByteStream per ByteStream::Storage, so each storage passes the same tests
 class ByteStreamTestHarness {
     std::string _test_name;
-    ByteStream _byte_stream;
+    std::vector<std::pair<std::string, ByteStream>> _byte_streams{};
     std::vector<std::string> _steps_executed{};
 
   public:
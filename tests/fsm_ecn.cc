@@ -0,0 +1,231 @@
+#include "fd_adapter.hh"
+#include "ipv4_datagram.hh"
+#include "ipv4_header.hh"
+#include "lossy_fd_adapter.hh"
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+//! An adapter that hands back the segments written to it
+class LoopbackAdapter : public FdAdapterBase {
+  private:
+    queue<TCPSegment> _segments{};
+
+  public:
+    optional<TCPSegment> read() {
+        if (_segments.empty()) {
+            return {};
+        }
+        TCPSegment seg = move(_segments.front());
+        _segments.pop();
+        return seg;
+    }
+
+    void write(TCPSegment &seg) { _segments.push(seg); }
+};
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // the ECE and CWR flags survive serialization, and the ECN codepoint is carried in the IP header
+        {
+            TCPSegment seg;
+            seg.header().ece = true;
+            seg.header().cwr = true;
+            seg.payload() = string("hello");
+            seg.ecn() = IPv4Header::CE;
+            TCPSegment parsed;
+            if (parsed.parse(seg.serialize().concatenate()) != ParseResult::NoError or not parsed.header().ece or
+                not parsed.header().cwr or parsed.header().ack) {
+                throw runtime_error("ECN flags did not survive serialization: " + parsed.header().summary());
+            }
+
+            TCPOverIPv4Adapter adapter;
+            const auto datagrams = adapter.wrap_tcp_in_ip(seg);
+            if (datagrams.size() != 1 or datagrams.front().header().ecn() != IPv4Header::CE) {
+                throw runtime_error("the ECN codepoint was not put in the IP header");
+            }
+            InternetDatagram received;
+            if (received.parse(datagrams.front().serialize().concatenate()) != ParseResult::NoError) {
+                throw runtime_error("the datagram did not parse");
+            }
+            const auto unwrapped = adapter.unwrap_tcp_in_ip(received);
+            if (not unwrapped.has_value() or unwrapped->ecn() != IPv4Header::CE or not unwrapped->header().cwr) {
+                throw runtime_error("the ECN codepoint was not taken from the IP header");
+            }
+        }
+
+        // the lossy adapter marks ECN-capable segments CE at the configured rate, and no others
+        {
+            LossyFdAdapter<LoopbackAdapter> lossy{LoopbackAdapter{}};
+            lossy.config_mut().ce_rate_up = 1 << 15;
+            size_t marked = 0;
+            for (const uint8_t ecn : {IPv4Header::NOT_ECT, IPv4Header::ECT_0}) {
+                for (size_t i = 0; i < 1000; i++) {
+                    TCPSegment seg;
+                    seg.ecn() = ecn;
+                    lossy.write(seg);
+                    const auto read = lossy.read();
+                    if (read->ecn() == IPv4Header::CE) {
+                        if (ecn == IPv4Header::NOT_ECT) {
+                            throw runtime_error("a segment that isn't ECN-capable was marked CE");
+                        }
+                        marked++;
+                    }
+                }
+            }
+            if (marked < 400 or marked > 600) {
+                throw runtime_error("expected about half of 1000 segments marked CE, got " + to_string(marked));
+            }
+        }
+
+        TCPConfig cfg{};
+        cfg.ecn = true;
+
+        // ECN is offered on an active open; once agreed, a CE mark is echoed, without delay, on every ack
+        // until the peer sends CWR
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPConfig c{cfg};
+            c.fixed_isn = tx_isn;
+            c.delayed_ack = true;
+            TCPTestHarness test_1{c};
+            test_1.execute(Connect{});
+            test_1.execute(ExpectOneSegment{}.with_syn(true).with_ece(true).with_cwr(true));
+            test_1.execute(SendSegment{}
+                               .with_syn(true)
+                               .with_ack(true)
+                               .with_ece(true)
+                               .with_seqno(rx_isn)
+                               .with_ackno(tx_isn + 1)
+                               .with_win(1000));
+            test_1.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1).with_ece(false));
+            test_1.execute(ExpectState{State::ESTABLISHED});
+
+            auto send = [&](const size_t offset, string &&data, const uint8_t ecn, const bool cwr) {
+                test_1.execute(SendSegment{}
+                                   .with_ack(true)
+                                   .with_ackno(tx_isn + 1)
+                                   .with_seqno(rx_isn + 1 + offset)
+                                   .with_win(1000)
+                                   .with_data(move(data))
+                                   .with_ecn(ecn)
+                                   .with_cwr(cwr));
+            };
+            send(0, "abc", IPv4Header::CE, false);
+            test_1.execute(ExpectOneSegment{}.with_ackno(rx_isn + 4).with_ece(true),
+                           "test 1 failed: CE mark not echoed at once");
+            send(3, "def", IPv4Header::ECT_0, false);
+            test_1.execute(ExpectNoSegment{});
+            test_1.execute(Tick{TCPConfig::DELAYED_ACK_TIMEOUT_DFLT});
+            test_1.execute(ExpectOneSegment{}.with_ackno(rx_isn + 7).with_ece(true),
+                           "test 1 failed: echo stopped before CWR");
+            send(6, "ghi", IPv4Header::ECT_0, true);
+            test_1.execute(Tick{TCPConfig::DELAYED_ACK_TIMEOUT_DFLT});
+            test_1.execute(ExpectOneSegment{}.with_ackno(rx_isn + 10).with_ece(false),
+                           "test 1 failed: echo continued after CWR");
+        }
+
+        // a passive open agrees to ECN when the SYN asks for it with both flags
+        {
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_2 = TCPTestHarness::in_listen(cfg);
+            test_2.execute(
+                SendSegment{}.with_syn(true).with_ece(true).with_cwr(true).with_seqno(rx_isn).with_win(1000));
+            test_2.execute(ExpectOneSegment{}.with_syn(true).with_ack(true).with_ece(true).with_cwr(false));
+        }
+        {
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_3 = TCPTestHarness::in_listen(cfg);
+            test_3.execute(SendSegment{}.with_syn(true).with_ece(true).with_seqno(rx_isn).with_win(1000));
+            test_3.execute(ExpectOneSegment{}.with_syn(true).with_ack(true).with_ece(false).with_cwr(false),
+                           "test 3 failed: ECN agreed to without CWR on the SYN");
+        }
+        {
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_4 = TCPTestHarness::in_listen(TCPConfig{});
+            test_4.execute(
+                SendSegment{}.with_syn(true).with_ece(true).with_cwr(true).with_seqno(rx_isn).with_win(1000));
+            test_4.execute(ExpectOneSegment{}.with_syn(true).with_ack(true).with_ece(false),
+                           "test 4 failed: ECN agreed to without being configured");
+        }
+
+        // without the peer's agreement, CE marks aren't echoed
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPConfig c{cfg};
+            c.fixed_isn = tx_isn;
+            TCPTestHarness test_5{c};
+            test_5.execute(Connect{});
+            test_5.execute(ExpectOneSegment{}.with_syn(true).with_ece(true).with_cwr(true));
+            test_5.execute(
+                SendSegment{}.with_syn(true).with_ack(true).with_seqno(rx_isn).with_ackno(tx_isn + 1).with_win(1000));
+            test_5.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1));
+            test_5.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_ackno(tx_isn + 1)
+                               .with_seqno(rx_isn + 1)
+                               .with_win(1000)
+                               .with_data("abc")
+                               .with_ecn(IPv4Header::CE));
+            test_5.execute(ExpectOneSegment{}.with_ackno(rx_isn + 4).with_ece(false));
+        }
+
+        // an echo is answered without a retransmission, and CWR goes on the next new data
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPConfig c{cfg};
+            c.fixed_isn = tx_isn;
+            c.congestion_control = CongestionControl::Algorithm::NewReno;
+            TCPTestHarness test_6{c};
+            test_6.execute(Connect{});
+            test_6.execute(ExpectOneSegment{}.with_syn(true));
+            test_6.execute(SendSegment{}
+                               .with_syn(true)
+                               .with_ack(true)
+                               .with_ece(true)
+                               .with_seqno(rx_isn)
+                               .with_ackno(tx_isn + 1)
+                               .with_win(1000));
+            test_6.execute(ExpectOneSegment{}.with_ack(true));
+
+            auto ack = [&](const size_t acked, const bool ece) {
+                test_6.execute(SendSegment{}
+                                   .with_ack(true)
+                                   .with_ece(ece)
+                                   .with_seqno(rx_isn + 1)
+                                   .with_ackno(tx_isn + 1 + acked)
+                                   .with_win(1000));
+            };
+            test_6.execute(Write{"aaaa"});
+            test_6.execute(ExpectOneSegment{}.with_data("aaaa").with_cwr(false));
+            ack(4, true);
+            test_6.execute(ExpectNoSegment{}, "test 6 failed: segment sent for an echo");
+            test_6.execute(Write{"bbbb"});
+            test_6.execute(ExpectOneSegment{}.with_data("bbbb").with_cwr(true), "test 6 failed: no CWR");
+            ack(8, false);
+            test_6.execute(Write{"cccc"});
+            test_6.execute(ExpectOneSegment{}.with_data("cccc").with_cwr(false), "test 6 failed: CWR repeated");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
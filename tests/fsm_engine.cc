@@ -0,0 +1,157 @@
+#include "ipv4_datagram.hh"
+#include "parser.hh"
+#include "tcp_config.hh"
+#include "tcp_engine.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_segment.hh"
+#include "tcp_state.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static constexpr uint32_t CLIENT_ADDRESS = 0x0a000001;  // 10.0.0.1
+static constexpr uint32_t SERVER_ADDRESS = 0x0a000002;  // 10.0.0.2
+static constexpr uint16_t SERVER_PORT = 80;
+static constexpr size_t CONNECTIONS = 100;
+
+//! A datagram as it would arrive: serialized, then parsed
+static InternetDatagram over_the_wire(const InternetDatagram &sent) {
+    InternetDatagram dgram;
+    if (dgram.parse(sent.serialize().concatenate()) != ParseResult::NoError) {
+        throw runtime_error("a datagram did not parse");
+    }
+    return dgram;
+}
+
+//! Deliver `from`'s datagrams to `to`
+static void move_datagrams(TCPEngine &from, TCPEngine &to) {
+    while (not from.datagrams_out().empty()) {
+        to.datagram_received(over_the_wire(from.datagrams_out().front()));
+        from.datagrams_out().pop();
+    }
+}
+
+static void exchange(TCPEngine &x, TCPEngine &y) {
+    while (not x.datagrams_out().empty() or not y.datagrams_out().empty()) {
+        move_datagrams(x, y);
+        move_datagrams(y, x);
+    }
+}
+
+static FourTuple client_side(const size_t i) {
+    return {CLIENT_ADDRESS, static_cast<uint16_t>(1000 + i), SERVER_ADDRESS, SERVER_PORT};
+}
+
+static FourTuple server_side(const size_t i) {
+    return {SERVER_ADDRESS, SERVER_PORT, CLIENT_ADDRESS, static_cast<uint16_t>(1000 + i)};
+}
+
+static void expect(const bool condition, const string &message) {
+    if (not condition) {
+        throw runtime_error(message);
+    }
+}
+
+int main() {
+    try {
+        TCPConfig cfg{};
+        TCPEngine client{cfg}, server{cfg};
+        server.listen(SERVER_PORT);
+
+        // many connections open over one pair of endpoints, and each is accepted once
+        for (size_t i = 0; i < CONNECTIONS; i++) {
+            client.connect(client_side(i));
+        }
+        exchange(client, server);
+        expect(client.size() == CONNECTIONS and server.size() == CONNECTIONS, "connections not all opened");
+        expect(server.accepted().size() == CONNECTIONS, "connections not all accepted");
+        for (size_t i = 0; i < CONNECTIONS; i++) {
+            expect(server.accepted().front() == server_side(i), "accepted " + server.accepted().front().to_string());
+            server.accepted().pop();
+            expect(client.connection(client_side(i)).state() == TCPState::State::ESTABLISHED and
+                       server.connection(server_side(i)).state() == TCPState::State::ESTABLISHED,
+                   "connection " + to_string(i) + " not established");
+        }
+        expect(client.timed() == 0 and server.timed() == 0, "idle connections are waiting on time");
+
+        bool threw = false;
+        try {
+            client.connect(client_side(0));
+        } catch (const runtime_error &) {
+            threw = true;
+        }
+        expect(threw, "a connection was opened twice");
+
+        // each connection's bytes reach its own stream
+        for (size_t i = 0; i < CONNECTIONS; i++) {
+            client.write(client_side(i), "hello " + to_string(i));
+        }
+        expect(client.timed() == CONNECTIONS, "connections with data in flight are not waiting on time");
+        exchange(client, server);
+        expect(client.timed() == 0, "acked connections are still waiting on time");
+        expect(server.timed() == CONNECTIONS, "connections with unread bytes are not waiting on time");
+        for (size_t i = 0; i < CONNECTIONS; i++) {
+            ByteStream &inbound = server.inbound_stream(server_side(i));
+            const string read = inbound.read(inbound.buffer_size());
+            expect(read == "hello " + to_string(i), "connection " + to_string(i) + " read \"" + read + "\"");
+        }
+        server.tick(1);
+        expect(server.timed() == 0, "connections whose bytes were read are still waiting on time");
+
+        // one timer, for the one connection that needs it
+        client.write(client_side(7), "lost");
+        client.datagrams_out().pop();
+        client.tick(cfg.rt_timeout - 1);
+        expect(client.datagrams_out().empty(), "retransmission before the timeout");
+        client.tick(1);
+        expect(client.datagrams_out().size() == 1, "no retransmission");
+        expect(client.timed() == 1, "only the connection with data in flight should wait on time");
+        exchange(client, server);
+        expect(server.inbound_stream(server_side(7)).read(4) == "lost", "retransmission not delivered");
+
+        // a SYN to a port that isn't listening is reset, and the connection dropped
+        const FourTuple refused{CLIENT_ADDRESS, 2000, SERVER_ADDRESS, SERVER_PORT + 1};
+        client.connect(refused);
+        exchange(client, server);
+        expect(not client.contains(refused), "SYN not refused");
+        expect(client.closed() == 1 and server.size() == CONNECTIONS, "refused connection not dropped, or accepted");
+
+        // a segment for a connection the server doesn't know is reset too
+        TCPSegment stale;
+        stale.header().ack = true;
+        stale.header().seqno = WrappingInt32{1};
+        stale.header().ackno = WrappingInt32{12345};
+        server.datagram_received(over_the_wire(
+            TCPOverIPv4Adapter::wrap_tcp_in_ip(stale, CLIENT_ADDRESS, 3000, SERVER_ADDRESS, SERVER_PORT).front()));
+        expect(server.datagrams_out().size() == 1, "no reset for an unknown connection");
+        const auto rst = TCPOverIPv4Adapter::parse_tcp_in_ip(over_the_wire(server.datagrams_out().front()));
+        expect(rst.has_value() and rst->header().rst and rst->header().seqno == WrappingInt32{12345},
+               "expected a RST with seqno 12345");
+        server.datagrams_out().pop();
+
+        // connections close, and leave the tables, once both streams end and the linger is over
+        for (size_t i = 0; i < CONNECTIONS; i++) {
+            client.end_input_stream(client_side(i));
+        }
+        exchange(client, server);
+        for (size_t i = 0; i < CONNECTIONS; i++) {
+            server.end_input_stream(server_side(i));
+        }
+        exchange(client, server);
+        expect(server.size() == 0 and server.closed() == CONNECTIONS, "passive closers not dropped");
+        client.tick(10 * cfg.rt_timeout);
+        expect(client.size() == 0 and client.closed() == 1 + CONNECTIONS, "lingering connections not dropped");
+        expect(client.timed() == 0, "dropped connections are still waiting on time");
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,146 @@
+#include "fsm_retx.hh"
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        TCPConfig cfg{};
+        cfg.recv_capacity = 65000;
+        cfg.fast_retransmit = true;
+        auto rd = get_random_generator();
+
+        // three duplicate acks retransmit the oldest outstanding segment, once
+        {
+            WrappingInt32 tx_ackno(rd());
+            TCPTestHarness test_1 = TCPTestHarness::in_established(cfg, tx_ackno - 1, tx_ackno - 1);
+
+            const vector<string> data{"asdf", "qwer", "zxcv", "uiop"};
+            for (const auto &d : data) {
+                test_1.execute(Write{d});
+                test_1.execute(Tick(1));
+            }
+            for (const auto &d : data) {
+                check_segment(test_1, d, &d != &data.back(), __LINE__);
+            }
+
+            test_1.send_ack(tx_ackno, tx_ackno + 4);
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: segment sent on new ack");
+            for (unsigned i = 1; i < TCPConfig::DUPACK_THRESHOLD; i++) {
+                test_1.send_ack(tx_ackno, tx_ackno + 4);
+                test_1.execute(ExpectNoSegment{}, "test 1 failed: fast retransmit too early");
+            }
+            test_1.send_ack(tx_ackno, tx_ackno + 4);
+            check_segment(test_1, data[1], false, __LINE__);
+            test_1.send_ack(tx_ackno, tx_ackno + 4);
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: fast retransmit repeated");
+
+            // the retransmission timer is still running from the new ack
+            test_1.execute(Tick(cfg.rt_timeout - 1));
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: re-tx too fast");
+            test_1.execute(Tick(1));
+            check_segment(test_1, data[1], false, __LINE__);
+        }
+
+        // an ack with a different window, or on a segment with data, is no duplicate
+        {
+            WrappingInt32 tx_ackno(rd());
+            TCPTestHarness test_2 = TCPTestHarness::in_established(cfg, tx_ackno - 1, tx_ackno - 1);
+
+            const vector<string> data{"asdf", "qwer"};
+            for (const auto &d : data) {
+                test_2.execute(Write{d});
+                test_2.execute(Tick(1));
+            }
+            for (const auto &d : data) {
+                check_segment(test_2, d, &d != &data.back(), __LINE__);
+            }
+
+            test_2.send_ack(tx_ackno, tx_ackno, 1000);
+            test_2.send_ack(tx_ackno, tx_ackno, 1000);
+            test_2.send_byte(tx_ackno, tx_ackno, 'x');
+            test_2.execute(ExpectSegment{}.with_ack(true).with_ackno(tx_ackno + 1).with_payload_size(0));
+            test_2.send_ack(tx_ackno + 1, tx_ackno, 2000);
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: fast retransmit on non-duplicate acks");
+            test_2.send_ack(tx_ackno + 1, tx_ackno, 2000);
+            test_2.send_ack(tx_ackno + 1, tx_ackno, 2000);
+            check_segment(test_2, data[0], false, __LINE__);
+        }
+
+        // in NewReno fast recovery, a partial ack retransmits the next hole
+        {
+            TCPConfig newreno_cfg = cfg;
+            newreno_cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+            WrappingInt32 tx_ackno(rd());
+            TCPTestHarness test_3 = TCPTestHarness::in_established(newreno_cfg, tx_ackno - 1, tx_ackno - 1);
+
+            const vector<string> data{"asdf", "qwer", "zxcv", "uiop"};
+            for (const auto &d : data) {
+                test_3.execute(Write{d});
+                test_3.execute(Tick(1));
+            }
+            for (const auto &d : data) {
+                check_segment(test_3, d, &d != &data.back(), __LINE__);
+            }
+
+            for (unsigned i = 0; i < TCPConfig::DUPACK_THRESHOLD; i++) {
+                test_3.send_ack(tx_ackno, tx_ackno);
+            }
+            check_segment(test_3, data[0], false, __LINE__);
+            test_3.send_ack(tx_ackno, tx_ackno + 8);
+            check_segment(test_3, data[2], false, __LINE__);
+            for (unsigned i = 0; i < TCPConfig::DUPACK_THRESHOLD; i++) {
+                test_3.send_ack(tx_ackno, tx_ackno + 8);
+            }
+            test_3.execute(ExpectNoSegment{}, "test 3 failed: fast retransmit repeated within recovery");
+            test_3.send_ack(tx_ackno, tx_ackno + 16);
+            test_3.execute(ExpectNoSegment{}, "test 3 failed: re-tx after recovery ended");
+        }
+
+        // limited transmit sends a new segment on each of the first two duplicate acks
+        {
+            const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+            TCPConfig limited_cfg = cfg;
+            limited_cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+            limited_cfg.initial_cwnd = 2 * mss;
+            limited_cfg.limited_transmit = true;
+            WrappingInt32 tx_ackno(rd());
+            TCPTestHarness test_4 = TCPTestHarness::in_established(limited_cfg, tx_ackno - 1, tx_ackno - 1);
+            test_4.send_ack(tx_ackno, tx_ackno, 65000);
+
+            test_4.execute(Write{string(4 * mss, 'a')});
+            test_4.execute(ExpectSegment{}.with_seqno(tx_ackno).with_payload_size(mss));
+            test_4.execute(ExpectSegment{}.with_seqno(tx_ackno + mss).with_payload_size(mss));
+            test_4.execute(ExpectNoSegment{}, "test 4 failed: congestion window exceeded");
+            test_4.execute(Write{string(2 * mss, 'b')});
+            test_4.execute(ExpectNoSegment{}, "test 4 failed: congestion window exceeded");
+
+            test_4.send_ack(tx_ackno, tx_ackno + mss, 65000);
+            test_4.execute(ExpectSegment{}.with_seqno(tx_ackno + 2 * mss).with_payload_size(mss));
+            test_4.execute(ExpectSegment{}.with_seqno(tx_ackno + 3 * mss).with_payload_size(mss));
+            test_4.execute(ExpectNoSegment{}, "test 4 failed: congestion window exceeded");
+
+            test_4.send_ack(tx_ackno, tx_ackno + mss, 65000);
+            test_4.execute(ExpectSegment{}.with_seqno(tx_ackno + 4 * mss).with_payload_size(mss));
+            test_4.execute(ExpectNoSegment{}, "test 4 failed: more than one segment per duplicate ack");
+            test_4.send_ack(tx_ackno, tx_ackno + mss, 65000);
+            test_4.execute(ExpectSegment{}.with_seqno(tx_ackno + 5 * mss).with_payload_size(mss));
+            test_4.execute(ExpectNoSegment{}, "test 4 failed: more than one segment per duplicate ack");
+            test_4.send_ack(tx_ackno, tx_ackno + mss, 65000);
+            test_4.execute(ExpectSegment{}.with_seqno(tx_ackno + mss).with_payload_size(mss));
+            test_4.execute(ExpectNoSegment{}, "test 4 failed: new data sent beyond the recovery window");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,141 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // Nagle's algorithm: small writes wait for the data in flight to be acked
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPConfig cfg{};
+            cfg.nagle = true;
+            TCPTestHarness test_1 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+            auto ack = [&](const size_t acked) {
+                test_1.execute(
+                    SendSegment{}.with_ack(true).with_ackno(tx_isn + 1 + acked).with_seqno(rx_isn + 1).with_win(10000));
+            };
+            ack(0);
+
+            test_1.execute(Write{"a"});
+            test_1.execute(ExpectOneSegment{}.with_data("a"), "test 1 failed: nothing was in flight");
+            test_1.execute(Write{"b"});
+            test_1.execute(Write{"c"});
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: small segment sent while data was in flight");
+            ack(1);
+            test_1.execute(ExpectOneSegment{}.with_seqno(tx_isn + 2).with_data("bc"));
+            if (test_1._fsm.counters().nagle_coalesced != 1) {
+                throw runtime_error("test 1 failed: expected one coalesced write, got " +
+                                    to_string(test_1._fsm.counters().nagle_coalesced));
+            }
+
+            // a full-sized segment goes out regardless
+            test_1.execute(Write{string(MSS + 1, 'x')});
+            test_1.execute(ExpectOneSegment{}.with_seqno(tx_isn + 4).with_payload_size(MSS));
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: the leftover byte was sent");
+            ack(3 + MSS);
+            test_1.execute(ExpectOneSegment{}.with_seqno(tx_isn + 4 + MSS).with_payload_size(1));
+
+            // TCP_NODELAY
+            test_1._fsm.set_nodelay(true);
+            test_1.execute(Write{"d"});
+            test_1.execute(ExpectOneSegment{}.with_data("d"), "test 1 failed: nodelay segment held");
+            test_1._fsm.set_nodelay(false);
+
+            // the last segment of the stream isn't held
+            test_1.execute(Write{"e"});
+            test_1.execute(ExpectNoSegment{});
+            test_1.execute(Close{});
+            test_1.execute(ExpectOneSegment{}.with_data("e").with_fin(true), "test 1 failed: FIN held");
+        }
+
+        // delayed acks: every second full-sized segment, or after the timeout
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPConfig cfg{};
+            cfg.delayed_ack = true;
+            TCPTestHarness test_2 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+            auto send = [&](const size_t offset, string &&data) {
+                test_2.execute(SendSegment{}
+                                   .with_ack(true)
+                                   .with_ackno(tx_isn + 1)
+                                   .with_seqno(rx_isn + 1 + offset)
+                                   .with_win(10000)
+                                   .with_data(move(data)));
+            };
+
+            send(0, "abc");
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: ack not delayed");
+            test_2.execute(Tick{TCPConfig::DELAYED_ACK_TIMEOUT_DFLT - 1});
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: ack sent before the timeout");
+            test_2.execute(Tick{1});
+            test_2.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 4).with_payload_size(0));
+
+            send(3, string(MSS, 'x'));
+            test_2.execute(ExpectNoSegment{});
+            send(3 + MSS, string(MSS, 'y'));
+            test_2.execute(ExpectOneSegment{}.with_ackno(rx_isn + 4 + 2 * MSS),
+                           "test 2 failed: second full-sized segment not acked at once");
+
+            // out-of-order data, and the segment that fills the hole, are acked at once
+            const size_t next = 3 + 2 * MSS;
+            send(next + 1, "q");
+            test_2.execute(ExpectOneSegment{}.with_ackno(rx_isn + 1 + next), "test 2 failed: gap not acked");
+            send(next, "p");
+            test_2.execute(ExpectOneSegment{}.with_ackno(rx_isn + 3 + next), "test 2 failed: filled gap not acked");
+
+            // the delayed ack rides on data
+            send(next + 2, "r");
+            test_2.execute(ExpectNoSegment{});
+            test_2.execute(Write{"hello"});
+            test_2.execute(ExpectOneSegment{}.with_data("hello").with_ackno(rx_isn + 4 + next));
+            test_2.execute(Tick{TCPConfig::DELAYED_ACK_TIMEOUT_DFLT});
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: ack sent again after it rode on data");
+
+            // a FIN is acked at once
+            test_2.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_fin(true)
+                               .with_ackno(tx_isn + 6)
+                               .with_seqno(rx_isn + 4 + next)
+                               .with_win(10000));
+            test_2.execute(ExpectState{State::CLOSE_WAIT});
+            test_2.execute(ExpectOneSegment{}.with_ackno(rx_isn + 5 + next), "test 2 failed: FIN not acked");
+
+            // one ack saved by the pair of full-sized segments, and one by riding on data
+            if (test_2._fsm.counters().acks_avoided != 2) {
+                throw runtime_error("test 2 failed: expected two acks avoided, got " +
+                                    to_string(test_2._fsm.counters().acks_avoided));
+            }
+        }
+
+        // without delayed acks, every segment is acked at once
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_3 = TCPTestHarness::in_established(TCPConfig{}, tx_isn, rx_isn);
+            test_3.execute(
+                SendSegment{}.with_ack(true).with_ackno(tx_isn + 1).with_seqno(rx_isn + 1).with_win(10000).with_data(
+                    "abc"));
+            test_3.execute(ExpectOneSegment{}.with_ackno(rx_isn + 4));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,209 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // SACK options survive serialization, and unknown or malformed options are skipped
+        {
+            TCPSegment seg;
+            seg.header().syn = true;
+            seg.header().sack_permitted = true;
+            seg.header().sack = {{WrappingInt32{10}, WrappingInt32{20}}, {WrappingInt32{30}, WrappingInt32{40}}};
+            seg.payload() = string("hello");
+            TCPSegment parsed;
+            if (parsed.parse(seg.serialize().concatenate()) != ParseResult::NoError or
+                not parsed.header().sack_permitted or parsed.header().sack != seg.header().sack or
+                parsed.payload().str() != "hello") {
+                throw runtime_error("SACK options did not survive serialization: " + parsed.header().summary());
+            }
+
+            TCPHeader header;
+            header.doff = 8;
+            string raw = header.serialize();
+            // NOP, an unknown 4-byte option, SACK-permitted, then a SACK option longer than the header
+            raw.replace(TCPHeader::LENGTH, 12, string{1, 30, 4, 0x2b, 0x2d, 4, 2, 5, 20, 0, 0, 0});
+            raw.append("hello");
+            InternetChecksum check;
+            check.add(raw);
+            const uint16_t cksum = check.value();
+            raw[16] = static_cast<char>(cksum >> 8);
+            raw[17] = static_cast<char>(cksum & 0xff);
+            if (parsed.parse(move(raw)) != ParseResult::NoError or not parsed.header().sack_permitted or
+                not parsed.header().sack.empty() or parsed.payload().str() != "hello") {
+                throw runtime_error("options were not skipped correctly: " + parsed.header().summary());
+            }
+        }
+
+        TCPConfig cfg{};
+        cfg.sack = true;
+
+        // SACK is offered on an active open; with the peer's agreement, acks carry SACK blocks
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPConfig c{cfg};
+            c.fixed_isn = tx_isn;
+            TCPTestHarness test_1{c};
+            test_1.execute(Connect{});
+            test_1.execute(ExpectOneSegment{}.with_syn(true).with_sack_permitted(true));
+            test_1.execute(SendSegment{}
+                               .with_syn(true)
+                               .with_ack(true)
+                               .with_seqno(rx_isn)
+                               .with_ackno(tx_isn + 1)
+                               .with_win(1000)
+                               .with_sack_permitted(true));
+            test_1.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1).with_sack({}));
+            test_1.execute(ExpectState{State::ESTABLISHED});
+
+            auto send = [&](const size_t offset, string &&data) {
+                test_1.execute(SendSegment{}
+                                   .with_ack(true)
+                                   .with_ackno(tx_isn + 1)
+                                   .with_seqno(rx_isn + 1 + offset)
+                                   .with_win(1000)
+                                   .with_data(move(data)));
+            };
+            send(4, "efgh");
+            test_1.execute(ExpectOneSegment{}.with_ackno(rx_isn + 1).with_sack({{rx_isn + 5, rx_isn + 9}}));
+            send(12, "mnop");
+            test_1.execute(ExpectOneSegment{}.with_ackno(rx_isn + 1).with_sack(
+                {{rx_isn + 13, rx_isn + 17}, {rx_isn + 5, rx_isn + 9}}));
+            send(8, "ijkl");
+            test_1.execute(ExpectOneSegment{}.with_ackno(rx_isn + 1).with_sack({{rx_isn + 5, rx_isn + 17}}));
+            send(0, "abcd");
+            test_1.execute(ExpectOneSegment{}.with_ackno(rx_isn + 17).with_sack({}));
+            test_1.execute(ExpectData{}.with_data("abcdefghijklmnop"));
+        }
+
+        // data segments carry only the SACK blocks that fit beside their payloads under the MTU
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPConfig c{cfg};
+            c.fixed_isn = tx_isn;
+            TCPTestHarness test_5{c};
+            test_5.execute(Connect{});
+            test_5.execute(ExpectOneSegment{}.with_syn(true));
+            test_5.execute(SendSegment{}
+                               .with_syn(true)
+                               .with_ack(true)
+                               .with_seqno(rx_isn)
+                               .with_ackno(tx_isn + 1)
+                               .with_win(10000)
+                               .with_sack_permitted(true));
+            test_5.execute(ExpectOneSegment{}.with_ack(true));
+            for (const size_t offset : {2, 4}) {
+                test_5.execute(SendSegment{}
+                                   .with_ack(true)
+                                   .with_ackno(tx_isn + 1)
+                                   .with_seqno(rx_isn + 1 + offset)
+                                   .with_win(10000)
+                                   .with_data("x"));
+                test_5.execute(ExpectOneSegment{}.with_ackno(rx_isn + 1));
+            }
+            const size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+            const SackBlocks both{{rx_isn + 5, rx_isn + 6}, {rx_isn + 3, rx_isn + 4}};
+
+            test_5.execute(Write{string(MSS, 'a')});
+            test_5.execute(ExpectOneSegment{}.with_payload_size(MSS).with_sack({}),
+                           "test 5 failed: SACK blocks on a full-sized segment");
+            // one block takes 12 bytes (with its padding), and two take 20
+            test_5.execute(Write{string(MSS - 12, 'b')});
+            test_5.execute(ExpectOneSegment{}.with_payload_size(MSS - 12).with_sack({both.front()}));
+            test_5.execute(Write{string(MSS - 20, 'c')});
+            test_5.execute(ExpectOneSegment{}.with_payload_size(MSS - 20).with_sack(both));
+        }
+
+        // without the peer's agreement, no SACK blocks are sent
+        {
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_2 = TCPTestHarness::in_listen(cfg);
+            test_2.send_syn(rx_isn);
+            const TCPSegment syn_ack =
+                test_2.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true).with_sack_permitted(false));
+            test_2.send_ack(rx_isn + 1, syn_ack.header().seqno + 1, 1000);
+            test_2.execute(ExpectState{State::ESTABLISHED});
+            test_2.send_byte(rx_isn + 3, syn_ack.header().seqno + 1, 'c');
+            test_2.execute(ExpectOneSegment{}.with_ackno(rx_isn + 1).with_sack({}));
+        }
+
+        // a passive open agrees to SACK when the SYN offers it
+        {
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_3 = TCPTestHarness::in_listen(cfg);
+            test_3.execute(SendSegment{}.with_syn(true).with_seqno(rx_isn).with_win(1000).with_sack_permitted(true));
+            test_3.execute(ExpectOneSegment{}.with_syn(true).with_ack(true).with_sack_permitted(true));
+        }
+
+        // the scoreboard: after a fast retransmit of the first hole, further duplicate acks repair
+        // the holes that SACK blocks reveal, without waiting for a partial ack
+        {
+            TCPConfig c{cfg};
+            c.fast_retransmit = true;
+            c.congestion_control = CongestionControl::Algorithm::NewReno;
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            c.fixed_isn = tx_isn;
+            TCPTestHarness test_4{c};
+            test_4.execute(Connect{});
+            test_4.execute(ExpectOneSegment{}.with_syn(true).with_sack_permitted(true));
+            test_4.execute(SendSegment{}
+                               .with_syn(true)
+                               .with_ack(true)
+                               .with_seqno(rx_isn)
+                               .with_ackno(tx_isn + 1)
+                               .with_win(1000)
+                               .with_sack_permitted(true));
+            test_4.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1));
+
+            const vector<string> data{"aaaa", "bbbb", "cccc", "dddd", "eeee", "ffff"};
+            for (const auto &d : data) {
+                test_4.execute(Write{d});
+                test_4.execute(ExpectOneSegment{}.with_data(d));
+            }
+
+            // "bbbb" and "dddd" are lost
+            auto ack = [&](const SackBlocks &sack) {
+                test_4.execute(SendSegment{}
+                                   .with_ack(true)
+                                   .with_seqno(rx_isn + 1)
+                                   .with_ackno(tx_isn + 5)
+                                   .with_win(1000)
+                                   .with_sack(sack));
+            };
+            ack({});
+            test_4.execute(ExpectNoSegment{}, "test 4 failed: segment sent on new ack");
+            ack({{tx_isn + 9, tx_isn + 13}});
+            ack({{tx_isn + 17, tx_isn + 21}, {tx_isn + 9, tx_isn + 13}});
+            test_4.execute(ExpectNoSegment{}, "test 4 failed: fast retransmit too early");
+            ack({{tx_isn + 17, tx_isn + 25}, {tx_isn + 9, tx_isn + 13}});
+            test_4.execute(ExpectOneSegment{}.with_seqno(tx_isn + 5).with_data("bbbb"));
+            ack({{tx_isn + 17, tx_isn + 25}, {tx_isn + 9, tx_isn + 13}});
+            test_4.execute(ExpectOneSegment{}.with_seqno(tx_isn + 13).with_data("dddd"));
+            ack({{tx_isn + 17, tx_isn + 25}, {tx_isn + 9, tx_isn + 13}});
+            test_4.execute(ExpectNoSegment{}, "test 4 failed: SACKed segment retransmitted");
+
+            test_4.execute(SendSegment{}.with_ack(true).with_seqno(rx_isn + 1).with_ackno(tx_isn + 25).with_win(1000));
+            test_4.execute(ExpectNoSegment{}, "test 4 failed: retransmission after recovery");
+            test_4.execute(ExpectBytesInFlight{0});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
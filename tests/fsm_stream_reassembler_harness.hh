@@ -10,6 +10,7 @@
 #include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
 
 class ReassemblerExpectationViolation : public std::runtime_error {
   public:
@@ -103,6 +104,31 @@ struct UnassembledBytes : public ReassemblerExpectation {
     }
 };
 
+struct UnassembledRanges : public ReassemblerExpectation {
+    std::vector<std::pair<uint64_t, uint64_t>> _ranges;
+
+    UnassembledRanges(std::vector<std::pair<uint64_t, uint64_t>> ranges) : _ranges(std::move(ranges)) {}
+    std::string description() const {
+        std::ostringstream ss;
+        ss << "ranges not assembled =";
+        for (const auto &[start, end] : _ranges) {
+            ss << " [" << start << ", " << end << ")";
+        }
+        return ss.str();
+    }
+
+    void execute(StreamReassembler &reassembler) const {
+        if (reassembler.unassembled_ranges() != _ranges) {
+            std::ostringstream ss;
+            ss << "The reassembler was expected to have " << description() << ", but they were";
+            for (const auto &[start, end] : reassembler.unassembled_ranges()) {
+                ss << " [" << start << ", " << end << ")";
+            }
+            throw ReassemblerExpectationViolation(ss.str());
+        }
+    }
+};
+
 struct AtEof : public ReassemblerExpectation {
     AtEof() {}
     std::string description() const {
@@ -159,38 +185,61 @@ struct SubmitSegment : public ReassemblerAction {
     void execute(StreamReassembler &reassembler) const { reassembler.push_substring(_data, _index, _eof); }
 };
 
+//! \brief A kind of reassembler to test: how it tracks unassembled bytes, and how its stream stores bytes
+struct ReassemblerVariant {
+    const char *name;
+    StreamReassembler::Tracker tracker;
+    ByteStream::Storage storage;
+};
+
+//! Each StreamReassembler::Tracker, and each way of holding out-of-order bytes: staged in place in a
+//! Ring, Mirrored or Paged stream, or as Buffers for a Chunked one
+static constexpr ReassemblerVariant REASSEMBLER_VARIANTS[] = {
+    {"list", StreamReassembler::Tracker::List, ByteStream::Storage::Ring},
+    {"interval map", StreamReassembler::Tracker::IntervalMap, ByteStream::Storage::Ring},
+    {"bitmap", StreamReassembler::Tracker::Bitmap, ByteStream::Storage::Ring},
+    {"mirrored", StreamReassembler::Tracker::Bitmap, ByteStream::Storage::Mirrored},
+    {"chunked", StreamReassembler::Tracker::IntervalMap, ByteStream::Storage::Chunked},
+    {"paged", StreamReassembler::Tracker::IntervalMap, ByteStream::Storage::Paged}};
+
 class ReassemblerTestHarness {
-    StreamReassembler reassembler;
+    //! every step is run against a reassembler of each of REASSEMBLER_VARIANTS
+    std::vector<std::pair<std::string, StreamReassembler>> reassemblers;
     std::vector<std::string> steps_executed;
 
   public:
-    ReassemblerTestHarness(const size_t capacity) : reassembler(capacity), steps_executed() {
+    ReassemblerTestHarness(const size_t capacity) : reassemblers(), steps_executed() {
+        for (const auto &variant : REASSEMBLER_VARIANTS) {
+            reassemblers.emplace_back(variant.name, StreamReassembler{capacity, variant.storage, variant.tracker});
+        }
         steps_executed.emplace_back("Initialized (capacity = " + std::to_string(capacity) + ")");
     }
 
     void execute(const ReassemblerTestStep &step) {
-        try {
-            step.execute(reassembler);
-            steps_executed.emplace_back(step.to_string());
-        } catch (const ReassemblerExpectationViolation &e) {
-            std::cerr << "Test Failure on expectation:\n\t" << step.to_string();
-            std::cerr << "\n\nFailure message:\n\t" << e.what();
-            std::cerr << "\n\nList of steps that executed successfully:";
-            for (const std::string &s : steps_executed) {
-                std::cerr << "\n\t" << s;
-            }
-            std::cerr << std::endl << std::endl;
-            throw e;
-        } catch (const std::exception &e) {
-            std::cerr << "Test Failure on expectation:\n\t" << step.to_string();
-            std::cerr << "\n\nFailure message:\n\t" << e.what();
-            std::cerr << "\n\nList of steps that executed successfully:";
-            for (const std::string &s : steps_executed) {
-                std::cerr << "\n\t" << s;
+        for (auto &[name, reassembler] : reassemblers) {
+            try {
+                step.execute(reassembler);
+            } catch (const ReassemblerExpectationViolation &e) {
+                std::cerr << "Test Failure on expectation (" << name << " reassembler):\n\t" << step.to_string();
+                std::cerr << "\n\nFailure message:\n\t" << e.what();
+                std::cerr << "\n\nList of steps that executed successfully:";
+                for (const std::string &s : steps_executed) {
+                    std::cerr << "\n\t" << s;
+                }
+                std::cerr << std::endl << std::endl;
+                throw e;
+            } catch (const std::exception &e) {
+                std::cerr << "Test Failure on expectation (" << name << " reassembler):\n\t" << step.to_string();
+                std::cerr << "\n\nFailure message:\n\t" << e.what();
+                std::cerr << "\n\nList of steps that executed successfully:";
+                for (const std::string &s : steps_executed) {
+                    std::cerr << "\n\t" << s;
+                }
+                std::cerr << std::endl << std::endl;
+                throw ReassemblerExpectationViolation("The test caused your implementation to throw an exception!");
             }
-            std::cerr << std::endl << std::endl;
-            throw ReassemblerExpectationViolation("The test caused your implementation to throw an exception!");
         }
+        steps_executed.emplace_back(step.to_string());
     }
 };
 
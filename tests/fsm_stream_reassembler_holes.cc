@@ -5,6 +5,7 @@
 
 #include <exception>
 #include <iostream>
+#include <string>
 
 using namespace std;
 
@@ -131,6 +132,26 @@ int main() {
             test.execute(BytesAvailable(""));
             test.execute(AtEof{});
         }
+
+        {
+            ReassemblerTestHarness test{1000};
+
+            test.execute(UnassembledRanges({}));
+            test.execute(SubmitSegment{"bcd", 1});
+            test.execute(SubmitSegment{string(70, 'x'), 60});
+            test.execute(SubmitSegment{string(128, 'y'), 192});
+            test.execute(UnassembledRanges({{1, 4}, {60, 130}, {192, 320}}));
+
+            test.execute(SubmitSegment{string(62, 'z'), 130});
+            test.execute(UnassembledRanges({{1, 4}, {60, 320}}));
+
+            test.execute(SubmitSegment{"z", 999});
+            test.execute(UnassembledRanges({{1, 4}, {60, 320}, {999, 1000}}));
+
+            test.execute(SubmitSegment{"a", 0});
+            test.execute(BytesAssembled(4));
+            test.execute(UnassembledRanges({{60, 320}, {999, 1000}}));
+        }
     } catch (const exception &e) {
         cerr << "Exception: " << e.what() << endl;
         return EXIT_FAILURE;
@@ -1,4 +1,5 @@
 #include "byte_stream.hh"
+#include "fsm_stream_reassembler_harness.hh"
 #include "stream_reassembler.hh"
 #include "util.hh"
 
@@ -8,6 +9,7 @@
 #include <exception>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -26,34 +28,52 @@ int main() {
     try {
         auto rd = get_random_generator();
 
-        // overlapping segments
-        for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
-            StreamReassembler buf{NSEGS * MAX_SEG_LEN};
+        for (const auto &variant : REASSEMBLER_VARIANTS) {
+            // overlapping segments
+            for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
+                StreamReassembler buf{NSEGS * MAX_SEG_LEN, variant.storage, variant.tracker};
 
-            vector<tuple<size_t, size_t>> seq_size;
-            size_t offset = 0;
-            for (unsigned i = 0; i < NSEGS; ++i) {
-                const size_t size = 1 + (rd() % (MAX_SEG_LEN - 1));
-                const size_t offs = min(offset, 1 + (static_cast<size_t>(rd()) % 1023));
-                seq_size.emplace_back(offset - offs, size + offs);
-                offset += size;
-            }
-            shuffle(seq_size.begin(), seq_size.end(), rd);
+                vector<tuple<size_t, size_t>> seq_size;
+                size_t offset = 0;
+                for (unsigned i = 0; i < NSEGS; ++i) {
+                    const size_t size = 1 + (rd() % (MAX_SEG_LEN - 1));
+                    const size_t offs = min(offset, 1 + (static_cast<size_t>(rd()) % 1023));
+                    seq_size.emplace_back(offset - offs, size + offs);
+                    offset += size;
+                }
+                shuffle(seq_size.begin(), seq_size.end(), rd);
+
+                string d(offset, 0);
+                generate(d.begin(), d.end(), [&] { return rd(); });
 
-            string d(offset, 0);
-            generate(d.begin(), d.end(), [&] { return rd(); });
+                for (auto [off, sz] : seq_size) {
+                    string dd(d.cbegin() + off, d.cbegin() + off + sz);
+                    buf.push_substring(move(dd), off, off + sz == offset);
+                }
 
-            for (auto [off, sz] : seq_size) {
-                string dd(d.cbegin() + off, d.cbegin() + off + sz);
-                buf.push_substring(move(dd), off, off + sz == offset);
+                auto result = read(buf);
+                if (buf.stream_out().bytes_written() != offset) {  // read bytes
+                    throw runtime_error("test 2 - number of RX bytes is incorrect");
+                }
+                if (!equal(result.cbegin(), result.cend(), d.cbegin())) {
+                    throw runtime_error("test 2 - content of RX bytes is incorrect");
+                }
             }
+        }
 
-            auto result = read(buf);
-            if (buf.stream_out().bytes_written() != offset) {  // read bytes
-                throw runtime_error("test 2 - number of RX bytes is incorrect");
+        // bytes held out of order keep alive the whole Buffer they arrived in, and are counted that way
+        {
+            StreamReassembler buf{NSEGS * MAX_SEG_LEN, ByteStream::Storage::Chunked};
+            Buffer segment{string(64 * 1024, 'x')};
+            segment.remove_suffix(segment.size() - 10);
+            buf.push_substring(segment, 10, false);
+            if (buf.unassembled_bytes() != 10 or buf.footprint() < 64 * 1024) {
+                throw runtime_error("test 3 - footprint of held bytes is " + to_string(buf.footprint()));
             }
-            if (!equal(result.cbegin(), result.cend(), d.cbegin())) {
-                throw runtime_error("test 2 - content of RX bytes is incorrect");
+            buf.push_substring(string(10, 'y'), 0, false);
+            read(buf);
+            if (buf.footprint() >= 64 * 1024) {
+                throw runtime_error("test 3 - footprint stayed at " + to_string(buf.footprint()) + " once read");
             }
         }
     } catch (const exception &e) {
@@ -0,0 +1,88 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // with a 4000-byte buffer, the window opens in steps of min(MSS, 2000) = 1452 bytes
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPConfig cfg{};
+            cfg.recv_capacity = 4000;
+            cfg.sws_avoidance = true;
+            TCPTestHarness test_1 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+            auto send = [&](const size_t offset, const size_t len) {
+                test_1.execute(SendSegment{}
+                                   .with_ack(true)
+                                   .with_ackno(tx_isn + 1)
+                                   .with_seqno(rx_isn + 1 + offset)
+                                   .with_win(10000)
+                                   .with_data(string(len, 'x')));
+            };
+
+            send(0, 3000);
+            test_1.execute(ExpectOneSegment{}.with_ackno(rx_isn + 3001).with_win(1000));
+
+            // reading 1000 bytes would move the right edge by less than a step
+            test_1._fsm.inbound_stream().read(1000);
+            test_1.execute(Tick{1});
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: window update for a small step");
+            send(3000, 100);
+            test_1.execute(ExpectOneSegment{}.with_ackno(rx_isn + 3101).with_win(900),
+                           "test 1 failed: right edge moved by a small step");
+
+            // another 500 bytes make a full step, which is worth a window update
+            test_1._fsm.inbound_stream().read(500);
+            test_1.execute(Tick{1});
+            test_1.execute(ExpectOneSegment{}.with_ackno(rx_isn + 3101).with_win(2400).with_payload_size(0),
+                           "test 1 failed: no window update");
+            test_1.execute(Tick{1});
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: window update repeated");
+
+            // the edge never moves left
+            send(3100, 2400);
+            test_1.execute(ExpectOneSegment{}.with_ackno(rx_isn + 5501).with_win(0));
+        }
+
+        // without SWS avoidance, every byte read opens the window, and no updates are sent
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPConfig cfg{};
+            cfg.recv_capacity = 4000;
+            TCPTestHarness test_2 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+            auto send = [&](const size_t offset, const size_t len) {
+                test_2.execute(SendSegment{}
+                                   .with_ack(true)
+                                   .with_ackno(tx_isn + 1)
+                                   .with_seqno(rx_isn + 1 + offset)
+                                   .with_win(10000)
+                                   .with_data(string(len, 'x')));
+            };
+
+            send(0, 3000);
+            test_2.execute(ExpectOneSegment{}.with_ackno(rx_isn + 3001).with_win(1000));
+            test_2._fsm.inbound_stream().read(1000);
+            test_2.execute(Tick{1});
+            test_2.execute(ExpectNoSegment{});
+            send(3000, 100);
+            test_2.execute(ExpectOneSegment{}.with_ackno(rx_isn + 3101).with_win(1900));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
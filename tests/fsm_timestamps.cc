@@ -0,0 +1,247 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+using Timestamps = TCPHeader::Timestamps;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // the timestamps option survives serialization, and leaves room for three SACK blocks
+        {
+            TCPSegment seg;
+            seg.header().ack = true;
+            seg.header().timestamps = Timestamps{0xdeadbeef, 12345};
+            seg.header().sack = {{WrappingInt32{1}, WrappingInt32{2}},
+                                 {WrappingInt32{3}, WrappingInt32{4}},
+                                 {WrappingInt32{5}, WrappingInt32{6}}};
+            TCPSegment parsed;
+            if (parsed.parse(seg.serialize().concatenate()) != ParseResult::NoError or
+                parsed.header().timestamps != seg.header().timestamps or parsed.header().sack != seg.header().sack) {
+                throw runtime_error("timestamps did not survive serialization: " + parsed.header().summary());
+            }
+        }
+
+        TCPConfig cfg{};
+        cfg.timestamps = true;
+        cfg.adaptive_rto = true;
+        cfg.rto_min = 1;
+
+        // echoing, PAWS, and RTT samples from acks of retransmitted data
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPConfig c{cfg};
+            c.fixed_isn = tx_isn;
+            TCPTestHarness test_1{c};
+            test_1.execute(Connect{});
+            test_1.execute(ExpectOneSegment{}.with_syn(true).with_timestamps(Timestamps{0, 0}));
+            test_1.execute(Tick{10});
+            // a 10 ms sample: the timeout becomes 10 + 4 * 5 = 30 ms
+            test_1.execute(SendSegment{}
+                               .with_syn(true)
+                               .with_ack(true)
+                               .with_seqno(rx_isn)
+                               .with_ackno(tx_isn + 1)
+                               .with_win(1000)
+                               .with_timestamps(500, 0));
+            test_1.execute(ExpectState{State::ESTABLISHED});
+            test_1.execute(
+                ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1).with_timestamps(Timestamps{10, 500}));
+
+            auto send = [&](const size_t offset, string &&data, const uint32_t tsval, const uint32_t tsecr) {
+                test_1.execute(SendSegment{}
+                                   .with_ack(true)
+                                   .with_ackno(tx_isn + 1)
+                                   .with_seqno(rx_isn + 1 + offset)
+                                   .with_win(1000)
+                                   .with_timestamps(tsval, tsecr)
+                                   .with_data(move(data)));
+            };
+            send(0, "abc", 510, 10);
+            test_1.execute(ExpectOneSegment{}.with_ackno(rx_isn + 4).with_timestamps(Timestamps{10, 510}));
+
+            // an old duplicate, by its timestamp, is dropped and acked
+            send(3, "def", 400, 10);
+            test_1.execute(ExpectOneSegment{}.with_ackno(rx_isn + 4).with_timestamps(Timestamps{10, 510}));
+            test_1.execute(ExpectData{}.with_data("abc"));
+            test_1.execute(ExpectUnassembledBytes{0});
+            send(3, "def", 520, 10);
+            test_1.execute(ExpectOneSegment{}.with_ackno(rx_isn + 7).with_timestamps(Timestamps{10, 520}));
+            test_1.execute(ExpectData{}.with_data("def"));
+
+            // a segment without the option is dropped silently
+            test_1.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_ackno(tx_isn + 1)
+                               .with_seqno(rx_isn + 7)
+                               .with_win(1000)
+                               .with_data("ghi"));
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: segment without timestamps was acked");
+            test_1.execute(ExpectUnassembledBytes{0});
+
+            // retransmitted after 30 ms; the ack echoes the retransmission, giving a 50 ms sample
+            // that Karn's algorithm would have refused: the timeout becomes 15 + 4 * 13.75 = 70 ms
+            test_1.execute(Write{"x"});
+            test_1.execute(ExpectOneSegment{}.with_data("x").with_timestamps(Timestamps{10, 520}));
+            test_1.execute(Tick{30});
+            test_1.execute(ExpectOneSegment{}.with_data("x").with_timestamps(Timestamps{40, 520}));
+            test_1.execute(Tick{50});
+            test_1.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_ackno(tx_isn + 2)
+                               .with_seqno(rx_isn + 7)
+                               .with_win(1000)
+                               .with_timestamps(530, 40));
+            test_1.execute(ExpectBytesInFlight{0});
+
+            test_1.execute(Write{"y"});
+            test_1.execute(ExpectOneSegment{}.with_data("y").with_timestamps(Timestamps{90, 530}));
+            test_1.execute(Tick{69});
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: timeout not lengthened by the timestamp sample");
+            test_1.execute(Tick{1});
+            test_1.execute(ExpectOneSegment{}.with_data("y").with_timestamps(Timestamps{160, 530}));
+        }
+
+        // once agreed, the timestamps come out of the MSS, so that full-sized segments still fit the MTU
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPConfig c{cfg};
+            c.fixed_isn = tx_isn;
+            TCPTestHarness test_6{c};
+            test_6.execute(Connect{});
+            test_6.execute(ExpectOneSegment{}.with_syn(true));
+            test_6.execute(SendSegment{}
+                               .with_syn(true)
+                               .with_ack(true)
+                               .with_seqno(rx_isn)
+                               .with_ackno(tx_isn + 1)
+                               .with_win(10000)
+                               .with_timestamps(1, 0));
+            test_6.execute(ExpectOneSegment{}.with_ack(true));
+            const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE - TCPHeader::TIMESTAMPS_OPTION_LENGTH;
+            test_6.execute(Write{string(2 * mss, 'x')});
+            test_6.execute(ExpectSegment{}.with_seqno(tx_isn + 1).with_payload_size(mss));
+            test_6.execute(ExpectSegment{}.with_seqno(tx_isn + 1 + mss).with_payload_size(mss));
+        }
+
+        // the congestion window counts in segments of the reduced MSS, in slow start and after a timeout
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPConfig c{cfg};
+            c.fixed_isn = tx_isn;
+            c.adaptive_rto = false;
+            c.congestion_control = CongestionControl::Algorithm::NewReno;
+            TCPTestHarness test_7{c};
+            test_7.execute(Connect{});
+            test_7.execute(ExpectOneSegment{}.with_syn(true));
+            test_7.execute(SendSegment{}
+                               .with_syn(true)
+                               .with_ack(true)
+                               .with_seqno(rx_isn)
+                               .with_ackno(tx_isn + 1)
+                               .with_win(60000)
+                               .with_timestamps(1, 0));
+            test_7.execute(ExpectOneSegment{}.with_ack(true));
+            const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE - TCPHeader::TIMESTAMPS_OPTION_LENGTH;
+            test_7.execute(Write{string(20 * TCPConfig::MAX_PAYLOAD_SIZE, 'x')});
+            for (size_t i = 0; i < TCPConfig::INITIAL_CWND / TCPConfig::MAX_PAYLOAD_SIZE; i++) {
+                test_7.execute(ExpectSegment{}.with_seqno(tx_isn + 1 + i * mss).with_payload_size(mss));
+            }
+            test_7.execute(ExpectNoSegment{}, "test 7 failed: runt segment sent in slow start");
+
+            test_7.execute(Tick{c.rt_timeout});
+            test_7.execute(ExpectOneSegment{}.with_seqno(tx_isn + 1).with_payload_size(mss));
+            test_7.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(rx_isn + 1)
+                               .with_ackno(tx_isn + 1 + 10 * mss)
+                               .with_win(60000)
+                               .with_timestamps(2, 0));
+            test_7.execute(ExpectSegment{}.with_seqno(tx_isn + 1 + 10 * mss).with_payload_size(mss));
+            test_7.execute(ExpectSegment{}.with_seqno(tx_isn + 1 + 11 * mss).with_payload_size(mss));
+            test_7.execute(ExpectNoSegment{}, "test 7 failed: runt segment sent after a timeout");
+        }
+
+        // the peer doesn't offer timestamps, so none are sent
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPConfig c{cfg};
+            c.fixed_isn = tx_isn;
+            TCPTestHarness test_2{c};
+            test_2.execute(Connect{});
+            test_2.execute(ExpectOneSegment{}.with_syn(true).with_timestamps(Timestamps{0, 0}));
+            test_2.execute(
+                SendSegment{}.with_syn(true).with_ack(true).with_seqno(rx_isn).with_ackno(tx_isn + 1).with_win(10000));
+            test_2.execute(ExpectOneSegment{}.with_ack(true).with_timestamps(nullopt));
+            test_2.execute(Write{string(TCPConfig::MAX_PAYLOAD_SIZE, 'x')});
+            test_2.execute(ExpectOneSegment{}.with_payload_size(TCPConfig::MAX_PAYLOAD_SIZE),
+                           "test 2 failed: MSS reduced without timestamps");
+        }
+
+        // a passive open echoes the SYN's timestamp only if it had one
+        {
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_3 = TCPTestHarness::in_listen(cfg);
+            test_3.execute(SendSegment{}.with_syn(true).with_seqno(rx_isn).with_win(1000).with_timestamps(77, 0));
+            test_3.execute(ExpectOneSegment{}.with_syn(true).with_ack(true).with_timestamps(Timestamps{0, 77}));
+
+            TCPTestHarness test_4 = TCPTestHarness::in_listen(cfg);
+            test_4.execute(SendSegment{}.with_syn(true).with_seqno(rx_isn).with_win(1000));
+            test_4.execute(ExpectOneSegment{}.with_syn(true).with_ack(true).with_timestamps(nullopt));
+        }
+
+        // alongside timestamps, at most three SACK blocks are sent
+        {
+            TCPConfig c{cfg};
+            c.sack = true;
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_5 = TCPTestHarness::in_listen(c);
+            test_5.execute(SendSegment{}
+                               .with_syn(true)
+                               .with_seqno(rx_isn)
+                               .with_win(1000)
+                               .with_timestamps(1, 0)
+                               .with_sack_permitted(true));
+            const TCPSegment syn_ack = test_5.expect_seg(
+                ExpectOneSegment{}.with_syn(true).with_sack_permitted(true).with_timestamps(Timestamps{0, 1}));
+            const WrappingInt32 tx_isn = syn_ack.header().seqno;
+            for (unsigned i = 1; i <= 4; i++) {
+                test_5.execute(SendSegment{}
+                                   .with_ack(true)
+                                   .with_ackno(tx_isn + 1)
+                                   .with_seqno(rx_isn + 1 + 2 * i)
+                                   .with_win(1000)
+                                   .with_timestamps(1, 0)
+                                   .with_data("x"));
+                test_5.execute(ExpectOneSegment{}.with_ackno(rx_isn + 1));
+            }
+            test_5.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_ackno(tx_isn + 1)
+                               .with_seqno(rx_isn + 1 + 10)
+                               .with_win(1000)
+                               .with_timestamps(1, 0)
+                               .with_data("x"));
+            test_5.execute(ExpectOneSegment{}.with_ackno(rx_isn + 1).with_sack({{rx_isn + 11, rx_isn + 12},
+                                                                                {rx_isn + 3, rx_isn + 4},
+                                                                                {rx_isn + 5, rx_isn + 6}}));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
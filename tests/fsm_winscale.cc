@@ -0,0 +1,106 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // the window scale option survives serialization
+        {
+            TCPSegment seg;
+            seg.header().syn = true;
+            seg.header().window_scale = 7;
+            seg.header().sack_permitted = true;
+            TCPSegment parsed;
+            if (parsed.parse(seg.serialize().concatenate()) != ParseResult::NoError or
+                parsed.header().window_scale != optional<uint8_t>{7} or not parsed.header().sack_permitted) {
+                throw runtime_error("window scale did not survive serialization: " + parsed.header().summary());
+            }
+        }
+
+        TCPConfig cfg{};
+        cfg.window_scaling = true;
+        cfg.recv_capacity = 1 << 20;  // needs a shift of 5 to be advertised
+
+        // opens with the peer's shift and sends data into the scaled window
+        auto active_open = [&](const TCPConfig &c, const optional<uint8_t> peer_scale) {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPConfig config{c};
+            config.fixed_isn = tx_isn;
+            TCPTestHarness test{config};
+            test.execute(Connect{});
+            test.execute(ExpectOneSegment{}.with_syn(true).with_win(0xffff).with_window_scale(
+                c.window_scaling ? optional<uint8_t>{5} : nullopt));
+            SendSegment syn_ack{};
+            syn_ack.with_syn(true).with_ack(true).with_seqno(rx_isn).with_ackno(tx_isn + 1).with_win(1000);
+            if (peer_scale.has_value()) {
+                syn_ack.with_window_scale(peer_scale.value());
+            }
+            test.execute(syn_ack);
+            test.execute(ExpectState{State::ESTABLISHED});
+            const bool scaled = c.window_scaling and peer_scale.has_value();
+            test.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1).with_win(scaled ? 32768 : 0xffff));
+
+            // the window in the SYN-ACK was not scaled, but this one is
+            test.execute(SendSegment{}.with_ack(true).with_seqno(rx_isn + 1).with_ackno(tx_isn + 1).with_win(1000));
+            test.execute(Write{string(5000, 'x')});
+            return test;
+        };
+
+        // both sides scale
+        {
+            TCPTestHarness test_1 = active_open(cfg, 2);
+            test_1.execute(ExpectBytesInFlight{4000});
+        }
+
+        // the peer doesn't offer window scaling, so neither side scales
+        {
+            TCPTestHarness test_2 = active_open(cfg, nullopt);
+            test_2.execute(ExpectBytesInFlight{1000});
+        }
+
+        // off by default: the option is neither offered nor honoured
+        {
+            TCPConfig c{};
+            c.recv_capacity = cfg.recv_capacity;
+            TCPTestHarness test_3 = active_open(c, 2);
+            test_3.execute(ExpectBytesInFlight{1000});
+        }
+
+        // a passive open answers with its own shift only if the SYN offered one
+        {
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_4 = TCPTestHarness::in_listen(cfg);
+            test_4.execute(SendSegment{}.with_syn(true).with_seqno(rx_isn).with_win(1000).with_window_scale(3));
+            const TCPSegment syn_ack = test_4.expect_seg(
+                ExpectOneSegment{}.with_syn(true).with_ack(true).with_win(0xffff).with_window_scale(5));
+            const WrappingInt32 tx_isn = syn_ack.header().seqno;
+            test_4.execute(SendSegment{}.with_ack(true).with_seqno(rx_isn + 1).with_ackno(tx_isn + 1).with_win(500));
+            test_4.execute(ExpectState{State::ESTABLISHED});
+            test_4.execute(Write{string(5000, 'x')});
+            test_4.execute(ExpectBytesInFlight{4000});
+
+            TCPTestHarness test_5 = TCPTestHarness::in_listen(cfg);
+            test_5.execute(SendSegment{}.with_syn(true).with_seqno(rx_isn).with_win(1000));
+            test_5.execute(ExpectOneSegment{}.with_syn(true).with_ack(true).with_window_scale(nullopt));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
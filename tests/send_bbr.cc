@@ -0,0 +1,154 @@
+#include "congestion_control.hh"
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+static const Check check{"BBR"};
+
+struct ExpectBottleneckBandwidth : public SenderExpectation {
+    double _rate;
+
+    explicit ExpectBottleneckBandwidth(const double rate) : _rate(rate) {}
+
+    string description() const { return "bottleneck bandwidth " + to_string(_rate) + " bytes/ms"; }
+
+    void execute(TCPSender &sender, queue<TCPSegment> &) const {
+        const auto &bbr = dynamic_cast<const Bbr &>(sender.congestion_control());
+        if (abs(bbr.bottleneck_bandwidth() - _rate) > 0.01) {
+            ostringstream ss;
+            ss << "The TCPSender's BBR estimated a bottleneck bandwidth of " << bbr.bottleneck_bandwidth()
+               << ", but it was expected to be " << _rate;
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
+//! An ack that ends a round: `delivered` so far, and a delivery rate sampled from the previous round's end
+static AckSample round_ack(const uint64_t now, const uint64_t delivered, const uint64_t prior_delivered,
+                           const size_t bytes_in_flight, const double rate, const uint64_t rtt = 50) {
+    AckSample ack{delivered, delivered - prior_delivered, bytes_in_flight, now, rtt};
+    ack.delivery_rate = rate;
+    ack.delivered = delivered;
+    ack.prior_delivered = prior_delivered;
+    return ack;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::Bbr;
+
+            TCPSenderTestHarness test{"Delivery rates are sampled per ack", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+
+            // two segments delivered over 10 ms
+            test.execute(WriteBytes{string(2 * MSS, 'a')});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + MSS));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 2 * MSS}}.with_win(60000));
+            test.execute(ExpectBottleneckBandwidth{2 * MSS / 10.0});
+
+            // the application then sends too little to fill the path: a lower rate doesn't count
+            test.execute(WriteBytes{string(MSS, 'b')});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 2 * MSS));
+            test.execute(Tick{50});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 3 * MSS}}.with_win(60000));
+            test.execute(ExpectBottleneckBandwidth{2 * MSS / 10.0});
+        }
+
+        {
+            // a path of 100 bytes/ms and 50 ms: a BDP of 5000 bytes (and round trips a little longer)
+            Bbr cc{MSS, 10 * MSS};
+            check(cc.mode() == Bbr::Mode::Startup and not cc.pacing_rate().has_value(), "initial state");
+
+            uint64_t now = 0, delivered = 0;
+            auto next_round = [&](const size_t bytes_in_flight, const double rate = 100) {
+                const uint64_t prior = delivered;
+                now += 51;
+                delivered += 5000;
+                cc.on_ack(round_ack(now, delivered, prior, bytes_in_flight, rate));
+            };
+
+            next_round(20000);
+            check(cc.bottleneck_bandwidth() == 100, "the bandwidth should be the rate sampled");
+            check(abs(cc.pacing_rate().value() - Bbr::HIGH_GAIN * 10 * MSS / 50) < 0.01,
+                  "Startup should pace the initial window at HIGH_GAIN until the model gives a higher rate");
+
+            // three rounds without a quarter more bandwidth fill the pipe; Drain waits for the queue to go
+            next_round(20000);
+            next_round(20000);
+            check(cc.mode() == Bbr::Mode::Startup, "the pipe filled too soon");
+            next_round(20000);
+            check(cc.mode() == Bbr::Mode::Drain, "the pipe should be full");
+            check(abs(cc.pacing_rate().value() - 100 / Bbr::HIGH_GAIN) < 0.01, "Drain paces at 1 / HIGH_GAIN");
+            next_round(5000);
+            check(cc.mode() == Bbr::Mode::ProbeBW, "one BDP in flight should end Drain");
+            check(cc.pacing_rate().value() == 100, "ProbeBW cruises at the bandwidth");
+            check(cc.cwnd() <= 2 * 5000 + 3 * MSS, "the window is capped at twice the BDP");
+
+            // six cruising phases of an RTprop each, then probing at 1.25 until the extra data is in flight
+            for (size_t i = 0; i < 6; i++) {
+                next_round(5000);
+            }
+            check(cc.pacing_rate().value() == 125, "the gain cycle should probe for bandwidth");
+            next_round(5000);
+            check(cc.pacing_rate().value() == 125, "probing should go on until the extra data is in flight");
+            next_round(6250 + 3 * MSS);
+            check(cc.pacing_rate().value() == 75, "the gain cycle should drain after probing");
+            next_round(5000);
+            check(cc.pacing_rate().value() == 100, "draining should end once the queue is gone");
+
+            // a higher rate raises the estimate at once; it's forgotten after ten rounds
+            next_round(5000, 200);
+            check(cc.bottleneck_bandwidth() == 200, "a higher sample should raise the estimate");
+            for (size_t i = 0; i < Bbr::BW_FILTER_ROUNDS; i++) {
+                next_round(5000);
+            }
+            check(cc.bottleneck_bandwidth() == 100, "the higher sample should have left the window");
+
+            // a loss holds the window at what is in flight until the recovery point is acked
+            const size_t cwnd = cc.cwnd();
+            cc.on_loss(delivered + 5000, 3000);
+            check(cc.in_recovery() and cc.cwnd() == max(3000 + MSS, 4 * MSS), "a loss should conserve packets");
+            cc.on_ack(round_ack(now, delivered + 5000, delivered, 3000, 100));
+            check(not cc.in_recovery() and cc.cwnd() >= cwnd, "the window should be restored after recovery");
+            delivered += 5000;
+
+            // 10 s without a lower RTT: ProbeRTT drains the pipe down to four segments for 200 ms and a round
+            now += Bbr::RTPROP_FILTER_MS;
+            next_round(5000);
+            check(cc.mode() == Bbr::Mode::ProbeRTT, "a stale RTprop should start ProbeRTT");
+            check(cc.cwnd() == Bbr::MIN_CWND_SEGMENTS * MSS, "ProbeRTT should cap the window");
+            next_round(4 * MSS);
+            next_round(4 * MSS);
+            check(cc.mode() == Bbr::Mode::ProbeRTT, "ProbeRTT ended too soon");
+            now += Bbr::PROBE_RTT_MS;
+            next_round(4 * MSS);
+            check(cc.mode() == Bbr::Mode::ProbeBW, "ProbeRTT should return to ProbeBW");
+            check(cc.cwnd() >= cwnd, "the window should be restored after ProbeRTT");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
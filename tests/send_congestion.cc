@@ -0,0 +1,147 @@
+#include "congestion_control.hh"
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static const Check check{"NewReno"};
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+            cfg.initial_cwnd = 2 * MSS;
+
+            TCPSenderTestHarness test{"Slow start from the initial congestion window", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{2 * MSS});
+            test.execute(WriteBytes{string(6 * MSS, 'a')});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{2 * MSS});
+
+            // each ack grows the window by (at most) one segment
+            test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{3 * MSS});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 2 * MSS));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 3 * MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 3 * MSS}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{4 * MSS});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 4 * MSS));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 5 * MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{3 * MSS});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+            cfg.initial_cwnd = 3 * MSS;
+
+            TCPSenderTestHarness test{"The receiver's window still applies", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes{string(2 * MSS, 'a')});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT;
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+            cfg.initial_cwnd = 4 * MSS;
+
+            TCPSenderTestHarness test{"A timeout collapses the congestion window", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(4 * MSS, 'a')});
+            for (size_t i = 0; i < 4; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{retx_timeout});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{MSS}.with_ssthresh(2 * MSS));
+
+            // slow start back up to ssthresh...
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 4 * MSS}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{2 * MSS});
+            test.execute(WriteBytes{string(10 * MSS, 'b')});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 4 * MSS));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 5 * MSS));
+            test.execute(ExpectNoSegment{});
+
+            // ...then one segment per window's worth of acks
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 5 * MSS}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{2 * MSS});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 6 * MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 6 * MSS}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{3 * MSS});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 7 * MSS));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 8 * MSS));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            // fast recovery (RFC 6582), driven directly
+            NewReno cc{1000, 10000};
+            check(cc.cwnd() == 10000 and not cc.in_recovery(), "initial window");
+
+            cc.on_loss(20000, 10000);
+            check(cc.in_recovery(), "loss should start fast recovery");
+            check(cc.ssthresh() == 5000 and cc.cwnd() == 8000, "loss should halve the window");
+            cc.on_loss(20000, 9000);
+            check(cc.ssthresh() == 5000 and cc.cwnd() == 8000, "a second loss in one episode is ignored");
+
+            cc.on_duplicate_ack({11000, 0, 9000, 0});
+            check(cc.cwnd() == 9000, "duplicate acks inflate the window in recovery");
+
+            cc.on_ack({15000, 4000, 5000, 0});
+            check(cc.in_recovery(), "a partial ack keeps recovery going");
+            check(cc.cwnd() == 6000, "a partial ack deflates the window");
+
+            cc.on_ack({20000, 5000, 3000, 0});
+            check(not cc.in_recovery(), "acking the recovery point ends recovery");
+            check(cc.cwnd() == 4000, "the window after recovery is at most the flight size plus one segment");
+
+            cc.on_ack({21000, 1000, 3000, 0});
+            check(cc.cwnd() == 5000, "slow start below ssthresh");
+            for (size_t acked = 0; acked < 4000; acked += 1000) {
+                cc.on_ack({22000 + acked, 1000, 3000, 0});
+            }
+            check(cc.cwnd() == 5000, "congestion avoidance waits for a window's worth of acks");
+            cc.on_ack({26000, 1000, 3000, 0});
+            check(cc.cwnd() == 6000, "congestion avoidance grows by one segment per window");
+
+            cc.on_rto(6000);
+            check(cc.cwnd() == 1000 and cc.ssthresh() == 3000, "a timeout drops to one segment");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
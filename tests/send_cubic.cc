@@ -0,0 +1,98 @@
+#include "congestion_control.hh"
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static const Check check{"CUBIC"};
+
+//! Ack a window's worth of 1000-byte segments every `rtt` ms until `until` ms
+static void run_until(Cubic &cc, uint64_t &now, const uint64_t until, const uint64_t rtt) {
+    for (; now < until; now += rtt) {
+        for (size_t acked = 0; acked < cc.cwnd(); acked += 1000) {
+            cc.on_ack({0, 1000, cc.cwnd(), now, rtt});
+        }
+    }
+}
+
+//! A loss with `flight` bytes in flight, then the ack that ends recovery
+static void lose(Cubic &cc, const uint64_t now, const size_t flight) {
+    cc.on_loss(UINT64_MAX, flight);
+    cc.on_ack({UINT64_MAX, 1000, flight, now, {}});
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        {
+            const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT;
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::Cubic;
+            cfg.initial_cwnd = 10 * MSS;
+
+            TCPSenderTestHarness test{"A timeout reduces ssthresh by BETA", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(10 * MSS, 'a')});
+            for (size_t i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{retx_timeout});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectCongestionWindow{MSS}.with_ssthresh(7 * MSS));
+        }
+
+        {
+            // a loss at 1000 segments: the window drops to 700, and climbs back to 1000 in K = cbrt(300 / C) = 9.1 s
+            Cubic cc{1000, 10000};
+            uint64_t now = 0;
+            lose(cc, now, 1000000);
+            check(cc.ssthresh() == 700000 and cc.cwnd() == 700000, "a loss should reduce the window to 70%");
+
+            run_until(cc, now, 1000, 100);
+            const size_t after_1s = cc.cwnd();
+            run_until(cc, now, 5000, 100);
+            const size_t after_5s = cc.cwnd();
+            run_until(cc, now, 6000, 100);
+            check(after_1s - 700000 > cc.cwnd() - after_5s, "growth should slow towards W_max");
+            check(cc.cwnd() < 1000000, "W_max reached too soon");
+
+            run_until(cc, now, 9100, 100);
+            check(cc.cwnd() > 980000 and cc.cwnd() < 1020000, "the window should level off near W_max at K");
+            run_until(cc, now, 12100, 100);
+            check(cc.cwnd() > 1005000, "the window should grow again past W_max");
+
+            // fast convergence: losing again below W_max leaves W_max = 0.85 times the window, reached in 7 s
+            lose(cc, now, 900000);
+            check(cc.ssthresh() == 630000, "a second loss should reduce the window to 70%");
+            const uint64_t epoch = now;
+            run_until(cc, now, epoch + 7000, 100);
+            check(cc.cwnd() > 750000 and cc.cwnd() < 780000, "fast convergence should level off near 765 segments");
+        }
+
+        {
+            // with a short round trip, Reno would grow faster than the cubic function: follow it instead
+            Cubic cc{1000, 10000};
+            uint64_t now = 0;
+            lose(cc, now, 10000);
+            run_until(cc, now, 200, 1);
+            check(cc.cwnd() > 50000, "the Reno-friendly region should apply");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
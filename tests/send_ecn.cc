@@ -0,0 +1,84 @@
+#include "ipv4_header.hh"
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+//! Both sides have agreed to ECN (as TCPConnection would tell the sender)
+struct EnableEcn : public SenderAction {
+    string description() const { return "ECN agreed to"; }
+
+    void execute(TCPSender &sender, queue<TCPSegment> &) const { sender.set_ecn(true); }
+};
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+
+            TCPSenderTestHarness test{"An echo halves the window, once per window of data", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_ecn(IPv4Header::NOT_ECT));
+            test.execute(EnableEcn{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(10 * MSS, 'a')});
+            for (size_t i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_seqno(isn + 1 + i * MSS).with_ecn(IPv4Header::ECT_0).with_cwr(false));
+            }
+
+            // half of the 8 segments still in flight, and nothing retransmitted
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 2 * MSS}}.with_win(60000).with_ece(true));
+            test.execute(ExpectCongestionWindow{4 * MSS}.with_ssthresh(4 * MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 4 * MSS}}.with_win(60000).with_ece(true));
+            test.execute(ExpectCongestionWindow{4 * MSS}.with_ssthresh(4 * MSS));
+
+            // the next new data says the window was reduced
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 10 * MSS}}.with_win(60000));
+            test.execute(WriteBytes{string(2 * MSS, 'b')});
+            test.execute(ExpectSegment{}.with_seqno(isn + 1 + 10 * MSS).with_cwr(true));
+            test.execute(ExpectSegment{}.with_seqno(isn + 1 + 11 * MSS).with_cwr(false));
+
+            // retransmissions are not ECN-capable
+            test.execute(Tick{TCPConfig::TIMEOUT_DFLT});
+            test.execute(ExpectSegment{}.with_seqno(isn + 1 + 10 * MSS).with_ecn(IPv4Header::NOT_ECT).with_cwr(false));
+
+            // an echo for data sent after the reduction reduces the window again
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 12 * MSS}}.with_win(60000).with_ece(true));
+            test.execute(ExpectCongestionWindow{2 * MSS}.with_ssthresh(2 * MSS));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+
+            TCPSenderTestHarness test{"Without ECN, data isn't ECN-capable and echoes are ignored", cfg};
+            test.execute(ExpectSegment{}.with_syn(true));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(4 * MSS, 'a')});
+            for (size_t i = 0; i < 4; i++) {
+                test.execute(ExpectSegment{}.with_seqno(isn + 1 + i * MSS).with_ecn(IPv4Header::NOT_ECT));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 2 * MSS}}.with_win(60000).with_ece(true));
+            test.execute(ExpectCongestionWindow{11 * MSS});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
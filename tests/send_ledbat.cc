@@ -0,0 +1,136 @@
+#include "congestion_control.hh"
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+static const Check check{"LEDBAT"};
+
+struct ExpectQueueingDelay : public SenderExpectation {
+    uint64_t _delay;
+
+    explicit ExpectQueueingDelay(const uint64_t delay) : _delay(delay) {}
+
+    string description() const { return "queueing delay " + to_string(_delay) + " ms"; }
+
+    void execute(TCPSender &sender, queue<TCPSegment> &) const {
+        const auto &ledbat = dynamic_cast<const Ledbat &>(sender.congestion_control());
+        if (ledbat.queueing_delay() != _delay) {
+            ostringstream ss;
+            ss << "The TCPSender's LEDBAT estimated a queueing delay of " << ledbat.queueing_delay().value_or(0)
+               << " ms, but it was expected to be " << _delay << " ms";
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
+//! `n` acks of a 1000-byte segment each, all with round-trip time `rtt`, with the window full
+static void ack(Ledbat &cc, const uint64_t now, const uint64_t rtt, const size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        cc.on_ack({0, 1000, cc.cwnd() - 1000, now, rtt});
+    }
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::Ledbat;
+
+            TCPSenderTestHarness test{"Queueing delay is measured from the RTT samples", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{20});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(ExpectQueueingDelay{0});
+
+            // the current delay is the least of the last few samples, so one slow ack is not yet a queue
+            test.execute(WriteBytes{string(MSS, 'a')});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(Tick{50});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(60000));
+            test.execute(ExpectQueueingDelay{0});
+            for (size_t i = 1; i < Ledbat::CURRENT_FILTER; i++) {
+                test.execute(WriteBytes{string(MSS, 'a')});
+                test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+                test.execute(Tick{50});
+                test.execute(AckReceived{WrappingInt32{isn + 1 + (i + 1) * MSS}}.with_win(60000));
+            }
+            test.execute(ExpectQueueingDelay{30});
+        }
+
+        // slow start ends once the queueing delay reaches three quarters of the target
+        {
+            Ledbat cc{1000, 10000};
+            ack(cc, 0, 20, 4);
+            check(cc.cwnd() == 14000 and cc.ssthresh() > cc.cwnd(), "slow start ended without a queue");
+            ack(cc, 20, 40, Ledbat::CURRENT_FILTER);
+            check(cc.ssthresh() <= cc.cwnd(), "slow start didn't end at " + to_string(cc.queueing_delay().value()));
+        }
+
+        // under the target, the window grows by GAIN segments per round trip, scaled by how far under
+        {
+            Ledbat cc{1000, 20000};
+            cc.on_loss(UINT64_MAX, 40000);
+            cc.on_ack({UINT64_MAX, 1000, 20000, 0, 20});
+            check(cc.cwnd() == 20000, "recovery didn't end with a window of 20 segments");
+
+            // with no queue, a segment per round trip
+            ack(cc, 0, 20, 20);
+            check(cc.cwnd() == 21000, "the window grew to " + to_string(cc.cwnd()) + " with no queue");
+
+            // at four fifths of the target, a fifth of a segment per round trip
+            ack(cc, 100, 40, Ledbat::CURRENT_FILTER);
+            const size_t before = cc.cwnd();
+            ack(cc, 100, 40, 4 * 21);
+            check(cc.cwnd() == before, "the window grew by a segment within four round trips");
+            ack(cc, 200, 40, 21);
+            check(cc.cwnd() == before + 1000, "the window didn't grow by a segment in five round trips");
+        }
+
+        // over the target, the window shrinks in proportion to the excess, by at most half per round trip
+        {
+            Ledbat cc{1000, 20000};
+            cc.on_loss(UINT64_MAX, 40000);
+            cc.on_ack({UINT64_MAX, 1000, 20000, 0, 20});
+
+            // 50 ms over a 25 ms target: half the window in a round trip
+            ack(cc, 0, 20 + 2 * Ledbat::TARGET_MS, Ledbat::CURRENT_FILTER);
+            const size_t before = cc.cwnd();
+            ack(cc, 100, 20 + 2 * Ledbat::TARGET_MS, before / 1000);
+            check(cc.cwnd() == before - before / 2, "the window shrank to " + to_string(cc.cwnd()));
+
+            // but never below two segments
+            ack(cc, 200, 20 + 4 * Ledbat::TARGET_MS, 100);
+            check(cc.cwnd() == Ledbat::MIN_CWND_SEGMENTS * 1000, "the window shrank below the minimum");
+        }
+
+        // the base delay is the least over the last BASE_HISTORY minutes, so a route change is learned
+        {
+            Ledbat cc{1000, 10000};
+            ack(cc, 0, 20, 1);
+            ack(cc, 30000, 70, Ledbat::CURRENT_FILTER);
+            check(cc.queueing_delay() == 50, "a longer path was taken for a queue at first");
+            ack(cc, Ledbat::BASE_HISTORY * 60000 - 1, 70, 1);
+            check(cc.queueing_delay() == 50, "the base delay expired early");
+            ack(cc, Ledbat::BASE_HISTORY * 60000, 70, 1);
+            check(cc.queueing_delay() == 0, "the base delay didn't expire");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,105 @@
+#include "sender_harness.hh"
+#include "tcp_config.hh"
+#include "tcp_segment.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        // a large segment is cut into MSS-sized pieces with their own seqnos and checksums
+        {
+            string data(2 * mss + 96, 0);
+            for (auto &ch : data) {
+                ch = static_cast<char>(rd());
+            }
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32(rd());
+            seg.header().ack = true;
+            seg.header().psh = true;
+            seg.header().fin = true;
+            seg.payload() = Buffer{string(data)};
+
+            const auto pieces = seg.split(mss);
+            if (pieces.size() != 3) {
+                throw runtime_error("expected 3 pieces, got " + to_string(pieces.size()));
+            }
+            string joined;
+            for (size_t i = 0; i < pieces.size(); i++) {
+                const TCPSegment &piece = pieces[i];
+                const bool last = i + 1 == pieces.size();
+                TCPSegment parsed;
+                if (parsed.parse(piece.serialize(0).concatenate()) != ParseResult::NoError) {
+                    throw runtime_error("piece " + to_string(i) + " doesn't parse");
+                }
+                if (parsed.header().seqno != seg.header().seqno + joined.size() or not parsed.header().ack or
+                    parsed.header().fin != last or parsed.header().psh != last) {
+                    throw runtime_error("piece " + to_string(i) +
+                                        " has the wrong header: " + parsed.header().summary());
+                }
+                joined.append(parsed.payload().str());
+            }
+            if (joined != data or pieces[0].payload().size() != mss) {
+                throw runtime_error("the pieces don't hold the segment's payload");
+            }
+            if (seg.split(data.size()).size() != 1 or TCPSegment{}.split(mss).size() != 1) {
+                throw runtime_error("a small segment should be left whole");
+            }
+        }
+
+        auto sender = [&](const string &name, const WrappingInt32 isn) {
+            TCPConfig cfg;
+            cfg.fixed_isn = isn;
+            cfg.segmentation_offload = true;
+            cfg.send_capacity = 100 * mss;
+            TCPSenderTestHarness test{name, cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(0xffff));
+            return test;
+        };
+
+        {
+            const WrappingInt32 isn(rd());
+            TCPSenderTestHarness test = sender("Segments with offload span many MSS", isn);
+            test.execute(WriteBytes{string(50 * mss, 'x')});
+            test.execute(ExpectSegment{}
+                             .with_seqno(isn + 1)
+                             .with_payload_size(TCPConfig::MAX_OFFLOAD_PAYLOAD_SIZE)
+                             .with_max_payload_size(TCPConfig::MAX_OFFLOAD_PAYLOAD_SIZE));
+            test.execute(ExpectSegment{}.with_payload_size(0xffff - TCPConfig::MAX_OFFLOAD_PAYLOAD_SIZE));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{0xffff});
+        }
+
+        {
+            const WrappingInt32 isn(rd());
+            TCPSenderTestHarness test = sender("Retransmissions are of MSS-sized pieces", isn);
+            test.execute(WriteBytes{string(10 * mss, 'x')});
+            test.execute(
+                ExpectSegment{}.with_seqno(isn + 1).with_payload_size(10 * mss).with_max_payload_size(10 * mss));
+            test.execute(Tick{TCPConfig::TIMEOUT_DFLT});
+            test.execute(ExpectSegment{}.with_seqno(isn + 1).with_payload_size(mss));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + mss}}.with_win(0xffff));
+            test.execute(Tick{TCPConfig::TIMEOUT_DFLT});
+            test.execute(ExpectSegment{}.with_seqno(isn + 1 + mss).with_payload_size(mss));
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 10 * mss}}.with_win(0xffff));
+            test.execute(ExpectBytesInFlight{0});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,77 @@
+#include "sender_harness.hh"
+#include "tcp_config.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        // A 120 ms RTT and a 10-segment window in slow start: 2 * 14520 / 120 = 242 bytes per ms
+        auto paced_sender = [&](const string &name, const bool pacing) {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+            cfg.pacing = pacing;
+
+            TCPSenderTestHarness test{name, cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{120});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(0xffff));
+            test.execute(ExpectTimeUntilRelease{nullopt});
+            return test;
+        };
+
+        {
+            TCPSenderTestHarness test = paced_sender("Segments are released at the pacing rate", true);
+            test.execute(WriteBytes{string(10 * mss, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{2 * mss});
+            test.execute(ExpectTimeUntilRelease{1});
+
+            test.execute(Tick{5});
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+            test.execute(ExpectNoSegment{});
+            // 242 bytes in debt
+            test.execute(ExpectTimeUntilRelease{2});
+            test.execute(Tick{1});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPSenderTestHarness test = paced_sender("An idle sender can't save up pacing credit", true);
+            test.execute(Tick{1000});
+            test.execute(WriteBytes{string(10 * mss, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPSenderTestHarness test = paced_sender("Without pacing, the whole window is sent at once", false);
+            test.execute(WriteBytes{string(10 * mss, 'x')});
+            test.execute(ExpectBytesInFlight{10 * mss});
+            test.execute(ExpectTimeUntilRelease{nullopt});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,93 @@
+#include "sender_harness.hh"
+#include "tcp_config.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // probes every 100, 200, 400, 400... ms while the window stays closed
+        auto closed_window = [&](const string &name, const WrappingInt32 isn) {
+            TCPConfig cfg;
+            cfg.fixed_isn = isn;
+            cfg.persist_timer = true;
+            cfg.persist_timeout = 100;
+            cfg.persist_timeout_max = 400;
+
+            TCPSenderTestHarness test{name, cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(0));
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{99});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(1).with_data("a").with_seqno(isn + 1));
+            test.execute(ExpectBytesInFlight{1});
+            return test;
+        };
+
+        {
+            const WrappingInt32 isn(rd());
+            TCPSenderTestHarness test = closed_window("Zero-window probes back off", isn);
+            // the probe is refused; answers to it are not duplicate acks
+            for (unsigned i = 0; i < 4; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(0));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{199});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("a").with_seqno(isn + 1));
+            for (unsigned i = 0; i < 2 * TCPConfig::MAX_RETX_ATTEMPTS; i++) {
+                test.execute(Tick{399});
+                test.execute(ExpectNoSegment{});
+                test.execute(Tick{1}.with_max_retx_exceeded(false));
+                test.execute(ExpectSegment{}.with_data("a").with_seqno(isn + 1));
+            }
+
+            // the probe is accepted and the window opens
+            test.execute(AckReceived{WrappingInt32{isn + 2}}.with_win(1000));
+            test.execute(ExpectSegment{}.with_data("bc").with_seqno(isn + 2));
+            test.execute(Tick{400});
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            const WrappingInt32 isn(rd());
+            TCPSenderTestHarness test = closed_window("A probe left unacknowledged is retransmitted", isn);
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectSegment{}.with_data("bc").with_seqno(isn + 2));
+            test.execute(Tick{TCPConfig::TIMEOUT_DFLT - 1});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("a").with_seqno(isn + 1));
+        }
+
+        {
+            const WrappingInt32 isn(rd());
+            TCPSenderTestHarness test = closed_window("The persist timer restarts when the window closes again", isn);
+            test.execute(AckReceived{WrappingInt32{isn + 2}}.with_win(2));
+            test.execute(ExpectSegment{}.with_data("bc").with_seqno(isn + 2));
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(0));
+            test.execute(WriteBytes{"d"});
+            test.execute(Tick{99});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("d").with_seqno(isn + 4));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,115 @@
+#include "send_buffer.hh"
+#include "sender_harness.hh"
+#include "tcp_config.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        // slices within one pushed Buffer, across several, and after acknowledgments
+        {
+            SendBuffer buffer;
+            buffer.push(Buffer{"abcd"});
+            buffer.push(Buffer{"efgh"});
+            if (buffer.slice(2, 2).copy() != "bc" or buffer.slice(3, 4).copy() != "cdef" or
+                buffer.slice(1, 8).copy() != "abcdefgh") {
+                throw runtime_error("SendBuffer slices the wrong bytes");
+            }
+            buffer.acknowledge(3);
+            if (buffer.size() != 6 or buffer.slice(3, 6).copy() != "cdefgh") {
+                throw runtime_error("SendBuffer kept the wrong bytes after a partial acknowledgment");
+            }
+            buffer.acknowledge(10);  // the FIN
+            if (buffer.size() != 0 or buffer.end() != 10) {
+                throw runtime_error("SendBuffer kept bytes after everything was acknowledged");
+            }
+        }
+
+        // a byte awaiting acknowledgment keeps the whole of the Buffer it was read from alive
+        {
+            SendBuffer buffer;
+            Buffer chunk{string(64 * 1024, 'x')};
+            buffer.push(chunk);
+            buffer.acknowledge(chunk.size());
+            if (buffer.size() != 1 or buffer.footprint() < chunk.size()) {
+                throw runtime_error("SendBuffer footprint " + to_string(buffer.footprint()) + " for one byte");
+            }
+            buffer.acknowledge(chunk.size() + 1);
+            if (buffer.footprint() != 0) {
+                throw runtime_error("SendBuffer footprint " + to_string(buffer.footprint()) + " when empty");
+            }
+
+            TCPConfig cfg;
+            cfg.send_storage = ByteStream::Storage::Chunked;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.ack_received(wrap(1, sender.segments_out().front().header().seqno), 65000);
+            sender.stream_in().write(string(60000, 'x'));
+            sender.fill_window();
+            sender.ack_received(wrap(60000, sender.segments_out().front().header().seqno), 65000);
+            if (sender.bytes_in_flight() != 1 or sender.footprint() < 60000) {
+                throw runtime_error("TCPSender footprint " + to_string(sender.footprint()) + " for one byte in flight");
+            }
+        }
+
+        auto sender = [&](const string &name, const WrappingInt32 isn) {
+            TCPConfig cfg;
+            cfg.fixed_isn = isn;
+            cfg.repacketize = true;
+            TCPSenderTestHarness test{name, cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            return test;
+        };
+
+        {
+            const WrappingInt32 isn(rd());
+            TCPSenderTestHarness test = sender("Small segments are retransmitted as one", isn);
+            for (const string data : {"asdf", "qwer", "zxcv"}) {
+                test.execute(WriteBytes{string(data)});
+                test.execute(ExpectSegment{}.with_data(data));
+            }
+            test.execute(Tick{TCPConfig::TIMEOUT_DFLT});
+            test.execute(ExpectSegment{}.with_seqno(isn + 1).with_data("asdfqwerzxcv"));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 13}}.with_win(10000));
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            const WrappingInt32 isn(rd());
+            TCPSenderTestHarness test = sender("Merging stops at the MSS, and includes the FIN", isn);
+            test.execute(WriteBytes{string(mss - 2, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(mss - 2));
+            test.execute(WriteBytes{"ab"});
+            test.execute(ExpectSegment{}.with_data("ab"));
+            test.execute(WriteBytes{"c"}.with_end_input(true));
+            test.execute(ExpectSegment{}.with_data("c").with_fin(true));
+            test.execute(AckReceived{WrappingInt32{isn + mss - 2}}.with_win(10000));
+
+            // the first segment is acknowledged but for its last byte, so it's resent whole
+            test.execute(Tick{TCPConfig::TIMEOUT_DFLT});
+            test.execute(ExpectSegment{}.with_seqno(isn + 1).with_payload_size(mss));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + mss}}.with_win(10000));
+            test.execute(Tick{TCPConfig::TIMEOUT_DFLT});
+            test.execute(ExpectSegment{}.with_seqno(isn + 1 + mss).with_data("c").with_fin(true));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,122 @@
+#include "sender_harness.hh"
+#include "tcp_sender.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static const Check check{"RTTEstimator"};
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            RTTEstimator rtt{1000, 10, 60000};
+            check(not rtt.srtt().has_value() and rtt.rto() == 1000, "the initial timeout is used until a sample");
+
+            rtt.sample(50);
+            check(rtt.srtt() == 50.0 and rtt.rttvar() == 25.0, "the first sample sets SRTT = R and RTTVAR = R/2");
+            check(rtt.rto() == 150, "RTO = SRTT + 4 * RTTVAR");
+
+            rtt.sample(20);
+            check(rtt.srtt() == 46.25 and rtt.rttvar() == 26.25, "later samples are smoothed");
+            check(rtt.rto() == 152, "the timeout is rounded up to the clock granularity");
+
+            for (size_t i = 0; i < 100; i++) {
+                rtt.sample(0);
+            }
+            check(rtt.rto() == 10, "the timeout is at least rto_min");
+
+            RTTEstimator slow{1000, 10, 400};
+            slow.sample(300);
+            check(slow.rto() == 400, "the timeout is at most rto_max");
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.rto_min = 10;
+            cfg.rto_max = 400;
+
+            TCPSenderTestHarness test{"The retransmission timeout follows the measured RTT", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{50});
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            test.execute(WriteBytes{"abcd"});
+            test.execute(ExpectSegment{}.with_payload_size(4).with_seqno(isn + 1));
+            test.execute(Tick{149});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(4).with_seqno(isn + 1));
+
+            // backoff doubles the timeout, up to rto_max
+            test.execute(Tick{299});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(4).with_seqno(isn + 1));
+            test.execute(Tick{399});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(4).with_seqno(isn + 1));
+
+            // Karn: the ack of a retransmitted segment gives no sample, and the timeout is un-backed-off
+            test.execute(Tick{5});
+            test.execute(AckReceived{WrappingInt32{isn + 5}});
+            test.execute(WriteBytes{"efgh"});
+            test.execute(ExpectSegment{}.with_payload_size(4).with_seqno(isn + 5));
+            test.execute(Tick{149});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(4).with_seqno(isn + 5));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.rto_min = 10;
+
+            TCPSenderTestHarness test{"Short RTTs give short timeouts", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{2});
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            test.execute(WriteBytes{"abcd"});
+            test.execute(ExpectSegment{}.with_payload_size(4).with_seqno(isn + 1));
+            test.execute(Tick{9});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(4).with_seqno(isn + 1));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Without adaptive_rto the timeout stays fixed", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{2});
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            test.execute(WriteBytes{"abcd"});
+            test.execute(ExpectSegment{}.with_payload_size(4).with_seqno(isn + 1));
+            test.execute(Tick{cfg.rt_timeout - 1u});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(4).with_seqno(isn + 1));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
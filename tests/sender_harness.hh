@@ -29,6 +29,21 @@ class SenderExpectationViolation : public std::runtime_error {
     SenderExpectationViolation(const std::string msg) : std::runtime_error(msg) {}
 };
 
+//! \brief Checks a condition on the unit under test, outside of a TCPSenderTestHarness, and throws
+//! naming the unit (e.g., "CUBIC: loss should cut the window") if it doesn't hold
+class Check {
+    std::string _unit;
+
+  public:
+    explicit Check(const std::string &unit) : _unit(unit) {}
+
+    void operator()(const bool condition, const std::string &what) const {
+        if (not condition) {
+            throw SenderExpectationViolation{_unit + ": " + what};
+        }
+    }
+};
+
 class SegmentExpectationViolation : public SenderExpectationViolation {
   public:
     SegmentExpectationViolation(const std::string &msg) : SenderExpectationViolation(msg) {}
@@ -99,6 +114,60 @@ struct ExpectBytesInFlight : public SenderExpectation {
     }
 };
 
+struct ExpectCongestionWindow : public SenderExpectation {
+    size_t _cwnd;
+    std::optional<size_t> _ssthresh{};
+
+    ExpectCongestionWindow(size_t cwnd) : _cwnd(cwnd) {}
+
+    ExpectCongestionWindow &with_ssthresh(size_t ssthresh) {
+        _ssthresh = ssthresh;
+        return *this;
+    }
+
+    std::string description() const {
+        std::ostringstream ss;
+        ss << "congestion window " << _cwnd;
+        if (_ssthresh.has_value()) {
+            ss << " and ssthresh " << _ssthresh.value();
+        }
+        return ss.str();
+    }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        const CongestionControl &cc = sender.congestion_control();
+        if (cc.cwnd() != _cwnd or (_ssthresh.has_value() and cc.ssthresh() != _ssthresh.value())) {
+            std::ostringstream ss;
+            ss << "The TCPSender reported a congestion window of " << cc.cwnd() << " and ssthresh " << cc.ssthresh()
+               << ", but it was expected to be " << description();
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
+struct ExpectTimeUntilRelease : public SenderExpectation {
+    std::optional<uint64_t> _ms;
+
+    ExpectTimeUntilRelease(std::optional<uint64_t> ms) : _ms(ms) {}
+
+    std::string description() const {
+        return _ms.has_value() ? "next paced release in " + std::to_string(_ms.value()) + " ms"
+                               : "no paced release pending";
+    }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        if (sender.time_until_release() != _ms) {
+            std::ostringstream ss;
+            ss << "The TCPSender reported "
+               << (sender.time_until_release().has_value()
+                       ? "its next paced release in " + std::to_string(sender.time_until_release().value()) + " ms"
+                       : "no paced release pending")
+               << ", but it was expected to report " << description();
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
 struct ExpectNoSegment : public SenderExpectation {
     ExpectNoSegment() {}
     std::string description() const { return "no (more) segments"; }
@@ -191,11 +260,13 @@ struct Tick : public SenderAction {
 struct AckReceived : public SenderAction {
     WrappingInt32 _ackno;
     std::optional<uint16_t> _window_advertisement{};
+    bool _ece{false};
 
     AckReceived(WrappingInt32 ackno) : _ackno(ackno) {}
     std::string description() const {
         std::ostringstream ss;
-        ss << "ack " << _ackno.raw_value() << " winsize " << _window_advertisement.value_or(DEFAULT_TEST_WINDOW);
+        ss << "ack " << _ackno.raw_value() << " winsize " << _window_advertisement.value_or(DEFAULT_TEST_WINDOW)
+           << (_ece ? " with ECE" : "");
         return ss.str();
     }
 
@@ -204,7 +275,16 @@ struct AckReceived : public SenderAction {
         return *this;
     }
 
+    //! \brief The ack carries the ECN-echo flag
+    AckReceived &with_ece(bool ece) {
+        _ece = ece;
+        return *this;
+    }
+
     void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        if (_ece) {
+            sender.ecn_echo_received();
+        }
         sender.ack_received(_ackno, _window_advertisement.value_or(DEFAULT_TEST_WINDOW));
         sender.fill_window();
     }
@@ -230,6 +310,9 @@ struct ExpectSegment : public SenderExpectation {
     std::optional<uint16_t> win{};
     std::optional<size_t> payload_size{};
     std::optional<std::string> data{};
+    std::optional<bool> cwr{};
+    std::optional<uint8_t> ecn{};
+    size_t max_payload_size{TCPConfig::MAX_PAYLOAD_SIZE};
 
     ExpectSegment &with_ack(bool ack_) {
         ack = ack_;
@@ -288,6 +371,23 @@ struct ExpectSegment : public SenderExpectation {
         return *this;
     }
 
+    ExpectSegment &with_cwr(bool cwr_) {
+        cwr = cwr_;
+        return *this;
+    }
+
+    //! \param ecn_ the ECN codepoint the segment is to be sent with (see IPv4Header)
+    ExpectSegment &with_ecn(uint8_t ecn_) {
+        ecn = ecn_;
+        return *this;
+    }
+
+    //! \brief Allow a payload larger than the MSS (for segmentation offload)
+    ExpectSegment &with_max_payload_size(size_t max_payload_size_) {
+        max_payload_size = max_payload_size_;
+        return *this;
+    }
+
     std::string segment_description() const {
         std::ostringstream o;
         o << "(";
@@ -330,6 +430,12 @@ struct ExpectSegment : public SenderExpectation {
             }
             o << "\",";
         }
+        if (cwr.has_value()) {
+            o << (cwr.value() ? "CWR=1," : "CWR=0,");
+        }
+        if (ecn.has_value()) {
+            o << "ecn=" << +ecn.value() << ",";
+        }
         o << "...)";
         return o.str();
     }
@@ -367,7 +473,7 @@ struct ExpectSegment : public SenderExpectation {
             throw SegmentExpectationViolation::violated_field(
                 "payload_size", payload_size.value(), seg.payload().size());
         }
-        if (seg.payload().size() > TCPConfig::MAX_PAYLOAD_SIZE) {
+        if (seg.payload().size() > max_payload_size) {
             throw SegmentExpectationViolation("packet has length (" + std::to_string(seg.payload().size()) +
                                               ") greater than the maximum");
         }
@@ -375,6 +481,12 @@ struct ExpectSegment : public SenderExpectation {
             throw SegmentExpectationViolation("payloads differ. expected \"" + data.value() + "\" but found \"" +
                                               std::string(seg.payload().str()) + "\"");
         }
+        if (cwr.has_value() and seg.header().cwr != cwr.value()) {
+            throw SegmentExpectationViolation::violated_field("cwr", cwr.value(), seg.header().cwr);
+        }
+        if (ecn.has_value() and seg.ecn() != ecn.value()) {
+            throw SegmentExpectationViolation::violated_field("ecn", +ecn.value(), +seg.ecn());
+        }
     }
 };
 
@@ -394,7 +506,7 @@ class TCPSenderTestHarness {
   public:
     TCPSenderTestHarness(const std::string &name_, TCPConfig config)
         : outbound_segments()
-        , sender(config.send_capacity, config.rt_timeout, config.fixed_isn)
+        , sender(config)
         , steps_executed()
         , name(name_) {
         sender.fill_window();
@@ -11,6 +11,10 @@
 #include <exception>
 #include <optional>
 #include <sstream>
+#include <utility>
+#include <vector>
+
+using SackBlocks = std::vector<std::pair<WrappingInt32, WrappingInt32>>;
 
 struct TCPExpectation : public TCPTestStep {
     virtual ~TCPExpectation() {}
@@ -123,6 +127,12 @@ struct ExpectSegment : public TCPExpectation {
     std::optional<uint16_t> win{};
     std::optional<size_t> payload_size{};
     std::optional<std::string> data{};
+    std::optional<std::optional<uint8_t>> window_scale{};
+    std::optional<std::optional<TCPHeader::Timestamps>> timestamps{};
+    std::optional<bool> sack_permitted{};
+    std::optional<SackBlocks> sack{};
+    std::optional<bool> ece{};
+    std::optional<bool> cwr{};
 
     ExpectSegment &with_ack(bool ack_) {
         ack = ack_;
@@ -181,6 +191,38 @@ struct ExpectSegment : public TCPExpectation {
         return *this;
     }
 
+    //! \param window_scale_ the shift the window scale option should carry, or std::nullopt for no option
+    ExpectSegment &with_window_scale(std::optional<uint8_t> window_scale_) {
+        window_scale = window_scale_;
+        return *this;
+    }
+
+    //! \param timestamps_ the values the timestamps option should carry, or std::nullopt for no option
+    ExpectSegment &with_timestamps(std::optional<TCPHeader::Timestamps> timestamps_) {
+        timestamps = timestamps_;
+        return *this;
+    }
+
+    ExpectSegment &with_sack_permitted(bool sack_permitted_) {
+        sack_permitted = sack_permitted_;
+        return *this;
+    }
+
+    ExpectSegment &with_sack(SackBlocks sack_) {
+        sack = sack_;
+        return *this;
+    }
+
+    ExpectSegment &with_ece(bool ece_) {
+        ece = ece_;
+        return *this;
+    }
+
+    ExpectSegment &with_cwr(bool cwr_) {
+        cwr = cwr_;
+        return *this;
+    }
+
     std::string segment_description() const {
         std::ostringstream o;
         o << "(";
@@ -196,6 +238,12 @@ struct ExpectSegment : public TCPExpectation {
         if (fin.has_value()) {
             o << (fin.value() ? "F=1," : "F=0,");
         }
+        if (ece.has_value()) {
+            o << (ece.value() ? "E=1," : "E=0,");
+        }
+        if (cwr.has_value()) {
+            o << (cwr.value() ? "C=1," : "C=0,");
+        }
         if (ackno.has_value()) {
             o << "ackno=" << ackno.value() << ",";
         }
@@ -213,6 +261,32 @@ struct ExpectSegment : public TCPExpectation {
             append_data(o, data.value());
             o << ",";
         }
+        if (window_scale.has_value()) {
+            o << "wscale=";
+            if (window_scale.value().has_value()) {
+                o << +window_scale.value().value() << ",";
+            } else {
+                o << "none,";
+            }
+        }
+        if (timestamps.has_value()) {
+            o << "ts=";
+            if (timestamps.value().has_value()) {
+                o << timestamps.value()->tsval << "/" << timestamps.value()->tsecr << ",";
+            } else {
+                o << "none,";
+            }
+        }
+        if (sack_permitted.has_value()) {
+            o << (sack_permitted.value() ? "sack_permitted=1," : "sack_permitted=0,");
+        }
+        if (sack.has_value()) {
+            o << "sack=[";
+            for (const auto &[left, right] : sack.value()) {
+                o << left << "-" << right << ";";
+            }
+            o << "],";
+        }
         o << ")";
         return o.str();
     }
@@ -239,6 +313,12 @@ struct ExpectSegment : public TCPExpectation {
         if (fin.has_value() and seg.header().fin != fin.value()) {
             throw SegmentExpectationViolation::violated_field("fin", fin.value(), seg.header().fin);
         }
+        if (ece.has_value() and seg.header().ece != ece.value()) {
+            throw SegmentExpectationViolation::violated_field("ece", ece.value(), seg.header().ece);
+        }
+        if (cwr.has_value() and seg.header().cwr != cwr.value()) {
+            throw SegmentExpectationViolation::violated_field("cwr", cwr.value(), seg.header().cwr);
+        }
         if (seqno.has_value() and seg.header().seqno != seqno.value()) {
             throw SegmentExpectationViolation::violated_field("seqno", seqno.value(), seg.header().seqno);
         }
@@ -260,6 +340,19 @@ struct ExpectSegment : public TCPExpectation {
         if (data.has_value() and seg.payload().str() != *data) {
             throw SegmentExpectationViolation("payloads differ");
         }
+        if (window_scale.has_value() and seg.header().window_scale != window_scale.value()) {
+            throw SegmentExpectationViolation("window scale differs: the segment was " + seg.header().summary());
+        }
+        if (timestamps.has_value() and seg.header().timestamps != timestamps.value()) {
+            throw SegmentExpectationViolation("timestamps differ: the segment was " + seg.header().summary());
+        }
+        if (sack_permitted.has_value() and seg.header().sack_permitted != sack_permitted.value()) {
+            throw SegmentExpectationViolation::violated_field(
+                "sack_permitted", sack_permitted.value(), seg.header().sack_permitted);
+        }
+        if (sack.has_value() and seg.header().sack != sack.value()) {
+            throw SegmentExpectationViolation("SACK blocks differ: the segment was " + seg.header().summary());
+        }
         return seg;
     }
 
@@ -392,6 +485,13 @@ struct SendSegment : public TCPAction {
     uint16_t win{0};
     size_t payload_size{0};
     std::string data{};
+    std::optional<uint8_t> window_scale{};
+    std::optional<TCPHeader::Timestamps> timestamps{};
+    bool sack_permitted{false};
+    SackBlocks sack{};
+    bool ece{false};
+    bool cwr{false};
+    uint8_t ecn{IPv4Header::NOT_ECT};
 
     SendSegment() {}
 
@@ -404,6 +504,13 @@ struct SendSegment : public TCPAction {
         ackno = seg.header().ackno;
         win = seg.header().win;
         data = seg.payload();
+        window_scale = seg.header().window_scale;
+        timestamps = seg.header().timestamps;
+        sack_permitted = seg.header().sack_permitted;
+        sack = seg.header().sack;
+        ece = seg.header().ece;
+        cwr = seg.header().cwr;
+        ecn = seg.ecn();
     }
 
     SendSegment &with_ack(bool ack_) {
@@ -455,6 +562,42 @@ struct SendSegment : public TCPAction {
         return *this;
     }
 
+    SendSegment &with_window_scale(uint8_t window_scale_) {
+        window_scale = window_scale_;
+        return *this;
+    }
+
+    SendSegment &with_timestamps(uint32_t tsval, uint32_t tsecr) {
+        timestamps = TCPHeader::Timestamps{tsval, tsecr};
+        return *this;
+    }
+
+    SendSegment &with_sack_permitted(bool sack_permitted_) {
+        sack_permitted = sack_permitted_;
+        return *this;
+    }
+
+    SendSegment &with_sack(SackBlocks sack_) {
+        sack = sack_;
+        return *this;
+    }
+
+    SendSegment &with_ece(bool ece_) {
+        ece = ece_;
+        return *this;
+    }
+
+    SendSegment &with_cwr(bool cwr_) {
+        cwr = cwr_;
+        return *this;
+    }
+
+    //! \param ecn_ the ECN codepoint of the datagram the segment arrives in (see IPv4Header)
+    SendSegment &with_ecn(uint8_t ecn_) {
+        ecn = ecn_;
+        return *this;
+    }
+
     TCPSegment get_segment() const {
         TCPSegment data_seg;
         data_seg.payload() = std::string(data);
@@ -466,6 +609,13 @@ struct SendSegment : public TCPAction {
         data_hdr.ackno = ackno;
         data_hdr.seqno = seqno;
         data_hdr.win = win;
+        data_hdr.window_scale = window_scale;
+        data_hdr.timestamps = timestamps;
+        data_hdr.sack_permitted = sack_permitted;
+        data_hdr.sack = sack;
+        data_hdr.ece = ece;
+        data_hdr.cwr = cwr;
+        data_seg.ecn() = ecn;
         return data_seg;
     }
 